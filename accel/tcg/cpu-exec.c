@@ -46,6 +46,7 @@
 #include "tb-context.h"
 #include "tb-internal.h"
 #include "internal-common.h"
+#include "host/htm.h.inc"
 #if !defined(CONFIG_USER_ONLY)
 #include "accel/tcg/iommu.h"
 #endif
@@ -213,6 +214,36 @@ static TranslationBlock *tb_htable_lookup(CPUState *cpu, TCGTBCPUState s)
     return qht_lookup_custom(&tb_ctx.htable, &desc, h, tb_lookup_cmp);
 }
 
+static TranslationBlock *tb_jmp_l2_lookup(CPUJumpCache *jc, TCGTBCPUState s)
+{
+    CPUJumpCacheSet *set = &jc->l2[tb_jmp_l2_hash_func(s.pc)];
+
+    for (int i = 0; i < TB_JMP_L2_WAYS; i++) {
+        TranslationBlock *tb = qatomic_read(&set->way[i].tb);
+
+        if (tb &&
+            set->way[i].pc == s.pc &&
+            tb->cs_base == s.cs_base &&
+            tb->flags == s.flags &&
+            tb_cflags(tb) == s.cflags) {
+            qatomic_set(&jc->l2_hit_count, jc->l2_hit_count + 1);
+            return tb;
+        }
+    }
+    qatomic_set(&jc->l2_miss_count, jc->l2_miss_count + 1);
+    return NULL;
+}
+
+static void tb_jmp_l2_insert(CPUJumpCache *jc, vaddr pc, TranslationBlock *tb)
+{
+    CPUJumpCacheSet *set = &jc->l2[tb_jmp_l2_hash_func(pc)];
+    unsigned i = set->next;
+
+    set->next = (i + 1) % TB_JMP_L2_WAYS;
+    set->way[i].pc = pc;
+    qatomic_set(&set->way[i].tb, tb);
+}
+
 /**
  * tb_lookup:
  * @cpu: CPU that will execute the returned translation block
@@ -222,8 +253,8 @@ static TranslationBlock *tb_htable_lookup(CPUState *cpu, TCGTBCPUState s)
  * @cflags: CF_* flags
  *
  * Look up a translation block inside the QHT using @pc, @cs_base, @flags and
- * @cflags. Uses @cpu's tb_jmp_cache. Might cause an exception, so have a
- * longjmp destination ready.
+ * @cflags. Uses both levels of @cpu's tb_jmp_cache. Might cause an exception,
+ * so have a longjmp destination ready.
  *
  * Returns: an existing translation block or NULL.
  */
@@ -248,9 +279,13 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, TCGTBCPUState s)
         goto hit;
     }
 
-    tb = tb_htable_lookup(cpu, s);
+    tb = tb_jmp_l2_lookup(jc, s);
     if (tb == NULL) {
-        return NULL;
+        tb = tb_htable_lookup(cpu, s);
+        if (tb == NULL) {
+            return NULL;
+        }
+        tb_jmp_l2_insert(jc, s.pc, tb);
     }
 
     jc->array[hash].pc = s.pc;
@@ -549,11 +584,84 @@ static void cpu_exec_longjmp_cleanup(CPUState *cpu)
     assert_no_pages_locked();
 }
 
+/* Number of transaction attempts before falling back to start_exclusive */
+#define STEP_ATOMIC_HTM_TRIES  8
+
+/*
+ * Execute the serial TB for the insn at the current pc inside a host
+ * memory transaction.  A transaction that commits was atomic with
+ * respect to every other thread, exactly as if it had run inside
+ * start_exclusive(), but without stopping the other vCPUs.
+ * Return false if the caller must use the exclusive path instead.
+ */
+static bool cpu_exec_step_atomic_htm(CPUState *cpu, TCGTBCPUState s)
+{
+    TranslationBlock *tb;
+    int tries, tb_exit;
+    unsigned status;
+
+    if (sigsetjmp(cpu->jmp_env, 0) != 0) {
+        /*
+         * Fetching the code faulted.  The exclusive path will look the
+         * TB up again and raise the exception from there.
+         */
+        cpu_exec_longjmp_cleanup(cpu);
+        return false;
+    }
+
+    /* Translation is left to the exclusive path; the TB is then cached. */
+    tb = tb_lookup(cpu, s);
+    if (tb == NULL) {
+        return false;
+    }
+
+    cpu_exec_start(cpu);
+    for (tries = 0; tries < STEP_ATOMIC_HTM_TRIES; tries++) {
+        if (sigsetjmp(cpu->jmp_env, 0) != 0) {
+            /*
+             * The insn raised an exception within the transaction.
+             * Roll back to htm_begin and let the exclusive path raise it.
+             */
+            htm_abort();
+        }
+
+        status = htm_begin();
+        if (status == HTM_STARTED) {
+            /* Make cpu_in_serial_context() true for the helpers. */
+            cpu->exclusive_context_count++;
+            cpu_exec_enter(cpu);
+            cpu_tb_exec(cpu, tb, &tb_exit);
+            cpu_exec_exit(cpu);
+            cpu->exclusive_context_count--;
+            htm_end();
+
+            cpu_exec_end(cpu);
+            return true;
+        }
+        if (!htm_retry(status)) {
+            break;
+        }
+    }
+    cpu_exec_end(cpu);
+    return false;
+}
+
 void cpu_exec_step_atomic(CPUState *cpu)
 {
     TranslationBlock *tb;
     int tb_exit;
 
+    if (tcg_atomic_htm && htm_available()) {
+        TCGTBCPUState s = cpu->cc->tcg_ops->get_tb_cpu_state(cpu);
+
+        s.cflags = curr_cflags(cpu);
+        s.cflags &= ~CF_PARALLEL;
+        s.cflags |= CF_NO_GOTO_TB | CF_NO_GOTO_PTR | 1;
+        if (cpu_exec_step_atomic_htm(cpu, s)) {
+            return;
+        }
+    }
+
     if (sigsetjmp(cpu->jmp_env, 0) == 0) {
         start_exclusive();
         g_assert(cpu == current_cpu);
@@ -896,6 +1004,12 @@ static inline void cpu_loop_exec_tb(CPUState *cpu, TranslationBlock *tb,
     }
 
     *last_tb = NULL;
+#ifndef CONFIG_USER_ONLY
+    if (unlikely(qatomic_read(&cpu->tb_profile_pending))) {
+        qatomic_set(&cpu->tb_profile_pending, false);
+        tb_profile_record(log_pc(cpu, tb), tb);
+    }
+#endif
     if (cpu_loop_exit_requested(cpu)) {
         /* Something asked us to stop executing chained TBs; just
          * continue round the main loop. Whatever requested the exit
@@ -981,6 +1095,7 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
                 jc = cpu->tb_jmp_cache;
                 jc->array[h].pc = s.pc;
                 qatomic_set(&jc->array[h].tb, tb);
+                tb_jmp_l2_insert(jc, s.pc, tb);
             }
 
 #ifndef CONFIG_USER_ONLY
@@ -160,6 +160,15 @@ static void tb_jmp_cache_clear_page(CPUState *cpu, vaddr page_addr)
     for (i = 0; i < TB_JMP_PAGE_SIZE; i++) {
         qatomic_set(&jc->array[i0 + i].tb, NULL);
     }
+
+    i0 = tb_jmp_l2_hash_page(page_addr);
+    for (i = 0; i < TB_JMP_L2_PAGE_SIZE; i++) {
+        CPUJumpCacheSet *set = &jc->l2[i0 + i];
+
+        for (int j = 0; j < TB_JMP_L2_WAYS; j++) {
+            qatomic_set(&set->way[j].tb, NULL);
+        }
+    }
 }
 
 /**
@@ -283,8 +292,9 @@ static void tlb_mmu_flush_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast)
     desc->large_page_addr = -1;
     desc->large_page_mask = -1;
     desc->vindex = 0;
+    desc->lp_fill_addr = -1;
     memset(fast->table, -1, sizeof_tlb(fast));
-    memset(desc->vtable, -1, sizeof(desc->vtable));
+    memset(desc->vtable, -1, desc->vsize * sizeof(CPUTLBEntry));
 }
 
 static void tlb_flush_one_mmuidx_locked(CPUState *cpu, int mmu_idx,
@@ -306,6 +316,9 @@ static void tlb_mmu_init(CPUTLBDesc *desc, CPUTLBDescFast *fast, int64_t now)
     fast->mask = (n_entries - 1) << CPU_TLB_ENTRY_BITS;
     fast->table = g_new(CPUTLBEntry, n_entries);
     desc->fulltlb = g_new(CPUTLBEntryFull, n_entries);
+    desc->vsize = tlb_victim_size;
+    desc->vtable = g_new(CPUTLBEntry, desc->vsize);
+    desc->vfulltlb = g_new(CPUTLBEntryFull, desc->vsize);
     tlb_mmu_flush_locked(desc, fast);
 }
 
@@ -328,6 +341,9 @@ void tlb_init(CPUState *cpu)
 
     /* All tlbs are initialized flushed. */
     cpu->neg.tlb.c.dirty = 0;
+    cpu->neg.tlb.c.pending_queued = false;
+    cpu->neg.tlb.c.pending_full = 0;
+    cpu->neg.tlb.c.pending_count = 0;
 
     for (i = 0; i < NB_MMU_MODES; i++) {
         tlb_mmu_init(&cpu->neg.tlb.d[i], cpu_tlb_fast(cpu, i), now);
@@ -345,24 +361,88 @@ void tlb_destroy(CPUState *cpu)
 
         g_free(fast->table);
         g_free(desc->fulltlb);
+        g_free(desc->vtable);
+        g_free(desc->vfulltlb);
     }
 }
 
-/* flush_all_helper: run fn across all cpus
+static void tlb_flush_pending_async_work(CPUState *cpu, run_on_cpu_data data);
+
+/**
+ * tlb_queue_flush:
+ * @cpu: cpu on which to flush
+ * @addr: page aligned start of the range
+ * @len: length of the range
+ * @idxmap: set of mmu_idx to flush
+ * @bits: number of significant bits in address, or 0 for a full flush
  *
- * If the wait flag is set then the src cpu's helper will be queued as
- * "safe" work and the loop exited creating a synchronisation point
- * where all queued work will be finished before execution starts
- * again.
+ * Record a flush to be performed by @cpu the next time it processes
+ * its queued work.  Only the first request since the last drain queues
+ * work for @cpu; the rest are merged into the pending set, so that a
+ * storm of remote page flushes costs one async work item and one kick
+ * per destination rather than one per page.
  */
-static void flush_all_helper(CPUState *src, run_on_cpu_func fn,
-                             run_on_cpu_data d)
+static void tlb_queue_flush(CPUState *cpu, vaddr addr, vaddr len,
+                            MMUIdxMap idxmap, unsigned bits)
+{
+    CPUTLBCommon *c = &cpu->neg.tlb.c;
+    bool queue;
+
+    qemu_spin_lock(&c->lock);
+
+    queue = !c->pending_queued;
+    c->pending_queued = true;
+
+    idxmap &= ~c->pending_full;
+    if (idxmap == 0) {
+        /* Already covered by a pending full flush. */
+    } else if (bits == 0) {
+        c->pending_full |= idxmap;
+    } else {
+        CPUTLBPendingFlush *last = NULL;
+
+        if (c->pending_count) {
+            last = &c->pending[c->pending_count - 1];
+        }
+        if (last && last->idxmap == idxmap && last->bits == bits &&
+            last->addr + last->len == addr) {
+            last->len += len;
+        } else if (c->pending_count < CPU_TLB_PENDING_SIZE) {
+            last = &c->pending[c->pending_count++];
+            last->addr = addr;
+            last->len = len;
+            last->idxmap = idxmap;
+            last->bits = bits;
+        } else {
+            c->pending_full |= idxmap;
+        }
+    }
+
+    if (!queue) {
+        qatomic_set(&c->coalesce_flush_count, c->coalesce_flush_count + 1);
+    }
+
+    qemu_spin_unlock(&c->lock);
+
+    if (queue) {
+        async_run_on_cpu(cpu, tlb_flush_pending_async_work, RUN_ON_CPU_NULL);
+    }
+}
+
+/* flush_all_queued: queue a flush on all cpus except src
+ *
+ * The caller queues the src cpu's own flush as "safe" work, and the
+ * loop exited creates a synchronisation point where all queued work
+ * will be finished before execution starts again.
+ */
+static void flush_all_queued(CPUState *src, vaddr addr, vaddr len,
+                             MMUIdxMap idxmap, unsigned bits)
 {
     CPUState *cpu;
 
     CPU_FOREACH(cpu) {
         if (cpu != src) {
-            async_run_on_cpu(cpu, fn, d);
+            tlb_queue_flush(cpu, addr, len, idxmap, bits);
         }
     }
 }
@@ -427,7 +507,7 @@ void tlb_flush_by_mmuidx_all_cpus_synced(CPUState *src_cpu, MMUIdxMap idxmap)
 
     tlb_debug("mmu_idx: 0x%"PRIx16"\n", idxmap);
 
-    flush_all_helper(src_cpu, fn, RUN_ON_CPU_HOST_INT(idxmap));
+    flush_all_queued(src_cpu, 0, 0, idxmap, 0);
     async_safe_run_on_cpu(src_cpu, fn, RUN_ON_CPU_HOST_INT(idxmap));
 }
 
@@ -487,7 +567,7 @@ static void tlb_flush_vtlb_page_mask_locked(CPUState *cpu, int mmu_idx,
     int k;
 
     assert_cpu_is_self(cpu);
-    for (k = 0; k < CPU_VTLB_SIZE; k++) {
+    for (k = 0; k < d->vsize; k++) {
         if (tlb_flush_entry_mask_locked(&d->vtable[k], page, mask)) {
             tlb_n_used_entries_dec(cpu, mmu_idx);
         }
@@ -624,30 +704,19 @@ void tlb_flush_page_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
     /* This should already be page aligned */
     addr &= TARGET_PAGE_MASK;
 
+    flush_all_queued(src_cpu, addr, TARGET_PAGE_SIZE, idxmap,
+                     target_long_bits());
+
     /*
      * Allocate memory to hold addr+idxmap only when needed.
      * See tlb_flush_page_by_mmuidx for details.
      */
     if (idxmap < TARGET_PAGE_SIZE) {
-        flush_all_helper(src_cpu, tlb_flush_page_by_mmuidx_async_1,
-                         RUN_ON_CPU_TARGET_PTR(addr | idxmap));
         async_safe_run_on_cpu(src_cpu, tlb_flush_page_by_mmuidx_async_1,
                               RUN_ON_CPU_TARGET_PTR(addr | idxmap));
     } else {
-        CPUState *dst_cpu;
         TLBFlushPageByMMUIdxData *d;
 
-        /* Allocate a separate data block for each destination cpu.  */
-        CPU_FOREACH(dst_cpu) {
-            if (dst_cpu != src_cpu) {
-                d = g_new(TLBFlushPageByMMUIdxData, 1);
-                d->addr = addr;
-                d->idxmap = idxmap;
-                async_run_on_cpu(dst_cpu, tlb_flush_page_by_mmuidx_async_2,
-                                 RUN_ON_CPU_HOST_PTR(d));
-            }
-        }
-
         d = g_new(TLBFlushPageByMMUIdxData, 1);
         d->addr = addr;
         d->idxmap = idxmap;
@@ -764,6 +833,51 @@ static void tlb_flush_range_by_mmuidx_async_1(CPUState *cpu,
     g_free(d);
 }
 
+/*
+ * Drain the flushes accumulated by tlb_queue_flush.
+ * Called through async_run_on_cpu.
+ */
+static void tlb_flush_pending_async_work(CPUState *cpu, run_on_cpu_data data)
+{
+    CPUTLBCommon *c = &cpu->neg.tlb.c;
+    CPUTLBPendingFlush pending[CPU_TLB_PENDING_SIZE];
+    MMUIdxMap full;
+    unsigned i, n;
+
+    assert_cpu_is_self(cpu);
+
+    qemu_spin_lock(&c->lock);
+    full = c->pending_full;
+    n = c->pending_count;
+    memcpy(pending, c->pending, n * sizeof(pending[0]));
+    c->pending_full = 0;
+    c->pending_count = 0;
+    c->pending_queued = false;
+    qemu_spin_unlock(&c->lock);
+
+    if (full) {
+        tlb_flush_by_mmuidx_async_work(cpu, RUN_ON_CPU_HOST_INT(full));
+    }
+
+    for (i = 0; i < n; i++) {
+        TLBFlushRangeData d = {
+            .addr = pending[i].addr,
+            .len = pending[i].len,
+            .idxmap = pending[i].idxmap & ~full,
+            .bits = pending[i].bits,
+        };
+
+        if (d.idxmap == 0) {
+            continue;
+        }
+        if (d.len <= TARGET_PAGE_SIZE && d.bits >= target_long_bits()) {
+            tlb_flush_page_by_mmuidx_async_0(cpu, d.addr, d.idxmap);
+        } else {
+            tlb_flush_range_by_mmuidx_async_0(cpu, d);
+        }
+    }
+}
+
 void tlb_flush_range_by_mmuidx(CPUState *cpu, vaddr addr,
                                vaddr len, MMUIdxMap idxmap,
                                unsigned bits)
@@ -808,7 +922,6 @@ void tlb_flush_range_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
                                                unsigned bits)
 {
     TLBFlushRangeData d, *p;
-    CPUState *dst_cpu;
 
     /* If no page bits are significant, this devolves to tlb_flush. */
     if (bits < TARGET_PAGE_BITS) {
@@ -830,14 +943,7 @@ void tlb_flush_range_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
     d.idxmap = idxmap;
     d.bits = bits;
 
-    /* Allocate a separate data block for each destination cpu.  */
-    CPU_FOREACH(dst_cpu) {
-        if (dst_cpu != src_cpu) {
-            p = g_memdup(&d, sizeof(d));
-            async_run_on_cpu(dst_cpu, tlb_flush_range_by_mmuidx_async_1,
-                             RUN_ON_CPU_HOST_PTR(p));
-        }
-    }
+    flush_all_queued(src_cpu, d.addr, d.len, d.idxmap, d.bits);
 
     p = g_memdup(&d, sizeof(d));
     async_safe_run_on_cpu(src_cpu, tlb_flush_range_by_mmuidx_async_1,
@@ -932,7 +1038,7 @@ void tlb_reset_dirty(CPUState *cpu, uintptr_t start, uintptr_t length)
                                          start, length);
         }
 
-        for (i = 0; i < CPU_VTLB_SIZE; i++) {
+        for (i = 0; i < desc->vsize; i++) {
             tlb_reset_dirty_range_locked(&desc->vfulltlb[i], &desc->vtable[i],
                                          start, length);
         }
@@ -964,9 +1070,10 @@ static void tlb_set_dirty(CPUState *cpu, vaddr addr)
     }
 
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
         int k;
-        for (k = 0; k < CPU_VTLB_SIZE; k++) {
-            tlb_set_dirty1_locked(&cpu->neg.tlb.d[mmu_idx].vtable[k], addr);
+        for (k = 0; k < desc->vsize; k++) {
+            tlb_set_dirty1_locked(&desc->vtable[k], addr);
         }
     }
     qemu_spin_unlock(&cpu->neg.tlb.c.lock);
@@ -1045,6 +1152,13 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
         tlb_add_large_page(cpu, mmu_idx, addr, sz);
     }
     addr_page = addr & TARGET_PAGE_MASK;
+
+    /* Remember the translation of a guest huge page for reuse. */
+    if (full->lg_contig_size > TARGET_PAGE_BITS &&
+        full->lg_contig_size <= full->lg_page_size) {
+        desc->lp_fill_addr = addr_page;
+        desc->lp_fill = *full;
+    }
     paddr_page = full->phys_addr & TARGET_PAGE_MASK;
 
     prot = full->prot;
@@ -1078,6 +1192,7 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
     if (is_ram) {
         iotlb = memory_region_get_ram_addr(section->mr) + xlat;
         assert(!(iotlb & ~TARGET_PAGE_MASK));
+        working_set_record(iotlb);
         /*
          * Computing is_clean is expensive; avoid all that unless
          * the page is actually writable.
@@ -1129,7 +1244,7 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
      * different page; otherwise just overwrite the stale data.
      */
     if (!tlb_hit_page_anyprot(te, addr_page) && !tlb_entry_is_empty(te)) {
-        unsigned vidx = desc->vindex++ % CPU_VTLB_SIZE;
+        unsigned vidx = desc->vindex++ & (desc->vsize - 1);
         CPUTLBEntry *tv = &desc->vtable[vidx];
 
         /* Evict the old entry into the victim tlb.  */
@@ -1230,6 +1345,42 @@ static inline bool tlb_hit(uint64_t tlb_addr, vaddr addr)
     return tlb_hit_page(tlb_addr, addr & TARGET_PAGE_MASK);
 }
 
+/*
+ * Enter the page at @addr from the recorded fill of the guest huge page
+ * containing it, if any, avoiding another page table walk.  The access
+ * must be permitted by the recorded protection and must not be able to
+ * fault on alignment; all other cases are left to tlb_fill.
+ */
+static bool tlb_fill_from_large_page(CPUState *cpu, vaddr addr,
+                                     MMUAccessType type, int mmu_idx,
+                                     MemOp memop)
+{
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
+    CPUTLBEntryFull full;
+    vaddr page, lp_mask;
+
+    if (desc->lp_fill_addr == (vaddr)-1) {
+        return false;
+    }
+
+    page = addr & TARGET_PAGE_MASK;
+    lp_mask = -((vaddr)1 << desc->lp_fill.lg_contig_size);
+    if ((page ^ desc->lp_fill_addr) & lp_mask) {
+        return false;
+    }
+    if (!(desc->lp_fill.prot & (1 << type))) {
+        return false;
+    }
+    if (addr & ((1 << memop_tlb_alignment_bits(memop, true)) - 1)) {
+        return false;
+    }
+
+    full = desc->lp_fill;
+    full.phys_addr += page - desc->lp_fill_addr;
+    tlb_set_page_full(cpu, mmu_idx, page, &full);
+    return true;
+}
+
 /*
  * Note: tlb_fill_align() can trigger a resize of the TLB.
  * This means that all of the caller's prior references to the TLB table
@@ -1243,6 +1394,10 @@ static bool tlb_fill_align(CPUState *cpu, vaddr addr, MMUAccessType type,
     const TCGCPUOps *ops = cpu->cc->tcg_ops;
     CPUTLBEntryFull full;
 
+    if (tlb_fill_from_large_page(cpu, addr, type, mmu_idx, memop)) {
+        return true;
+    }
+
     if (ops->tlb_fill_align) {
         if (ops->tlb_fill_align(cpu, &full, addr, type, mmu_idx,
                                 memop, size, probe, ra)) {
@@ -1307,11 +1462,12 @@ static void io_failed(CPUState *cpu, CPUTLBEntryFull *full, vaddr addr,
 static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
                            MMUAccessType access_type, vaddr page)
 {
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
     size_t vidx;
 
     assert_cpu_is_self(cpu);
-    for (vidx = 0; vidx < CPU_VTLB_SIZE; ++vidx) {
-        CPUTLBEntry *vtlb = &cpu->neg.tlb.d[mmu_idx].vtable[vidx];
+    for (vidx = 0; vidx < desc->vsize; ++vidx) {
+        CPUTLBEntry *vtlb = &desc->vtable[vidx];
         uint64_t cmp = tlb_read_idx(vtlb, access_type);
 
         if (cmp == page) {
@@ -1324,8 +1480,8 @@ static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
             copy_tlb_helper_locked(vtlb, &tmptlb);
             qemu_spin_unlock(&cpu->neg.tlb.c.lock);
 
-            CPUTLBEntryFull *f1 = &cpu->neg.tlb.d[mmu_idx].fulltlb[index];
-            CPUTLBEntryFull *f2 = &cpu->neg.tlb.d[mmu_idx].vfulltlb[vidx];
+            CPUTLBEntryFull *f1 = &desc->fulltlb[index];
+            CPUTLBEntryFull *f2 = &desc->vfulltlb[vidx];
             CPUTLBEntryFull tmpf;
             tmpf = *f1; *f1 = *f2; *f2 = tmpf;
             return true;
@@ -1793,6 +1949,37 @@ static bool mmu_lookup(CPUState *cpu, vaddr addr, MemOpIdx oi,
     return crosspage;
 }
 
+/**
+ * mmu_lookup_contig: find a single host address for a page crossing access
+ * @l: result of mmu_lookup that returned true
+ * @bad_flags: tlb flags that preclude direct host access
+ *
+ * If both pages are plain host memory that happens to be contiguous,
+ * which is the common case for guest RAM, return the host address of
+ * the whole access so that it can be performed with one host operation
+ * rather than assembled bytewise.  This is only done when the MemOp
+ * places no atomicity requirement on subobjects of a page-crossing
+ * access; otherwise, or if the pages are discontiguous, return NULL.
+ */
+static void *mmu_lookup_contig(MMULookupLocals *l, int bad_flags)
+{
+    switch (l->memop & MO_ATOM_MASK) {
+    case MO_ATOM_IFALIGN:
+    case MO_ATOM_WITHIN16:
+    case MO_ATOM_NONE:
+        break;
+    default:
+        return NULL;
+    }
+    if (unlikely((l->page[0].flags | l->page[1].flags) & bad_flags)) {
+        return NULL;
+    }
+    if (l->page[0].haddr + l->page[0].size != l->page[1].haddr) {
+        return NULL;
+    }
+    return l->page[0].haddr;
+}
+
 /*
  * Probe for an atomic operation.  Do not allow unaligned operations,
  * or io operations to proceed.  Return the host address.
@@ -2332,6 +2519,7 @@ static uint32_t do_ld4_mmu(CPUState *cpu, vaddr addr, MemOpIdx oi,
     MMULookupLocals l;
     bool crosspage;
     uint32_t ret;
+    void *haddr;
 
     cpu_req_mo(cpu, TCG_MO_LD_LD | TCG_MO_ST_LD);
     crosspage = mmu_lookup(cpu, addr, oi, ra, access_type, &l);
@@ -2339,6 +2527,15 @@ static uint32_t do_ld4_mmu(CPUState *cpu, vaddr addr, MemOpIdx oi,
         return do_ld_4(cpu, &l.page[0], l.mmu_idx, access_type, l.memop, ra);
     }
 
+    haddr = mmu_lookup_contig(&l, TLB_MMIO);
+    if (haddr) {
+        ret = ldl_he_p(haddr);
+        if (l.memop & MO_BSWAP) {
+            ret = bswap32(ret);
+        }
+        return ret;
+    }
+
     ret = do_ld_beN(cpu, &l.page[0], 0, l.mmu_idx, access_type, l.memop, ra);
     ret = do_ld_beN(cpu, &l.page[1], ret, l.mmu_idx, access_type, l.memop, ra);
     if ((l.memop & MO_BSWAP) == MO_LE) {
@@ -2353,6 +2550,7 @@ static uint64_t do_ld8_mmu(CPUState *cpu, vaddr addr, MemOpIdx oi,
     MMULookupLocals l;
     bool crosspage;
     uint64_t ret;
+    void *haddr;
 
     cpu_req_mo(cpu, TCG_MO_LD_LD | TCG_MO_ST_LD);
     crosspage = mmu_lookup(cpu, addr, oi, ra, access_type, &l);
@@ -2360,6 +2558,15 @@ static uint64_t do_ld8_mmu(CPUState *cpu, vaddr addr, MemOpIdx oi,
         return do_ld_8(cpu, &l.page[0], l.mmu_idx, access_type, l.memop, ra);
     }
 
+    haddr = mmu_lookup_contig(&l, TLB_MMIO);
+    if (haddr) {
+        ret = ldq_he_p(haddr);
+        if (l.memop & MO_BSWAP) {
+            ret = bswap64(ret);
+        }
+        return ret;
+    }
+
     ret = do_ld_beN(cpu, &l.page[0], 0, l.mmu_idx, access_type, l.memop, ra);
     ret = do_ld_beN(cpu, &l.page[1], ret, l.mmu_idx, access_type, l.memop, ra);
     if ((l.memop & MO_BSWAP) == MO_LE) {
@@ -2730,6 +2937,7 @@ static void do_st4_mmu(CPUState *cpu, vaddr addr, uint32_t val,
 {
     MMULookupLocals l;
     bool crosspage;
+    void *haddr;
 
     cpu_req_mo(cpu, TCG_MO_LD_ST | TCG_MO_ST_ST);
     crosspage = mmu_lookup(cpu, addr, oi, ra, MMU_DATA_STORE, &l);
@@ -2738,6 +2946,15 @@ static void do_st4_mmu(CPUState *cpu, vaddr addr, uint32_t val,
         return;
     }
 
+    haddr = mmu_lookup_contig(&l, TLB_MMIO | TLB_DISCARD_WRITE);
+    if (haddr) {
+        if (l.memop & MO_BSWAP) {
+            val = bswap32(val);
+        }
+        stl_he_p(haddr, val);
+        return;
+    }
+
     /* Swap to little endian for simplicity, then store by bytes. */
     if ((l.memop & MO_BSWAP) != MO_LE) {
         val = bswap32(val);
@@ -2751,6 +2968,7 @@ static void do_st8_mmu(CPUState *cpu, vaddr addr, uint64_t val,
 {
     MMULookupLocals l;
     bool crosspage;
+    void *haddr;
 
     cpu_req_mo(cpu, TCG_MO_LD_ST | TCG_MO_ST_ST);
     crosspage = mmu_lookup(cpu, addr, oi, ra, MMU_DATA_STORE, &l);
@@ -2759,6 +2977,15 @@ static void do_st8_mmu(CPUState *cpu, vaddr addr, uint64_t val,
         return;
     }
 
+    haddr = mmu_lookup_contig(&l, TLB_MMIO | TLB_DISCARD_WRITE);
+    if (haddr) {
+        if (l.memop & MO_BSWAP) {
+            val = bswap64(val);
+        }
+        stq_he_p(haddr, val);
+        return;
+    }
+
     /* Swap to little endian for simplicity, then store by bytes. */
     if ((l.memop & MO_BSWAP) != MO_LE) {
         val = bswap64(val);
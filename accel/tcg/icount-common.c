@@ -37,6 +37,7 @@
 #include "hw/core/cpu.h"
 #include "exec/icount.h"
 #include "system/cpu-timers-internal.h"
+#include "internal-common.h"
 
 /*
  * ICOUNT: Instruction Counter
@@ -86,6 +87,12 @@ static void icount_update_locked(CPUState *cpu)
     int64_t executed = icount_get_executed(cpu);
     cpu->icount_budget -= executed;
 
+    if (tcg_icount_quantum) {
+        /* Published by icount_quantum_publish() at the quantum's end. */
+        cpu->icount_quantum_done += executed;
+        return;
+    }
+
     qatomic_set(&timers_state.qemu_icount,
                 timers_state.qemu_icount + executed);
 }
@@ -115,6 +122,14 @@ static int64_t icount_get_raw_locked(void)
         }
         /* Take into account what has run */
         icount_update_locked(cpu);
+        if (tcg_icount_quantum) {
+            /*
+             * Within a quantum each vCPU sees its own progress only,
+             * so that what it reads does not depend on the others.
+             */
+            return qatomic_read(&timers_state.qemu_icount) +
+                   cpu->icount_quantum_done;
+        }
     }
     /* The read is protected by the seqlock, but needs atomic to avoid UB */
     return qatomic_read(&timers_state.qemu_icount);
@@ -126,6 +141,27 @@ static int64_t icount_get_locked(void)
     return qatomic_read(&timers_state.qemu_icount_bias) + icount_to_ns(icount);
 }
 
+/*
+ * Add the instructions executed by all vCPUs during the icount quantum
+ * that just ended to the global instruction counter.
+ */
+void icount_quantum_publish(void)
+{
+    CPUState *cpu;
+    int64_t executed = 0;
+
+    seqlock_write_lock(&timers_state.vm_clock_seqlock,
+                       &timers_state.vm_clock_lock);
+    CPU_FOREACH(cpu) {
+        executed += cpu->icount_quantum_done;
+        cpu->icount_quantum_done = 0;
+    }
+    qatomic_set(&timers_state.qemu_icount,
+                timers_state.qemu_icount + executed);
+    seqlock_write_unlock(&timers_state.vm_clock_seqlock,
+                         &timers_state.vm_clock_lock);
+}
+
 int64_t icount_get_raw(void)
 {
     int64_t icount;
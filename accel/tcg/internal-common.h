@@ -10,6 +10,7 @@
 #define ACCEL_TCG_INTERNAL_COMMON_H
 
 #include "exec/cpu-common.h"
+#include "system/ram_addr.h"
 #include "exec/translation-block.h"
 #include "exec/mmap-lock.h"
 #include "accel/tcg/tb-cpu-state.h"
@@ -18,6 +19,12 @@ extern int64_t max_delay;
 extern int64_t max_advance;
 
 extern bool one_insn_per_tb;
+extern bool tb_evict_regions;
+extern unsigned tlb_victim_size;
+extern bool tcg_vcpu_pin;
+extern bool tcg_atomic_htm;
+extern unsigned tcg_icount_quantum;
+extern unsigned tcg_profile_hz;
 
 extern bool icount_align_option;
 
@@ -48,6 +55,8 @@ static inline bool cpu_plugin_mem_cbs_enabled(const CPUState *cpu)
 }
 
 TranslationBlock *tb_gen_code(CPUState *cpu, TCGTBCPUState s);
+void tb_make_room__exclusive_or_serial(void);
+void queue_tb_make_room(CPUState *cs);
 void page_init(void);
 void tb_htable_init(void);
 void tb_reset_jump(TranslationBlock *tb, int n);
@@ -142,4 +151,38 @@ void tb_set_jmp_target(TranslationBlock *tb, int n, uintptr_t addr);
 
 void tcg_get_stats(AccelState *accel, GString *buf);
 
+#ifndef CONFIG_USER_ONLY
+/**
+ * tb_profile_init - start the sampling TB profiler
+ * @hz: samples per second and per vCPU, 0 to leave the profiler off
+ */
+void tb_profile_init(unsigned hz);
+/**
+ * tb_profile_record - account one sample to a TB
+ * @pc: guest pc of the TB the vCPU was executing
+ * @tb: the TB itself
+ *
+ * Called from the vCPU thread when it leaves @tb on behalf of a
+ * sampling request.
+ */
+void tb_profile_record(vaddr pc, const TranslationBlock *tb);
+/**
+ * tb_profile_dump - print the collected profile to @buf
+ */
+void tb_profile_dump(GString *buf);
+
+/**
+ * working_set_init - start working set estimation
+ * @interval_ms: length of each measurement window, 0 to leave it off
+ */
+void working_set_init(unsigned interval_ms);
+/**
+ * working_set_record - mark a RAM page as accessed in the current window
+ * @addr: ram_addr_t of the page that was just added to a TLB
+ *
+ * Called from the vCPU thread, within an RCU critical section.
+ */
+void working_set_record(ram_addr_t addr);
+#endif
+
 #endif
@@ -51,6 +51,34 @@ static inline unsigned int tb_jmp_cache_hash_func(vaddr pc)
            | (tmp & TB_JMP_ADDR_MASK));
 }
 
+/*
+ * The second level uses the same split: the top bits of the set index
+ * depend only on the page, so that a page flush touches a subset of it.
+ */
+#define TB_JMP_L2_PAGE_BITS (TB_JMP_L2_SET_BITS / 2)
+#define TB_JMP_L2_PAGE_SIZE (1 << TB_JMP_L2_PAGE_BITS)
+#define TB_JMP_L2_ADDR_MASK (TB_JMP_L2_PAGE_SIZE - 1)
+#define TB_JMP_L2_PAGE_MASK (TB_JMP_L2_SETS - TB_JMP_L2_PAGE_SIZE)
+
+static inline unsigned int tb_jmp_l2_hash_page(vaddr pc)
+{
+    vaddr tmp;
+    tmp = pc ^ (pc >> (TARGET_PAGE_BITS - TB_JMP_L2_PAGE_BITS));
+    return (tmp >> (TARGET_PAGE_BITS - TB_JMP_L2_PAGE_BITS))
+           & TB_JMP_L2_PAGE_MASK;
+}
+
+static inline unsigned int tb_jmp_l2_hash_func(vaddr pc)
+{
+    /*
+     * Mix in higher bits of the in-page offset than the first level uses,
+     * so that pcs which conflict there are spread over different sets.
+     */
+    vaddr ofs = pc ^ (pc >> TB_JMP_PAGE_BITS);
+
+    return tb_jmp_l2_hash_page(pc) | (ofs & TB_JMP_L2_ADDR_MASK);
+}
+
 #else
 
 /* In user-mode we can get better hashing because we do not have a TLB */
@@ -59,6 +87,12 @@ static inline unsigned int tb_jmp_cache_hash_func(vaddr pc)
     return (pc ^ (pc >> TB_JMP_CACHE_BITS)) & (TB_JMP_CACHE_SIZE - 1);
 }
 
+static inline unsigned int tb_jmp_l2_hash_func(vaddr pc)
+{
+    return (pc ^ (pc >> TB_JMP_L2_SET_BITS) ^ (pc >> TB_JMP_CACHE_BITS))
+           & (TB_JMP_L2_SETS - 1);
+}
+
 #endif /* CONFIG_SOFTMMU */
 
 static inline
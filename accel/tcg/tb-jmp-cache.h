@@ -15,6 +15,16 @@
 #define TB_JMP_CACHE_BITS 12
 #define TB_JMP_CACHE_SIZE (1 << TB_JMP_CACHE_BITS)
 
+/*
+ * The second level of the jump cache is set-associative, and is probed
+ * when the direct-mapped first level misses, before falling back to the
+ * global qht.  It absorbs conflict misses in the first level without
+ * touching cache lines shared with other vCPUs.
+ */
+#define TB_JMP_L2_SET_BITS 9
+#define TB_JMP_L2_SETS (1 << TB_JMP_L2_SET_BITS)
+#define TB_JMP_L2_WAYS 4
+
 /*
  * Invalidated in parallel; all accesses to 'tb' must be atomic.
  * A valid entry is read/written by a single CPU, therefore there is
@@ -22,12 +32,27 @@
  * non-NULL value of 'tb'.  Strictly speaking pc is only needed for
  * CF_PCREL, but it's used always for simplicity.
  */
+typedef struct CPUJumpCacheEntry {
+    TranslationBlock *tb;
+    vaddr pc;
+} CPUJumpCacheEntry;
+
+/*
+ * The second level follows the same rules as the first.  The hit and
+ * miss counters are only written by the owning CPU, and are read
+ * atomically for statistics.
+ */
+typedef struct CPUJumpCacheSet {
+    CPUJumpCacheEntry way[TB_JMP_L2_WAYS];
+    unsigned next;
+} CPUJumpCacheSet;
+
 typedef struct CPUJumpCache {
     struct rcu_head rcu;
-    struct {
-        TranslationBlock *tb;
-        vaddr pc;
-    } array[TB_JMP_CACHE_SIZE];
+    CPUJumpCacheEntry array[TB_JMP_CACHE_SIZE];
+    CPUJumpCacheSet l2[TB_JMP_L2_SETS];
+    size_t l2_hit_count;
+    size_t l2_miss_count;
 } CPUJumpCache;
 
 #endif /* ACCEL_TCG_TB_JMP_CACHE_H */
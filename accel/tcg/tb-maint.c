@@ -808,6 +808,26 @@ void queue_tb_flush(CPUState *cs)
     }
 }
 
+static unsigned tb_make_room_count(void)
+{
+    return qatomic_read(&tb_ctx.tb_flush_count) +
+           qatomic_read(&tb_ctx.tb_reclaim_count);
+}
+
+static void do_tb_make_room(CPUState *cpu, run_on_cpu_data count)
+{
+    /* If room has already been made on request of another CPU, retry. */
+    if (tb_make_room_count() == count.host_int) {
+        tb_make_room__exclusive_or_serial();
+    }
+}
+
+void queue_tb_make_room(CPUState *cs)
+{
+    async_safe_run_on_cpu(cs, do_tb_make_room,
+                          RUN_ON_CPU_HOST_INT(tb_make_room_count()));
+}
+
 /* remove @orig from its @n_orig-th jump list */
 static inline void tb_remove_from_jmp_list(TranslationBlock *orig, int n_orig)
 {
@@ -903,23 +923,43 @@ static void tb_jmp_cache_inval_tb(TranslationBlock *tb)
         }
     } else {
         uint32_t h = tb_jmp_cache_hash_func(tb->pc);
+        uint32_t h2 = tb_jmp_l2_hash_func(tb->pc);
 
         CPU_FOREACH(cpu) {
             CPUJumpCache *jc = cpu->tb_jmp_cache;
+            CPUJumpCacheSet *set = &jc->l2[h2];
 
             if (qatomic_read(&jc->array[h].tb) == tb) {
                 qatomic_set(&jc->array[h].tb, NULL);
             }
+            for (int i = 0; i < TB_JMP_L2_WAYS; i++) {
+                if (qatomic_read(&set->way[i].tb) == tb) {
+                    qatomic_set(&set->way[i].tb, NULL);
+                }
+            }
         }
     }
 }
 
+static void tb_unlink_jumps(TranslationBlock *tb)
+{
+    /* suppress this TB from the two jump lists */
+    tb_remove_from_jmp_list(tb, 0);
+    tb_remove_from_jmp_list(tb, 1);
+
+    /* suppress any remaining jumps to this TB */
+    tb_jmp_unlink(tb);
+}
+
 /*
  * In user-mode, call with mmap_lock held.
  * In !user-mode, if @rm_from_page_list is set, call with the TB's pages'
  * locks held.
+ * Without @flush_jmp_cache, the caller flushes the jump caches of all
+ * CPUs once it has invalidated a batch of TBs.
  */
-static void do_tb_phys_invalidate(TranslationBlock *tb, bool rm_from_page_list)
+static void do_tb_phys_invalidate(TranslationBlock *tb, bool rm_from_page_list,
+                                  bool flush_jmp_cache)
 {
     uint32_t h;
     tb_page_addr_t phys_pc;
@@ -945,14 +985,11 @@ static void do_tb_phys_invalidate(TranslationBlock *tb, bool rm_from_page_list)
         }
 
         /* remove the TB from the hash list */
-        tb_jmp_cache_inval_tb(tb);
-
-        /* suppress this TB from the two jump lists */
-        tb_remove_from_jmp_list(tb, 0);
-        tb_remove_from_jmp_list(tb, 1);
+        if (flush_jmp_cache) {
+            tb_jmp_cache_inval_tb(tb);
+        }
 
-        /* suppress any remaining jumps to this TB */
-        tb_jmp_unlink(tb);
+        tb_unlink_jumps(tb);
 
         qatomic_set(&tb_ctx.tb_phys_invalidate_count,
                     tb_ctx.tb_phys_invalidate_count + 1);
@@ -969,11 +1006,59 @@ void tb_phys_invalidate(TranslationBlock *tb, tb_page_addr_t page_addr)
 {
     if (page_addr == -1 && tb_page_addr0(tb) != -1) {
         tb_lock_pages(tb);
-        do_tb_phys_invalidate(tb, true);
+        do_tb_phys_invalidate(tb, true, true);
         tb_unlock_pages(tb);
     } else {
-        do_tb_phys_invalidate(tb, false);
+        do_tb_phys_invalidate(tb, false, true);
+    }
+}
+
+static gboolean tb_reclaim_iter(gpointer key, gpointer value, gpointer data)
+{
+    TranslationBlock *tb = value;
+
+    if (tb_page_addr0(tb) != -1) {
+        tb_lock_pages(tb);
+        do_tb_phys_invalidate(tb, true, false);
+        tb_unlock_pages(tb);
+        return false;
+    }
+
+    /*
+     * A temporary one-insn TB is not in the hash table, but it can be
+     * in the jump caches and linked to from other TBs.
+     */
+    qemu_thread_jit_write();
+    qemu_spin_lock(&tb->jmp_lock);
+    qatomic_set(&tb->cflags, tb->cflags | CF_INVALID);
+    qemu_spin_unlock(&tb->jmp_lock);
+    tb_unlink_jumps(tb);
+    qemu_thread_jit_execute();
+    return false;
+}
+
+/*
+ * Make room in code_gen_buffer once tcg_tb_alloc has failed.  With
+ * tb-evict, invalidate only the TBs of the oldest full region and
+ * reuse it; flush everything if there is no such region.  The jump
+ * caches are flushed once after the region is done rather than for
+ * each TB, which would flush them for every CF_PCREL TB.
+ *
+ * User-mode has a single region, which is always in use, so it never
+ * gets here without mmap_lock and reaches tb_phys_invalidate.
+ */
+void tb_make_room__exclusive_or_serial(void)
+{
+    CPUState *cpu;
+
+    if (tb_evict_regions && tcg_region_reclaim(tb_reclaim_iter, NULL)) {
+        CPU_FOREACH(cpu) {
+            tcg_flush_jmp_cache(cpu);
+        }
+        qatomic_inc(&tb_ctx.tb_reclaim_count);
+        return;
     }
+    tb_flush__exclusive_or_serial();
 }
 
 /*
@@ -1026,7 +1111,7 @@ void tb_invalidate_phys_range(CPUState *cpu, tb_page_addr_t start,
     assert_memory_lock();
 
     PAGE_FOR_EACH_TB(start, last, unused, tb, n) {
-        do_tb_phys_invalidate(tb, true);
+        do_tb_phys_invalidate(tb, true, true);
     }
 }
 
@@ -1087,7 +1172,7 @@ bool tb_invalidate_phys_page_unwind(CPUState *cpu, tb_page_addr_t addr,
             current_tb_modified = true;
             cpu_restore_state_from_tb(cpu, current_tb, pc);
         }
-        do_tb_phys_invalidate(tb, true);
+        do_tb_phys_invalidate(tb, true, true);
     }
 
     if (current_tb_modified) {
@@ -1152,7 +1237,7 @@ tb_invalidate_phys_page_range__locked(CPUState *cpu,
                 current_tb_modified = true;
                 cpu_restore_state_from_tb(cpu, current_tb, retaddr);
             }
-            do_tb_phys_invalidate(tb, true);
+            do_tb_phys_invalidate(tb, true, true);
         }
     }
 
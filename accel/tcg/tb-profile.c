@@ -0,0 +1,141 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ *  QEMU TCG sampling TB profiler
+ *
+ * A realtime timer periodically asks every running vCPU to leave the
+ * TB it is executing through the TB_EXIT_REQUESTED path, the same one
+ * cpu_exit() uses.  The vCPU thread then accounts one sample to that
+ * TB.  Nothing is added to the generated code, so the overhead is
+ * bounded by the sampling rate.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/atomic.h"
+#include "qemu/thread.h"
+#include "qemu/timer.h"
+#include "exec/replay-core.h"
+#include "exec/translation-block.h"
+#include "hw/core/cpu.h"
+#include "internal-common.h"
+
+/* Number of entries printed by tb_profile_dump() */
+#define TB_PROFILE_DUMP_MAX 32
+
+typedef struct TBProfileEntry {
+    vaddr pc;
+    uint64_t samples;
+    uint16_t icount;
+    uint32_t host_size;
+} TBProfileEntry;
+
+static QEMUTimer *tb_profile_timer;
+static int64_t tb_profile_period_ns;
+static QemuMutex tb_profile_lock;
+static GHashTable *tb_profile_table;
+static uint64_t tb_profile_total;
+
+static void tb_profile_tick(void *opaque)
+{
+    CPUState *cpu;
+
+    if (replay_mode == REPLAY_MODE_NONE) {
+        CPU_FOREACH(cpu) {
+            if (cpu->halted || cpu->stopped) {
+                continue;
+            }
+            qatomic_set(&cpu->tb_profile_pending, true);
+            /* Pairs with the read of tb_profile_pending after the exit. */
+            smp_wmb();
+            qatomic_set(&cpu->neg.icount_decr.u16.high, -1);
+        }
+    }
+
+    timer_mod(tb_profile_timer,
+              qemu_clock_get_ns(QEMU_CLOCK_REALTIME) + tb_profile_period_ns);
+}
+
+void tb_profile_init(unsigned hz)
+{
+    if (hz == 0 || tb_profile_timer) {
+        return;
+    }
+
+    qemu_mutex_init(&tb_profile_lock);
+    tb_profile_table = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+    tb_profile_period_ns = NANOSECONDS_PER_SECOND / hz;
+    tb_profile_timer = timer_new_ns(QEMU_CLOCK_REALTIME,
+                                    tb_profile_tick, NULL);
+    timer_mod(tb_profile_timer,
+              qemu_clock_get_ns(QEMU_CLOCK_REALTIME) + tb_profile_period_ns);
+}
+
+void tb_profile_record(vaddr pc, const TranslationBlock *tb)
+{
+    TBProfileEntry *e;
+
+    if (!tb_profile_table) {
+        return;
+    }
+
+    qemu_mutex_lock(&tb_profile_lock);
+    e = g_hash_table_lookup(tb_profile_table, (gpointer)(uintptr_t)pc);
+    if (!e) {
+        e = g_new0(TBProfileEntry, 1);
+        e->pc = pc;
+        g_hash_table_insert(tb_profile_table, (gpointer)(uintptr_t)pc, e);
+    }
+    /* The TB at this pc may have been retranslated; keep the latest. */
+    e->icount = tb->icount;
+    e->host_size = tb->tc.size;
+    e->samples++;
+    tb_profile_total++;
+    qemu_mutex_unlock(&tb_profile_lock);
+}
+
+static gint tb_profile_cmp(gconstpointer a, gconstpointer b)
+{
+    const TBProfileEntry *ea = a;
+    const TBProfileEntry *eb = b;
+
+    if (ea->samples != eb->samples) {
+        return ea->samples > eb->samples ? -1 : 1;
+    }
+    return ea->pc < eb->pc ? -1 : ea->pc > eb->pc;
+}
+
+void tb_profile_dump(GString *buf)
+{
+    GList *list, *l;
+    unsigned n = 0;
+
+    if (!tb_profile_table) {
+        g_string_append(buf, "TB profiling is disabled, "
+                        "enable it with -accel tcg,profile-hz=N\n");
+        return;
+    }
+
+    qemu_mutex_lock(&tb_profile_lock);
+    g_string_append_printf(buf, "TB profile: %" PRIu64 " samples, "
+                           "%u distinct TBs\n", tb_profile_total,
+                           g_hash_table_size(tb_profile_table));
+    g_string_append_printf(buf, "%-18s %10s %7s %6s %6s %9s\n",
+                           "guest pc", "samples", "%", "insns",
+                           "host", "bytes/ins");
+
+    list = g_list_sort(g_hash_table_get_values(tb_profile_table),
+                       tb_profile_cmp);
+    for (l = list; l && n < TB_PROFILE_DUMP_MAX; l = l->next, n++) {
+        TBProfileEntry *e = l->data;
+
+        g_string_append_printf(buf, "0x%016" VADDR_PRIx " %10" PRIu64
+                               " %6.2f%% %6u %6u %9.1f\n",
+                               e->pc, e->samples,
+                               e->samples * 100.0 / tb_profile_total,
+                               e->icount, e->host_size,
+                               e->icount ? (double)e->host_size / e->icount
+                                         : 0.0);
+    }
+    g_list_free(list);
+    qemu_mutex_unlock(&tb_profile_lock);
+}
@@ -29,10 +29,12 @@
 #include "qemu/main-loop.h"
 #include "qemu/guest-random.h"
 #include "hw/core/cpu.h"
+#include "system/cpus.h"
 
 #include "tcg-accel-ops.h"
 #include "tcg-accel-ops-icount.h"
 #include "tcg-accel-ops-rr.h"
+#include "internal-common.h"
 
 static int64_t icount_get_limit(void)
 {
@@ -158,3 +160,148 @@ void icount_handle_interrupt(CPUState *cpu, int mask)
         cpu_abort(cpu, "Raised interrupt while not in I/O function");
     }
 }
+
+/*
+ * Multi-threaded icount.
+ *
+ * With icount-quantum=N, MTTCG vCPUs execute in lockstep quanta of at
+ * most N instructions each.  During a quantum a vCPU only sees its own
+ * progress in the virtual clock, interrupts raised by other vCPUs are
+ * held back, and the instructions it executes are not published.  When
+ * the last vCPU finishes the quantum it adds them all to the icount,
+ * runs the expired virtual timers, delivers the held back interrupts
+ * and starts the next quantum.  The virtual clock and the timing of
+ * interrupts then only depend on the instructions each vCPU executed.
+ *
+ * The quantum state is protected by the BQL.
+ */
+static struct {
+    unsigned gen;       /* current quantum */
+    unsigned running;   /* vCPUs that have not finished it yet */
+    int64_t length;     /* instructions per vCPU */
+    bool in_boundary;   /* processing the end of a quantum */
+} quantum = { .gen = 1 };
+
+static void icount_quantum_enroll(CPUState *cpu)
+{
+    cpu->icount_quantum_gen = quantum.gen;
+    cpu->icount_quantum_left = quantum.length;
+    cpu->icount_quantum_active = true;
+    quantum.running++;
+}
+
+static void icount_quantum_start(void)
+{
+    int64_t deadline;
+    unsigned n = 0;
+    CPUState *cpu;
+
+    CPU_FOREACH(cpu) {
+        n += !cpu_thread_is_idle(cpu);
+    }
+
+    /*
+     * The icount advances by the instructions of all vCPUs, so split
+     * the distance to the next virtual timer among them.
+     */
+    quantum.length = tcg_icount_quantum;
+    deadline = qemu_clock_deadline_ns_all(QEMU_CLOCK_VIRTUAL,
+                                          QEMU_TIMER_ATTR_ALL);
+    if (deadline >= 0 && n) {
+        quantum.length = MIN(quantum.length,
+                             MAX(icount_round(deadline) / n, 1));
+    }
+
+    quantum.gen++;
+    CPU_FOREACH(cpu) {
+        if (!cpu_thread_is_idle(cpu)) {
+            icount_quantum_enroll(cpu);
+        }
+        qemu_cond_broadcast(cpu->halt_cond);
+    }
+}
+
+static void icount_quantum_end(void)
+{
+    CPUState *cpu;
+
+    quantum.in_boundary = true;
+
+    icount_quantum_publish();
+    icount_notify_aio_contexts();
+
+    CPU_FOREACH(cpu) {
+        uint32_t mask = qatomic_xchg(&cpu->quantum_interrupt_request, 0);
+
+        if (mask) {
+            tcg_handle_interrupt(cpu, mask);
+        }
+    }
+
+    icount_quantum_start();
+    quantum.in_boundary = false;
+}
+
+bool icount_quantum_join(CPUState *cpu)
+{
+    if (cpu->icount_quantum_active) {
+        return true;
+    }
+    if (quantum.running == 0) {
+        /* All vCPUs were idle: start a new quantum. */
+        icount_quantum_start();
+        return cpu->icount_quantum_active;
+    }
+    if (cpu->icount_quantum_gen == quantum.gen) {
+        /* Already done with this one, wait for the others. */
+        return false;
+    }
+    /* Woken up during the quantum. */
+    icount_quantum_enroll(cpu);
+    return true;
+}
+
+void icount_quantum_finish(CPUState *cpu)
+{
+    if (!cpu->icount_quantum_active) {
+        return;
+    }
+    cpu->icount_quantum_active = false;
+    cpu->icount_quantum_left = 0;
+    if (--quantum.running == 0) {
+        icount_quantum_end();
+    }
+}
+
+void icount_quantum_prepare(CPUState *cpu)
+{
+    int insns_left;
+
+    g_assert(cpu->neg.icount_decr.u16.low == 0);
+    g_assert(cpu->icount_extra == 0);
+
+    cpu->icount_budget = cpu->icount_quantum_left;
+    insns_left = MIN(0xffff, cpu->icount_budget);
+    cpu->neg.icount_decr.u16.low = insns_left;
+    cpu->icount_extra = cpu->icount_budget - insns_left;
+}
+
+void icount_quantum_process(CPUState *cpu)
+{
+    /* Account for executed instructions; icount_budget keeps the rest. */
+    icount_update(cpu);
+    cpu->icount_quantum_left = cpu->icount_budget;
+
+    cpu->neg.icount_decr.u16.low = 0;
+    cpu->icount_extra = 0;
+    cpu->icount_budget = 0;
+}
+
+void icount_quantum_handle_interrupt(CPUState *cpu, int mask)
+{
+    if (current_cpu && current_cpu != cpu && !quantum.in_boundary) {
+        qatomic_or(&cpu->quantum_interrupt_request, mask);
+        return;
+    }
+    icount_handle_interrupt(cpu, mask);
+}
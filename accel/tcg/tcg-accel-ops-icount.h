@@ -17,4 +17,12 @@ void icount_process_data(CPUState *cpu);
 
 void icount_handle_interrupt(CPUState *cpu, int mask);
 
+/* Multi-threaded icount, called with the BQL held. */
+bool icount_quantum_join(CPUState *cpu);
+void icount_quantum_finish(CPUState *cpu);
+/* Called by the vCPU thread around tcg_cpu_exec(). */
+void icount_quantum_prepare(CPUState *cpu);
+void icount_quantum_process(CPUState *cpu);
+void icount_quantum_handle_interrupt(CPUState *cpu, int mask);
+
 #endif /* TCG_ACCEL_OPS_ICOUNT_H */
@@ -31,11 +31,15 @@
 #include "qemu/main-loop.h"
 #include "qemu/notify.h"
 #include "qemu/guest-random.h"
+#include "qemu/bitmap.h"
+#include "qemu/error-report.h"
 #include "hw/core/boards.h"
 #include "accel/tcg/cpu-loop.h"
 #include "tcg/startup.h"
 #include "tcg-accel-ops.h"
 #include "tcg-accel-ops-mttcg.h"
+#include "tcg-accel-ops-icount.h"
+#include "internal-common.h"
 
 typedef struct MttcgForceRcuNotifier {
     Notifier notifier;
@@ -69,7 +73,7 @@ static void *mttcg_cpu_thread_fn(void *arg)
     CPUState *cpu = arg;
 
     assert(tcg_enabled());
-    g_assert(!icount_enabled());
+    g_assert(!icount_enabled() || tcg_icount_quantum);
 
     rcu_register_thread();
     force_rcu.notifier.notify = mttcg_force_rcu;
@@ -87,13 +91,34 @@ static void *mttcg_cpu_thread_fn(void *arg)
     qemu_guest_random_seed_thread_part2(cpu->random_seed);
 
     do {
+        if (tcg_icount_quantum && cpu_thread_is_idle(cpu)) {
+            /* An idle vCPU does not hold back the current quantum. */
+            icount_quantum_finish(cpu);
+        }
         qemu_process_cpu_events(cpu);
 
         if (cpu_can_run(cpu)) {
             int r;
+
+            if (tcg_icount_quantum && !icount_quantum_join(cpu)) {
+                /* Wait for the other vCPUs to finish the quantum. */
+                qemu_cond_wait_bql(cpu->halt_cond);
+                continue;
+            }
+
             bql_unlock();
+            if (tcg_icount_quantum) {
+                icount_quantum_prepare(cpu);
+            }
             r = tcg_cpu_exec(cpu);
+            if (tcg_icount_quantum) {
+                icount_quantum_process(cpu);
+            }
             bql_lock();
+
+            if (tcg_icount_quantum && cpu->icount_quantum_left == 0) {
+                icount_quantum_finish(cpu);
+            }
             switch (r) {
             case EXCP_DEBUG:
                 cpu_handle_guest_debug(cpu);
@@ -115,6 +140,9 @@ static void *mttcg_cpu_thread_fn(void *arg)
         }
     } while (!cpu->unplug || cpu_can_run(cpu));
 
+    if (tcg_icount_quantum) {
+        icount_quantum_finish(cpu);
+    }
     tcg_cpu_destroy(cpu);
     bql_unlock();
     rcu_remove_force_rcu_notifier(&force_rcu.notifier);
@@ -122,6 +150,48 @@ static void *mttcg_cpu_thread_fn(void *arg)
     return NULL;
 }
 
+/*
+ * Pin the vCPU thread to a single host CPU, chosen round-robin by
+ * cpu_index among the host CPUs that the calling thread may run on,
+ * so that an external CPU set restriction (e.g. taskset) is honoured.
+ * With more vCPUs than host CPUs, several vCPUs share each host CPU.
+ */
+static void mttcg_pin_vcpu_thread(CPUState *cpu)
+{
+    g_autofree unsigned long *allowed = NULL;
+    g_autofree unsigned long *mask = NULL;
+    unsigned long nbits, host_cpu;
+    long nallowed, i;
+    QemuThread self;
+    int err;
+
+    qemu_thread_get_self(&self);
+    err = qemu_thread_get_affinity(&self, &allowed, &nbits);
+    if (err) {
+        warn_report_once("tcg: cannot pin vCPU threads: %s",
+                         strerror(abs(err)));
+        return;
+    }
+
+    nallowed = bitmap_count_one(allowed, nbits);
+    if (nallowed == 0) {
+        return;
+    }
+
+    host_cpu = find_first_bit(allowed, nbits);
+    for (i = cpu->cpu_index % nallowed; i > 0; i--) {
+        host_cpu = find_next_bit(allowed, nbits, host_cpu + 1);
+    }
+
+    mask = bitmap_new(nbits);
+    set_bit(host_cpu, mask);
+    err = qemu_thread_set_affinity(cpu->thread, mask, nbits);
+    if (err) {
+        warn_report("tcg: cannot pin CPU %d to host CPU %lu: %s",
+                    cpu->cpu_index, host_cpu, strerror(abs(err)));
+    }
+}
+
 void mttcg_start_vcpu_thread(CPUState *cpu)
 {
     char thread_name[VCPU_THREAD_NAME_SIZE];
@@ -135,4 +205,8 @@ void mttcg_start_vcpu_thread(CPUState *cpu)
 
     qemu_thread_create(cpu->thread, thread_name, mttcg_cpu_thread_fn,
                        cpu, QEMU_THREAD_JOINABLE);
+
+    if (tcg_vcpu_pin) {
+        mttcg_pin_vcpu_thread(cpu);
+    }
 }
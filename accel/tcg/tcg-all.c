@@ -35,6 +35,7 @@
 #include "qapi/qapi-types-common.h"
 #include "qapi/qapi-builtin-visit.h"
 #include "qemu/units.h"
+#include "qemu/host-utils.h"
 #include "qemu/target-info.h"
 #ifndef CONFIG_USER_ONLY
 #include "hw/core/boards.h"
@@ -44,6 +45,7 @@
 #include "accel/accel-ops.h"
 #include "accel/accel-cpu-ops.h"
 #include "accel/tcg/cpu-ops.h"
+#include "hw/core/cpu.h"
 #include "internal-common.h"
 
 
@@ -52,6 +54,8 @@ struct TCGState {
 
     OnOffAuto mttcg_enabled;
     bool one_insn_per_tb;
+    bool tb_evict;
+    bool tb_numa_local;
     int splitwx_enabled;
     unsigned long tb_size;
 };
@@ -83,8 +87,21 @@ static void tcg_accel_instance_init(Object *obj)
 }
 
 bool one_insn_per_tb;
+bool tb_evict_regions;
+unsigned tlb_victim_size = CPU_VTLB_SIZE;
+bool tcg_vcpu_pin;
+bool tcg_atomic_htm;
+unsigned tcg_icount_quantum;
+unsigned tcg_profile_hz;
+unsigned tcg_working_set_interval;
 
 #ifndef CONFIG_USER_ONLY
+/* Can icount run multi-threaded, in lockstep quanta? */
+static bool tcg_icount_quantum_ok(void)
+{
+    return tcg_icount_quantum && replay_mode == REPLAY_MODE_NONE;
+}
+
 static void tcg_vm_change_state(void *opaque, bool running, RunState state)
 {
     if (state == RUN_STATE_RESTORE_VM) {
@@ -124,7 +141,7 @@ static int tcg_init_machine(AccelState *as, MachineState *ms)
          * there is one remaining limitation to check:
          *   - The guest can't be oversized (e.g. 64 bit guest on 32 bit host)
          */
-        if (mttcg_supported && !icount_enabled()) {
+        if (mttcg_supported && (!icount_enabled() || tcg_icount_quantum_ok())) {
             s->mttcg_enabled = ON_OFF_AUTO_ON;
             max_threads = ms->smp.max_cpus;
         } else {
@@ -132,6 +149,11 @@ static int tcg_init_machine(AccelState *as, MachineState *ms)
         }
         break;
     case ON_OFF_AUTO_ON:
+        if (icount_enabled() && !tcg_icount_quantum_ok()) {
+            error_report("No MTTCG when icount is enabled, unless "
+                         "icount-quantum is set and replay is not used");
+            return -EINVAL;
+        }
         if (!mttcg_supported) {
             warn_report("Guest not yet converted to MTTCG - "
                         "you may get unexpected results");
@@ -144,6 +166,11 @@ static int tcg_init_machine(AccelState *as, MachineState *ms)
         g_assert_not_reached();
     }
 
+    /* Lockstep quanta only apply to multi-threaded icount. */
+    if (s->mttcg_enabled != ON_OFF_AUTO_ON || !icount_enabled()) {
+        tcg_icount_quantum = 0;
+    }
+
     qemu_add_vm_change_state_handler(tcg_vm_change_state, NULL);
 #endif
 
@@ -165,7 +192,8 @@ static int tcg_init_machine(AccelState *as, MachineState *ms)
 
     page_init();
     tb_htable_init();
-    tcg_init(s->tb_size * MiB, s->splitwx_enabled, max_threads);
+    tcg_init(s->tb_size * MiB, s->splitwx_enabled, max_threads,
+             s->tb_numa_local);
 
 #if defined(CONFIG_SOFTMMU)
     /*
@@ -177,6 +205,9 @@ static int tcg_init_machine(AccelState *as, MachineState *ms)
 
 #ifdef CONFIG_USER_ONLY
     qdev_create_fake_machine();
+#else
+    tb_profile_init(tcg_profile_hz);
+    working_set_init(tcg_working_set_interval);
 #endif
 
     return 0;
@@ -194,11 +225,7 @@ static void tcg_set_thread(Object *obj, const char *value, Error **errp)
     TCGState *s = TCG_STATE(obj);
 
     if (strcmp(value, "multi") == 0) {
-        if (icount_enabled()) {
-            error_setg(errp, "No MTTCG when icount is enabled");
-        } else {
-            s->mttcg_enabled = ON_OFF_AUTO_ON;
-        }
+        s->mttcg_enabled = ON_OFF_AUTO_ON;
     } else if (strcmp(value, "single") == 0) {
         s->mttcg_enabled = ON_OFF_AUTO_OFF;
     } else {
@@ -230,6 +257,128 @@ static void tcg_set_tb_size(Object *obj, Visitor *v,
     s->tb_size = value;
 }
 
+static void tcg_get_tlb_victim_size(Object *obj, Visitor *v,
+                                    const char *name, void *opaque,
+                                    Error **errp)
+{
+    uint32_t value = tlb_victim_size;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void tcg_set_tlb_victim_size(Object *obj, Visitor *v,
+                                    const char *name, void *opaque,
+                                    Error **errp)
+{
+    uint32_t value;
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+    if (!is_power_of_2(value) ||
+        value < CPU_VTLB_SIZE || value > CPU_VTLB_MAX_SIZE) {
+        error_setg(errp, "tlb-victim-size must be a power of 2 "
+                   "between %d and %d", CPU_VTLB_SIZE, CPU_VTLB_MAX_SIZE);
+        return;
+    }
+
+    tlb_victim_size = value;
+}
+
+static void tcg_get_profile_hz(Object *obj, Visitor *v,
+                               const char *name, void *opaque,
+                               Error **errp)
+{
+    uint32_t value = tcg_profile_hz;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void tcg_set_profile_hz(Object *obj, Visitor *v,
+                               const char *name, void *opaque,
+                               Error **errp)
+{
+    uint32_t value;
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+    if (value > 10000) {
+        error_setg(errp, "profile-hz must be at most 10000");
+        return;
+    }
+
+    tcg_profile_hz = value;
+}
+
+static void tcg_get_working_set_interval(Object *obj, Visitor *v,
+                                        const char *name, void *opaque,
+                                        Error **errp)
+{
+    uint32_t value = tcg_working_set_interval;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void tcg_set_working_set_interval(Object *obj, Visitor *v,
+                                        const char *name, void *opaque,
+                                        Error **errp)
+{
+    uint32_t value;
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+    if (value && value < 100) {
+        error_setg(errp, "working-set-interval must be at least 100 ms");
+        return;
+    }
+
+    tcg_working_set_interval = value;
+}
+
+static void tcg_get_icount_quantum(Object *obj, Visitor *v,
+                                   const char *name, void *opaque,
+                                   Error **errp)
+{
+    uint32_t value = tcg_icount_quantum;
+
+    visit_type_uint32(v, name, &value, errp);
+}
+
+static void tcg_set_icount_quantum(Object *obj, Visitor *v,
+                                   const char *name, void *opaque,
+                                   Error **errp)
+{
+    uint32_t value;
+
+    if (!visit_type_uint32(v, name, &value, errp)) {
+        return;
+    }
+
+    tcg_icount_quantum = value;
+}
+
+static bool tcg_get_vcpu_pin(Object *obj, Error **errp)
+{
+    return tcg_vcpu_pin;
+}
+
+static void tcg_set_vcpu_pin(Object *obj, bool value, Error **errp)
+{
+    tcg_vcpu_pin = value;
+}
+
+static bool tcg_get_atomic_htm(Object *obj, Error **errp)
+{
+    return tcg_atomic_htm;
+}
+
+static void tcg_set_atomic_htm(Object *obj, bool value, Error **errp)
+{
+    tcg_atomic_htm = value;
+}
+
 static bool tcg_get_splitwx(Object *obj, Error **errp)
 {
     TCGState *s = TCG_STATE(obj);
@@ -256,6 +405,31 @@ static void tcg_set_one_insn_per_tb(Object *obj, bool value, Error **errp)
     qatomic_set(&one_insn_per_tb, value);
 }
 
+static bool tcg_get_tb_evict(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->tb_evict;
+}
+
+static void tcg_set_tb_evict(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->tb_evict = value;
+    qatomic_set(&tb_evict_regions, value);
+}
+
+static bool tcg_get_tb_numa_local(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->tb_numa_local;
+}
+
+static void tcg_set_tb_numa_local(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->tb_numa_local = value;
+}
+
 static void tcg_accel_class_init(ObjectClass *oc, const void *data)
 {
     AccelClass *ac = ACCEL_CLASS(oc);
@@ -270,12 +444,51 @@ static void tcg_accel_class_init(ObjectClass *oc, const void *data)
                                   tcg_get_thread,
                                   tcg_set_thread);
 
+    object_class_property_add_bool(oc, "vcpu-pin",
+                                   tcg_get_vcpu_pin,
+                                   tcg_set_vcpu_pin);
+    object_class_property_set_description(oc, "vcpu-pin",
+        "Pin each multi-threaded TCG vCPU thread to one host CPU");
+
     object_class_property_add(oc, "tb-size", "int",
         tcg_get_tb_size, tcg_set_tb_size,
         NULL, NULL);
     object_class_property_set_description(oc, "tb-size",
         "TCG translation block cache size");
 
+    object_class_property_add(oc, "tlb-victim-size", "int",
+        tcg_get_tlb_victim_size, tcg_set_tlb_victim_size,
+        NULL, NULL);
+    object_class_property_set_description(oc, "tlb-victim-size",
+        "Number of entries in each fully associative victim TLB");
+
+    object_class_property_add(oc, "icount-quantum", "int",
+        tcg_get_icount_quantum, tcg_set_icount_quantum,
+        NULL, NULL);
+    object_class_property_set_description(oc, "icount-quantum",
+        "Instructions per vCPU and lockstep quantum with multi-threaded "
+        "icount (0 = no multi-threaded icount)");
+
+    object_class_property_add(oc, "profile-hz", "int",
+        tcg_get_profile_hz, tcg_set_profile_hz,
+        NULL, NULL);
+    object_class_property_set_description(oc, "profile-hz",
+        "Sampling rate of the TB profiler (0 = disabled)");
+
+    object_class_property_add(oc, "working-set-interval", "int",
+        tcg_get_working_set_interval, tcg_set_working_set_interval,
+        NULL, NULL);
+    object_class_property_set_description(oc, "working-set-interval",
+        "Length in milliseconds of each working set estimation window "
+        "(0 = disabled)");
+
+    object_class_property_add_bool(oc, "atomic-htm",
+                                   tcg_get_atomic_htm,
+                                   tcg_set_atomic_htm);
+    object_class_property_set_description(oc, "atomic-htm",
+        "Use host transactional memory instead of stopping all vCPUs "
+        "for atomic operations the host cannot emulate");
+
     object_class_property_add_bool(oc, "split-wx",
         tcg_get_splitwx, tcg_set_splitwx);
     object_class_property_set_description(oc, "split-wx",
@@ -286,6 +499,20 @@ static void tcg_accel_class_init(ObjectClass *oc, const void *data)
                                    tcg_set_one_insn_per_tb);
     object_class_property_set_description(oc, "one-insn-per-tb",
         "Only put one guest insn in each translation block");
+
+    object_class_property_add_bool(oc, "tb-evict",
+                                   tcg_get_tb_evict,
+                                   tcg_set_tb_evict);
+    object_class_property_set_description(oc, "tb-evict",
+        "Reclaim the oldest translation region instead of flushing "
+        "all translation blocks when the cache is full");
+
+    object_class_property_add_bool(oc, "tb-numa-local",
+                                   tcg_get_tb_numa_local,
+                                   tcg_set_tb_numa_local);
+    object_class_property_set_description(oc, "tb-numa-local",
+        "Re-fault translation regions on the NUMA node of the vCPU "
+        "thread that reuses them");
 }
 
 static const TypeInfo tcg_accel_type = {
@@ -291,10 +291,10 @@ TranslationBlock *tb_gen_code(CPUState *cpu, TCGTBCPUState s)
         /* flush must be done */
         if (cpu_in_serial_context(cpu)) {
             trace_tb_gen_code_buffer_overflow("tcg_tb_alloc");
-            tb_flush__exclusive_or_serial();
+            tb_make_room__exclusive_or_serial();
             goto buffer_overflow;
         }
-        queue_tb_flush(cpu);
+        queue_tb_make_room(cpu);
         mmap_unlock();
         /* Make the execution loop process the flush as soon as possible.  */
         cpu->exception_index = EXCP_INTERRUPT;
@@ -635,4 +635,9 @@ void tcg_flush_jmp_cache(CPUState *cpu)
     for (int i = 0; i < TB_JMP_CACHE_SIZE; i++) {
         qatomic_set(&jc->array[i].tb, NULL);
     }
+    for (int i = 0; i < TB_JMP_L2_SETS; i++) {
+        for (int j = 0; j < TB_JMP_L2_WAYS; j++) {
+            qatomic_set(&jc->l2[i].way[j].tb, NULL);
+        }
+    }
 }
@@ -24,6 +24,7 @@
 #include "tcg/tcg.h"
 #include "qemu/bitops.h"
 #include "qemu/rcu.h"
+#include "qemu/seqlock.h"
 #include "accel/tcg/cpu-ldst-common.h"
 #include "accel/tcg/cpu-loop.h"
 #include "accel/tcg/helper-retaddr.h"
@@ -168,6 +169,12 @@ typedef struct PageFlagsNode {
 
 static IntervalTreeRoot pageflags_root;
 
+/*
+ * Modifications of pageflags_root are serialized by mmap_lock, and are
+ * bracketed by pageflags_seq so that lookups may be done without it.
+ */
+static QemuSeqLock pageflags_seq;
+
 static PageFlagsNode *pageflags_find(vaddr start, vaddr last)
 {
     IntervalTreeNode *n;
@@ -176,6 +183,26 @@ static PageFlagsNode *pageflags_find(vaddr start, vaddr last)
     return n ? container_of(n, PageFlagsNode, itree) : NULL;
 }
 
+/*
+ * See util/interval-tree.c re lockless lookups: no false positives but
+ * there are false negatives, and the node found may not be the first
+ * one overlapping [start,last].  Retry if the tree changed underneath
+ * us, so that the result is as good as one made with mmap_lock held.
+ * Must be called within an RCU read-side critical section.
+ */
+static PageFlagsNode *pageflags_find_rcu(vaddr start, vaddr last)
+{
+    PageFlagsNode *p;
+    unsigned seq;
+
+    do {
+        seq = seqlock_read_begin(&pageflags_seq);
+        p = pageflags_find(start, last);
+    } while (seqlock_read_retry(&pageflags_seq, seq));
+
+    return p;
+}
+
 static PageFlagsNode *pageflags_next(PageFlagsNode *p, vaddr start, vaddr last)
 {
     IntervalTreeNode *n;
@@ -242,24 +269,8 @@ int page_get_flags(vaddr address)
     PageFlagsNode *p;
 
     RCU_READ_LOCK_GUARD();
-
-    /*
-     * See util/interval-tree.c re lockless lookups: no false positives but
-     * there are false negatives.  If we find nothing, retry with the mmap
-     * lock acquired.
-     */
-    p = pageflags_find(address, address);
-    if (p) {
-        return p->flags;
-    }
-    if (have_mmap_lock()) {
-        return 0;
-    }
-
-    mmap_lock();
-    p = pageflags_find(address, address);
-    mmap_unlock();
-    return p ? p->flags : 0;
+    p = pageflags_find_rcu(address, address);
+    return p ? qatomic_read(&p->flags) : 0;
 }
 
 /* A subroutine of page_set_flags: insert a new node for [start,last]. */
@@ -327,6 +338,8 @@ static bool pageflags_set_clear(vaddr start, vaddr last,
     int p_flags, merge_flags;
     bool inval_tb = false;
 
+    seqlock_write_begin(&pageflags_seq);
+
  restart:
     p = pageflags_find(start, last);
     if (!p) {
@@ -359,7 +372,7 @@ static bool pageflags_set_clear(vaddr start, vaddr last,
      */
     if (start == p_start && last == p_last) {
         if (merge_flags & PAGE_VALID) {
-            p->flags = merge_flags;
+            qatomic_set(&p->flags, merge_flags);
         } else {
             interval_tree_remove(&p->itree, &pageflags_root);
             g_free_rcu(p, rcu);
@@ -404,7 +417,7 @@ static bool pageflags_set_clear(vaddr start, vaddr last,
                 g_free_rcu(p, rcu);
             } else {
                 if (merge_flags & PAGE_VALID) {
-                    p->flags = merge_flags;
+                    qatomic_set(&p->flags, merge_flags);
                 } else {
                     interval_tree_remove(&p->itree, &pageflags_root);
                     g_free_rcu(p, rcu);
@@ -456,6 +469,7 @@ static bool pageflags_set_clear(vaddr start, vaddr last,
     }
 
  done:
+    seqlock_write_end(&pageflags_seq);
     return inval_tb;
 }
 
@@ -496,7 +510,6 @@ void page_set_flags(vaddr start, vaddr last, int set_flags, int clear_flags)
 bool page_check_range(vaddr start, vaddr len, int flags)
 {
     vaddr last;
-    int locked;  /* tri-state: =0: unlocked, +1: global, -1: local */
     bool ret;
 
     if (len == 0) {
@@ -510,38 +523,27 @@ bool page_check_range(vaddr start, vaddr len, int flags)
 
     RCU_READ_LOCK_GUARD();
 
-    locked = have_mmap_lock();
     while (true) {
-        PageFlagsNode *p = pageflags_find(start, last);
-        int missing;
+        PageFlagsNode *p = pageflags_find_rcu(start, last);
+        int p_flags, missing;
 
         if (!p) {
-            if (!locked) {
-                /*
-                 * Lockless lookups have false negatives.
-                 * Retry with the lock held.
-                 */
-                mmap_lock();
-                locked = -1;
-                p = pageflags_find(start, last);
-            }
-            if (!p) {
-                ret = false; /* entire region invalid */
-                break;
-            }
+            ret = false; /* entire region invalid */
+            break;
         }
         if (start < p->itree.start) {
             ret = false; /* initial bytes invalid */
             break;
         }
 
-        missing = flags & ~p->flags;
+        p_flags = qatomic_read(&p->flags);
+        missing = flags & ~p_flags;
         if (missing & ~PAGE_WRITE) {
             ret = false; /* page doesn't match */
             break;
         }
         if (missing & PAGE_WRITE) {
-            if (!(p->flags & PAGE_WRITE_ORG)) {
+            if (!(p_flags & PAGE_WRITE_ORG)) {
                 ret = false; /* page not writable */
                 break;
             }
@@ -565,11 +567,6 @@ bool page_check_range(vaddr start, vaddr len, int flags)
         }
         start = p->itree.last + 1;
     }
-
-    /* Release the lock if acquired locally. */
-    if (locked < 0) {
-        mmap_unlock();
-    }
     return ret;
 }
 
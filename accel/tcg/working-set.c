@@ -0,0 +1,169 @@
+/*
+ * SPDX-License-Identifier: LGPL-2.1-or-later
+ *
+ *  QEMU TCG guest working set estimation
+ *
+ * Every guest access to a RAM page that is not in the softmmu TLB
+ * goes through tlb_set_page_full().  Recording the ram_addr_t of each
+ * fill in a bitmap, and flushing all TLBs at the start of every
+ * window, therefore gives the set of pages touched by the vCPUs
+ * during the window.  DMA from devices is not accounted.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/atomic.h"
+#include "qemu/bitmap.h"
+#include "qemu/rcu.h"
+#include "qemu/thread.h"
+#include "qemu/timer.h"
+#include "qapi/error.h"
+#include "qapi/clone-visitor.h"
+#include "qapi/qapi-commands-machine.h"
+#include "qapi/qapi-visit-machine.h"
+#include "exec/cputlb.h"
+#include "exec/target_page.h"
+#include "hw/core/cpu.h"
+#include "system/ramblock.h"
+#include "system/tcg.h"
+#include "internal-common.h"
+
+typedef struct WorkingSetBitmap {
+    struct rcu_head rcu;
+    uint64_t npages;
+    unsigned long bmap[];
+} WorkingSetBitmap;
+
+static QEMUTimer *working_set_timer;
+static int64_t working_set_interval_ms;
+static WorkingSetBitmap *working_set_bitmap;
+static QemuMutex working_set_lock;
+/* Result of the last complete window, protected by working_set_lock */
+static WorkingSetRAMBlockList *working_set_blocks;
+static int64_t working_set_window;
+/* Start of the window being recorded, only used by the timer */
+static int64_t working_set_window_start;
+
+static WorkingSetBitmap *working_set_bitmap_new(void)
+{
+    WorkingSetBitmap *ws;
+    RAMBlock *block;
+    ram_addr_t end = 0;
+
+    RCU_READ_LOCK_GUARD();
+    RAMBLOCK_FOREACH(block) {
+        end = MAX(end, block->offset + block->max_length);
+    }
+
+    ws = g_malloc0(sizeof(*ws) +
+                   BITS_TO_LONGS(end >> TARGET_PAGE_BITS) *
+                   sizeof(unsigned long));
+    ws->npages = end >> TARGET_PAGE_BITS;
+    return ws;
+}
+
+static WorkingSetRAMBlockList *working_set_count(const WorkingSetBitmap *ws)
+{
+    WorkingSetRAMBlockList *head = NULL, **tail = &head;
+    RAMBlock *block;
+
+    RCU_READ_LOCK_GUARD();
+    RAMBLOCK_FOREACH(block) {
+        uint64_t first = block->offset >> TARGET_PAGE_BITS;
+        uint64_t npages = block->used_length >> TARGET_PAGE_BITS;
+        WorkingSetRAMBlock *info;
+
+        if (first + npages > ws->npages) {
+            /* Added or resized after the window started */
+            continue;
+        }
+
+        info = g_new0(WorkingSetRAMBlock, 1);
+        info->id = g_strdup(block->idstr);
+        info->size = block->used_length;
+        info->accessed = (uint64_t)bitmap_count_one_with_offset(ws->bmap,
+                                                                first, npages)
+                         << TARGET_PAGE_BITS;
+        QAPI_LIST_APPEND(tail, info);
+    }
+    return head;
+}
+
+static void working_set_tick(void *opaque)
+{
+    WorkingSetBitmap *old = working_set_bitmap;
+    WorkingSetRAMBlockList *blocks;
+    int64_t now = qemu_clock_get_ms(QEMU_CLOCK_REALTIME);
+    CPUState *cpu;
+
+    qatomic_rcu_set(&working_set_bitmap, working_set_bitmap_new());
+
+    /* Make every vCPU refill, and thus record, the pages it touches. */
+    CPU_FOREACH(cpu) {
+        tlb_flush(cpu);
+    }
+
+    if (old) {
+        blocks = working_set_count(old);
+        g_free_rcu(old, rcu);
+
+        qemu_mutex_lock(&working_set_lock);
+        qapi_free_WorkingSetRAMBlockList(working_set_blocks);
+        working_set_blocks = blocks;
+        working_set_window = now - working_set_window_start;
+        qemu_mutex_unlock(&working_set_lock);
+    }
+    working_set_window_start = now;
+
+    timer_mod(working_set_timer, now + working_set_interval_ms);
+}
+
+void working_set_init(unsigned interval_ms)
+{
+    if (interval_ms == 0 || working_set_timer) {
+        return;
+    }
+
+    qemu_mutex_init(&working_set_lock);
+    working_set_interval_ms = interval_ms;
+    working_set_timer = timer_new_ms(QEMU_CLOCK_REALTIME,
+                                     working_set_tick, NULL);
+    /* The first tick only starts the first window. */
+    timer_mod(working_set_timer, qemu_clock_get_ms(QEMU_CLOCK_REALTIME));
+}
+
+void working_set_record(ram_addr_t addr)
+{
+    WorkingSetBitmap *ws = qatomic_rcu_read(&working_set_bitmap);
+    uint64_t page = addr >> TARGET_PAGE_BITS;
+
+    if (ws && page < ws->npages && !test_bit(page, ws->bmap)) {
+        set_bit_atomic(page, ws->bmap);
+    }
+}
+
+WorkingSetInfo *qmp_x_query_working_set(Error **errp)
+{
+    WorkingSetInfo *info;
+
+    if (!tcg_enabled()) {
+        error_setg(errp, "Working set estimation is only available with "
+                   "accel=tcg");
+        return NULL;
+    }
+    if (!working_set_timer) {
+        error_setg(errp, "Working set estimation is disabled, enable it "
+                   "with -accel tcg,working-set-interval=N");
+        return NULL;
+    }
+
+    info = g_new0(WorkingSetInfo, 1);
+    qemu_mutex_lock(&working_set_lock);
+    if (working_set_blocks) {
+        info->has_interval = true;
+        info->interval = working_set_window;
+        info->blocks = QAPI_CLONE(WorkingSetRAMBlockList, working_set_blocks);
+    }
+    qemu_mutex_unlock(&working_set_lock);
+
+    return info;
+}
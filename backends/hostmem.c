@@ -24,6 +24,7 @@
 #include "qemu/madvise.h"
 #include "qemu/cutils.h"
 #include "hw/core/qdev.h"
+#include "system/startup-timing.h"
 
 #ifdef CONFIG_NUMA
 #include <numaif.h>
@@ -331,11 +332,52 @@ size_t host_memory_backend_pagesize(HostMemoryBackend *memdev)
     return pagesize;
 }
 
+#ifdef CONFIG_NUMA
+/*
+ * Without an explicit prealloc-context, run the preallocation threads on
+ * the CPUs of the host nodes the memory is bound to, so that pages are
+ * faulted in and zeroed locally.  Having a context also allows
+ * preallocating asynchronously, in parallel with device creation.
+ */
+static ThreadContext *
+host_memory_backend_numa_prealloc_context(HostMemoryBackend *backend)
+{
+    g_autoptr(GString) nodes = g_string_new(NULL);
+    Error *local_err = NULL;
+    unsigned long node;
+    Object *tc;
+
+    if (backend->policy == HOST_MEM_POLICY_DEFAULT) {
+        return NULL;
+    }
+
+    for (node = find_first_bit(backend->host_nodes, MAX_NODES);
+         node < MAX_NODES;
+         node = find_next_bit(backend->host_nodes, MAX_NODES, node + 1)) {
+        g_string_append_printf(nodes, "%s%lu", nodes->len ? "," : "", node);
+    }
+    if (!nodes->len) {
+        return NULL;
+    }
+
+    tc = object_new_with_props(TYPE_THREAD_CONTEXT, OBJECT(backend),
+                               "numa-prealloc-context", &local_err,
+                               "node-affinity", nodes->str, NULL);
+    if (!tc) {
+        /* E.g. memory-only nodes: fall back to unpinned threads. */
+        error_free(local_err);
+        return NULL;
+    }
+    return THREAD_CONTEXT(tc);
+}
+#endif
+
 static void
 host_memory_backend_memory_complete(UserCreatable *uc, Error **errp)
 {
     HostMemoryBackend *backend = MEMORY_BACKEND(uc);
     HostMemoryBackendClass *bc = MEMORY_BACKEND_GET_CLASS(uc);
+    ThreadContext *tc = backend->prealloc_context;
     void *ptr;
     uint64_t sz;
     size_t pagesize;
@@ -418,18 +460,33 @@ host_memory_backend_memory_complete(UserCreatable *uc, Error **errp)
             return;
         }
     }
+
+    if (backend->prealloc && !tc) {
+        tc = host_memory_backend_numa_prealloc_context(backend);
+    }
 #endif
     /*
      * Preallocate memory after the NUMA policy has been instantiated.
      * This is necessary to guarantee memory is allocated with
      * specified NUMA policy in place.
      */
-    if (backend->prealloc && !qemu_prealloc_mem(memory_region_get_fd(&backend->mr),
-                                                ptr, sz,
-                                                backend->prealloc_threads,
-                                                backend->prealloc_context,
-                                                async, errp)) {
-        return;
+    if (backend->prealloc) {
+        g_autofree char *id = object_get_canonical_path_component(OBJECT(uc));
+        int64_t t = startup_timing_begin();
+
+        if (!qemu_prealloc_mem(memory_region_get_fd(&backend->mr), ptr, sz,
+                               backend->prealloc_threads, tc, async, errp)) {
+            return;
+        }
+        /*
+         * Asynchronous preallocation is only queued here, and is known to
+         * be complete once qemu_finish_async_prealloc_mem() returns.
+         */
+        if (async) {
+            startup_timing_defer(STARTUP_EVENT_KIND_MEMORY, id, t);
+        } else {
+            startup_timing_end(STARTUP_EVENT_KIND_MEMORY, id, t);
+        }
     }
 }
 
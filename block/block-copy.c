@@ -30,6 +30,8 @@
 #include "qemu/memalign.h"
 
 #define BLOCK_COPY_MAX_COPY_RANGE (16 * MiB)
+/* Consecutive copy_range failures after which read+write is used instead */
+#define BLOCK_COPY_MAX_COPY_RANGE_FAILS 8
 #define BLOCK_COPY_MAX_BUFFER (1 * MiB)
 #define BLOCK_COPY_MAX_MEM (128 * MiB)
 #define BLOCK_COPY_MAX_WORKERS 64
@@ -137,6 +139,8 @@ typedef struct BlockCopyState {
     CoMutex lock;
     int64_t in_flight_bytes;
     BlockCopyMethod method;
+    /* Consecutive failed copy_range calls, accessed atomically */
+    int copy_range_fails;
     bool discard_source;
     BlockReqList reqs;
     QLIST_HEAD(, BlockCopyCallState) calls;
@@ -307,6 +311,7 @@ void block_copy_set_copy_opts(BlockCopyState *s, bool use_copy_range,
          */
         s->method = use_copy_range ? COPY_RANGE_SMALL : COPY_READ_WRITE;
     }
+    qatomic_set(&s->copy_range_fails, 0);
 }
 
 static int64_t block_copy_calculate_cluster_size(BlockDriverState *target,
@@ -494,8 +499,10 @@ static coroutine_fn int block_copy_task_run(AioTaskPool *pool,
  * No sync here: neither bitmap nor intersecting requests handling, only copy.
  *
  * @method is an in-out argument, so that copy_range can be either extended to
- * a full-size buffer or disabled if the copy_range attempt fails.  The output
- * value of @method should be used for subsequent tasks.
+ * a full-size buffer or disabled if the copy_range attempt fails.  A failing
+ * copy_range that has succeeded before falls back to read+write for this
+ * chunk only, unless it has failed BLOCK_COPY_MAX_COPY_RANGE_FAILS times in
+ * a row.  The output value of @method should be used for subsequent tasks.
  * Returns 0 on success.
  */
 static int coroutine_fn GRAPH_RDLOCK
@@ -531,23 +538,36 @@ block_copy_do_copy(BlockCopyState *s, int64_t offset, int64_t bytes,
         if (ret >= 0) {
             /* Successful copy-range, increase chunk size.  */
             *method = COPY_RANGE_FULL;
+            qatomic_set(&s->copy_range_fails, 0);
             return 0;
         }
 
         trace_block_copy_copy_range_fail(s, offset, ret);
-        *method = COPY_READ_WRITE;
+        /*
+         * If copy_range never worked, the configuration most likely does not
+         * support it, so stop trying.  Once it has worked, a failure is
+         * probably specific to this range and later tasks keep using it,
+         * until so many fail in a row that the error is clearly persistent.
+         */
+        if (*method == COPY_RANGE_SMALL || ret == -ENOTSUP ||
+            qatomic_inc_fetch(&s->copy_range_fails) >=
+            BLOCK_COPY_MAX_COPY_RANGE_FAILS) {
+            *method = COPY_READ_WRITE;
+        }
         /* Fall through to read+write with allocated buffer */
 
     case COPY_READ_WRITE_CLUSTER:
     case COPY_READ_WRITE:
         /*
          * In case of failed copy_range request above, we may proceed with
-         * buffered request larger than BLOCK_COPY_MAX_BUFFER.
-         * Still, further requests will be properly limited, so don't care too
-         * much. Moreover the most likely case (copy_range is unsupported for
-         * the configuration, so the very first copy_range request fails)
-         * is handled by setting large copy_size only after first successful
-         * copy_range.
+         * buffered request larger than BLOCK_COPY_MAX_BUFFER, up to
+         * BLOCK_COPY_MAX_COPY_RANGE.  This repeats for every failing chunk
+         * while copy_range stays enabled, which is at most
+         * BLOCK_COPY_MAX_COPY_RANGE_FAILS times in a row, and the memory is
+         * still bounded by s->mem.  The most likely case (copy_range is
+         * unsupported for the configuration, so the very first copy_range
+         * request fails) is handled by setting large copy_size only after
+         * first successful copy_range.
          */
 
         bounce_buffer = qemu_blockalign(s->source->bs, nbytes);
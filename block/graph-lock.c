@@ -20,6 +20,7 @@
 
 #include "qemu/osdep.h"
 #include "qemu/main-loop.h"
+#include "qemu/sys_membarrier.h"
 #include "block/graph-lock.h"
 #include "block/block.h"
 #include "block/block_int.h"
@@ -152,8 +153,12 @@ void no_coroutine_fn bdrv_graph_wrlock(void)
          * We want to only check reader_count() after has_writer = 1 is visible
          * to other threads. That way no more readers can sneak in after we've
          * determined reader_count() == 0.
+         *
+         * Paired with smp_mb_placeholder() in bdrv_graph_co_rdlock(): the
+         * writer is rare, so let it pay for the barrier on all CPUs and
+         * keep the reader fast path free of memory barriers.
          */
-        smp_mb();
+        smp_mb_global();
     } while (reader_count() >= 1);
 
     if (need_drain) {
@@ -212,8 +217,11 @@ void coroutine_fn bdrv_graph_co_rdlock(void)
     for (;;) {
         qatomic_set(&bdrv_graph->reader_count,
                     bdrv_graph->reader_count + 1);
-        /* make sure writer sees reader_count before we check has_writer */
-        smp_mb();
+        /*
+         * make sure writer sees reader_count before we check has_writer,
+         * paired with smp_mb_global() in bdrv_graph_wrlock()
+         */
+        smp_mb_placeholder();
 
         /*
          * has_writer == 0: this means writer will read reader_count as >= 1
@@ -274,14 +282,14 @@ void coroutine_fn bdrv_graph_co_rdunlock(void)
 
     qatomic_store_release(&bdrv_graph->reader_count,
                           bdrv_graph->reader_count - 1);
-    /* make sure writer sees reader_count before we check has_writer */
-    smp_mb();
 
     /*
      * Always kick: bdrv_graph_wrlock() zeroes has_writer while polling (to
      * let callbacks take the reader lock via the fast path), so we cannot
      * rely on has_writer to detect a waiting writer. aio_wait_kick() is a
      * no-op when no one is waiting, so it is cheap in the common case.
+     * Its memory barrier also makes sure that a writer polling in
+     * AIO_WAIT_WHILE() sees the new reader_count.
      */
     aio_wait_kick();
 }
@@ -256,6 +256,7 @@ static void coroutine_fn mirror_write_complete(MirrorOp *op, int ret)
 static void coroutine_fn mirror_read_complete(MirrorOp *op, int ret)
 {
     MirrorBlockJob *s = op->s;
+    BlockDriverState *target_bs = blk_bs(s->target);
 
     if (ret < 0) {
         BlockErrorAction action;
@@ -270,7 +271,18 @@ static void coroutine_fn mirror_read_complete(MirrorOp *op, int ret)
         return;
     }
 
-    ret = blk_co_pwritev(s->target, op->offset, op->qiov.size, &op->qiov, 0);
+    /*
+     * Zeroes read from the source need not be written out as data.  If the
+     * target has detect-zeroes enabled, the block layer does this already.
+     */
+    if (target_bs->detect_zeroes == BLOCKDEV_DETECT_ZEROES_OPTIONS_OFF &&
+        qemu_iovec_is_zero(&op->qiov, 0, op->qiov.size)) {
+        ret = blk_co_pwrite_zeroes(s->target, op->offset, op->qiov.size,
+                                   s->unmap ? BDRV_REQ_MAY_UNMAP : 0);
+    } else {
+        ret = blk_co_pwritev(s->target, op->offset, op->qiov.size,
+                             &op->qiov, 0);
+    }
     mirror_write_complete(op, ret);
 }
 
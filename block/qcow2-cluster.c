@@ -908,7 +908,8 @@ perform_cow(BlockDriverState *bs, QCowL2Meta *m)
     /* If we have to read both the start and end COW regions and the
      * middle region is not too large then perform just one read
      * operation */
-    merge_reads = start->nb_bytes && end->nb_bytes && data_bytes <= 16384;
+    merge_reads = start->nb_bytes && end->nb_bytes &&
+                  !start->zero && !end->zero && data_bytes <= 16384;
     if (merge_reads) {
         buffer_size = start->nb_bytes + data_bytes + end->nb_bytes;
     } else {
@@ -940,20 +941,30 @@ perform_cow(BlockDriverState *bs, QCowL2Meta *m)
     qemu_co_mutex_unlock(&s->lock);
     /* First we read the existing data from both COW regions. We
      * either read the whole region in one go, or the start and end
-     * regions separately. */
+     * regions separately. Regions that are known to be zero are
+     * not read at all. */
     if (merge_reads) {
         qemu_iovec_add(&qiov, start_buffer, buffer_size);
         ret = do_perform_cow_read(bs, m->offset, start->offset, &qiov);
     } else {
-        qemu_iovec_add(&qiov, start_buffer, start->nb_bytes);
-        ret = do_perform_cow_read(bs, m->offset, start->offset, &qiov);
-        if (ret < 0) {
-            goto fail;
+        if (start->zero) {
+            memset(start_buffer, 0, start->nb_bytes);
+        } else {
+            qemu_iovec_add(&qiov, start_buffer, start->nb_bytes);
+            ret = do_perform_cow_read(bs, m->offset, start->offset, &qiov);
+            if (ret < 0) {
+                goto fail;
+            }
         }
 
-        qemu_iovec_reset(&qiov);
-        qemu_iovec_add(&qiov, end_buffer, end->nb_bytes);
-        ret = do_perform_cow_read(bs, m->offset, end->offset, &qiov);
+        if (end->zero) {
+            memset(end_buffer, 0, end->nb_bytes);
+            ret = 0;
+        } else {
+            qemu_iovec_reset(&qiov);
+            qemu_iovec_add(&qiov, end_buffer, end->nb_bytes);
+            ret = do_perform_cow_read(bs, m->offset, end->offset, &qiov);
+        }
     }
     if (ret < 0) {
         goto fail;
@@ -1136,6 +1147,25 @@ void coroutine_fn qcow2_alloc_cluster_abort(BlockDriverState *bs, QCowL2Meta *m)
     }
 }
 
+/*
+ * Returns true if a subcluster of type @type reads as zeroes without
+ * looking at its data.
+ */
+static bool GRAPH_RDLOCK
+subcluster_reads_as_zero(BlockDriverState *bs, QCow2SubclusterType type)
+{
+    switch (type) {
+    case QCOW2_SUBCLUSTER_ZERO_PLAIN:
+    case QCOW2_SUBCLUSTER_ZERO_ALLOC:
+        return true;
+    case QCOW2_SUBCLUSTER_UNALLOCATED_PLAIN:
+    case QCOW2_SUBCLUSTER_UNALLOCATED_ALLOC:
+        return !bs->backing;
+    default:
+        return false;
+    }
+}
+
 /*
  * For a given write request, create a new QCowL2Meta structure, add
  * it to @m and the BDRVQcow2State.cluster_allocs list. If the write
@@ -1172,6 +1202,7 @@ calculate_l2_meta(BlockDriverState *bs, uint64_t host_cluster_offset,
     QCow2SubclusterType type;
     int i;
     bool skip_cow = keep_old;
+    bool cow_start_zero, cow_end_zero;
 
     assert(nb_clusters <= s->l2_slice_size - l2_index);
 
@@ -1253,6 +1284,13 @@ calculate_l2_meta(BlockDriverState *bs, uint64_t host_cluster_offset,
         }
     }
 
+    /*
+     * The COW region is known to be zero if it lies within the subcluster
+     * of the first write, and that subcluster reads as zeroes.
+     */
+    cow_start_zero = cow_start_from >= (sc_index << s->subcluster_bits) &&
+                     subcluster_reads_as_zero(bs, type);
+
     /* Get the L2 entry of the last cluster */
     l2_index += nb_clusters - 1;
     l2_entry = get_l2_entry(s, l2_slice, l2_index);
@@ -1298,6 +1336,10 @@ calculate_l2_meta(BlockDriverState *bs, uint64_t host_cluster_offset,
         }
     }
 
+    cow_end_zero = cow_end_to <= ((nb_clusters - 1) << s->cluster_bits) +
+                                 ((sc_index + 1) << s->subcluster_bits) &&
+                   subcluster_reads_as_zero(bs, type);
+
     *m = g_malloc0(sizeof(**m));
     **m = (QCowL2Meta) {
         .next           = old_m,
@@ -1311,10 +1353,12 @@ calculate_l2_meta(BlockDriverState *bs, uint64_t host_cluster_offset,
         .cow_start = {
             .offset     = cow_start_from,
             .nb_bytes   = cow_start_to - cow_start_from,
+            .zero       = cow_start_zero,
         },
         .cow_end = {
             .offset     = cow_end_from,
             .nb_bytes   = cow_end_to - cow_end_from,
+            .zero       = cow_end_zero,
         },
     };
 
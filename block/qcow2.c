@@ -817,6 +817,18 @@ static QemuOptsList qcow2_runtime_opts = {
             .type = QEMU_OPT_NUMBER,
             .help = "Clean unused cache entries after this time (in seconds)",
         },
+        {
+            .name = QCOW2_OPT_METADATA_WRITEBACK_DELAY,
+            .type = QEMU_OPT_NUMBER,
+            .help = "Write back dirty metadata this long after it was "
+                    "modified (in milliseconds, 0 = only on flush)",
+        },
+        {
+            .name = QCOW2_OPT_MAX_THREADS,
+            .type = QEMU_OPT_NUMBER,
+            .help = "Maximum number of concurrent compression, decompression "
+                    "and encryption jobs in the thread pool",
+        },
         BLOCK_CRYPTO_OPT_DEF_KEY_SECRET("encrypt.",
             "ID of secret providing qcow2 AES key or LUKS passphrase"),
         { /* end of list */ }
@@ -939,15 +951,119 @@ cache_clean_timer_del_and_wait(BlockDriverState *bs)
     }
 }
 
+static void coroutine_fn metadata_writeback_entry(void *opaque)
+{
+    BlockDriverState *bs = opaque;
+    BDRVQcow2State *s = bs->opaque;
+
+    GRAPH_RDLOCK_GUARD();
+
+    WITH_QEMU_LOCK_GUARD(&s->lock) {
+        /* On error the tables stay dirty and the next flush reports it */
+        qcow2_write_caches(bs);
+    }
+    bdrv_dec_in_flight(bs);
+}
+
+static void metadata_writeback_timer_cb(void *opaque)
+{
+    BlockDriverState *bs = opaque;
+    Coroutine *co = qemu_coroutine_create(metadata_writeback_entry, bs);
+
+    bdrv_inc_in_flight(bs);
+    qemu_coroutine_enter(co);
+}
+
+static void metadata_writeback_timer_init(BlockDriverState *bs,
+                                          AioContext *context)
+{
+    BDRVQcow2State *s = bs->opaque;
+
+    if (s->metadata_writeback_delay > 0) {
+        assert(!s->metadata_writeback_timer);
+        /*
+         * Use QEMU_CLOCK_VIRTUAL so we don't alter the image file while
+         * suspended for migration.
+         */
+        s->metadata_writeback_timer =
+            aio_timer_new(context, QEMU_CLOCK_VIRTUAL, SCALE_MS,
+                          metadata_writeback_timer_cb, bs);
+    }
+}
+
+static void metadata_writeback_timer_del(BlockDriverState *bs)
+{
+    BDRVQcow2State *s = bs->opaque;
+
+    if (s->metadata_writeback_timer) {
+        timer_free(s->metadata_writeback_timer);
+        s->metadata_writeback_timer = NULL;
+    }
+}
+
+/*
+ * Arm the metadata writeback timer after L2 or refcount tables have been
+ * modified, so that they are written back before the guest asks for a
+ * flush.  Modifications made until the timer fires are written together.
+ * Called holding s->lock.
+ */
+static void metadata_writeback_schedule(BlockDriverState *bs)
+{
+    BDRVQcow2State *s = bs->opaque;
+
+    if (!s->metadata_writeback_timer) {
+        return;
+    }
+    if (qatomic_read(&bs->quiesce_counter)) {
+        s->metadata_writeback_deferred = true;
+    } else if (!timer_pending(s->metadata_writeback_timer)) {
+        timer_mod(s->metadata_writeback_timer,
+                  qemu_clock_get_ms(QEMU_CLOCK_VIRTUAL) +
+                  s->metadata_writeback_delay);
+    }
+}
+
+static void qcow2_drain_begin(BlockDriverState *bs)
+{
+    BDRVQcow2State *s = bs->opaque;
+
+    /*
+     * Write the tables back now rather than letting the timer fire inside
+     * the drained section, where it would start I/O behind the back of
+     * whoever drained us (e.g. a reopen that is about to free the timer).
+     */
+    if (s->metadata_writeback_timer &&
+        timer_pending(s->metadata_writeback_timer)) {
+        Coroutine *co;
+
+        timer_del(s->metadata_writeback_timer);
+        co = qemu_coroutine_create(metadata_writeback_entry, bs);
+        bdrv_inc_in_flight(bs);
+        aio_co_enter(bdrv_get_aio_context(bs), co);
+    }
+}
+
+static void qcow2_drain_end(BlockDriverState *bs)
+{
+    BDRVQcow2State *s = bs->opaque;
+
+    if (s->metadata_writeback_deferred) {
+        s->metadata_writeback_deferred = false;
+        metadata_writeback_schedule(bs);
+    }
+}
+
 static void qcow2_detach_aio_context(BlockDriverState *bs)
 {
     cache_clean_timer_del_and_wait(bs);
+    metadata_writeback_timer_del(bs);
 }
 
 static void qcow2_attach_aio_context(BlockDriverState *bs,
                                      AioContext *new_context)
 {
     cache_clean_timer_init(bs, new_context);
+    metadata_writeback_timer_init(bs, new_context);
 }
 
 static bool read_cache_sizes(BlockDriverState *bs, QemuOpts *opts,
@@ -1051,6 +1167,8 @@ typedef struct Qcow2ReopenState {
     bool discard_passthrough[QCOW2_DISCARD_MAX];
     bool discard_no_unref;
     uint64_t cache_clean_interval;
+    uint64_t metadata_writeback_delay;
+    uint64_t max_threads;
     QCryptoBlockOpenOptions *crypto_opts; /* Disk encryption runtime options */
 } Qcow2ReopenState;
 
@@ -1151,6 +1269,23 @@ qcow2_update_options_prepare(BlockDriverState *bs, Qcow2ReopenState *r,
         goto fail;
     }
 
+    r->metadata_writeback_delay =
+        qemu_opt_get_number(opts, QCOW2_OPT_METADATA_WRITEBACK_DELAY, 0);
+    if (r->metadata_writeback_delay > UINT_MAX) {
+        error_setg(errp, "Metadata writeback delay too big");
+        ret = -EINVAL;
+        goto fail;
+    }
+
+    r->max_threads = qemu_opt_get_number(opts, QCOW2_OPT_MAX_THREADS,
+                                         QCOW2_MAX_THREADS);
+    if (r->max_threads < 1 || r->max_threads > QCOW2_MAX_THREADS_LIMIT) {
+        error_setg(errp, QCOW2_OPT_MAX_THREADS " must be between 1 and %d",
+                   QCOW2_MAX_THREADS_LIMIT);
+        ret = -EINVAL;
+        goto fail;
+    }
+
     /* lazy-refcounts; flush if going from enabled to disabled */
     r->use_lazy_refcounts = qemu_opt_get_bool(opts, QCOW2_OPT_LAZY_REFCOUNTS,
         (s->compatible_features & QCOW2_COMPAT_LAZY_REFCOUNTS));
@@ -1303,6 +1438,7 @@ static void qcow2_update_options_commit(BlockDriverState *bs,
     } else {
         cache_clean_timer_del_and_wait(bs);
     }
+    metadata_writeback_timer_del(bs);
 
     if (s->l2_table_cache) {
         qcow2_cache_destroy(s->l2_table_cache);
@@ -1324,9 +1460,14 @@ static void qcow2_update_options_commit(BlockDriverState *bs,
 
     s->discard_no_unref = r->discard_no_unref;
 
+    s->max_threads = r->max_threads;
+
     s->cache_clean_interval = r->cache_clean_interval;
     cache_clean_timer_init(bs, bdrv_get_aio_context(bs));
 
+    s->metadata_writeback_delay = r->metadata_writeback_delay;
+    metadata_writeback_timer_init(bs, bdrv_get_aio_context(bs));
+
     qapi_free_QCryptoBlockOpenOptions(s->crypto_opts);
     s->crypto_opts = r->crypto_opts;
 }
@@ -1992,6 +2133,7 @@ qcow2_do_open(BlockDriverState *bs, QDict *options, int flags,
     /* else pre-write overlap checks in cache_destroy may crash */
     s->l1_table = NULL;
     cache_clean_timer_co_locked_del_and_wait(bs);
+    metadata_writeback_timer_del(bs);
     if (s->l2_table_cache) {
         qcow2_cache_destroy(s->l2_table_cache);
     }
@@ -2293,6 +2435,7 @@ qcow2_handle_l2meta(BlockDriverState *bs, QCowL2Meta **pl2meta, bool link_l2)
             if (ret) {
                 goto out;
             }
+            metadata_writeback_schedule(bs);
         } else {
             qcow2_alloc_cluster_abort(bs, l2meta);
         }
@@ -2595,18 +2738,27 @@ static bool merge_cow(uint64_t offset, unsigned bytes,
 static int coroutine_fn GRAPH_RDLOCK
 is_zero_cow(BlockDriverState *bs, QCowL2Meta *m)
 {
+    int ret;
+
     /*
      * This check is designed for optimization shortcut so it must be
      * efficient.
-     * Instead of is_zero(), use bdrv_co_is_zero_fast() as it is
-     * faster (but not as accurate and can result in false negatives).
+     * calculate_l2_meta() already knows about regions whose subcluster
+     * reads as zeroes.  For the others, use bdrv_co_is_zero_fast()
+     * instead of is_zero() as it is faster (but not as accurate and can
+     * result in false negatives).
      */
-    int ret = bdrv_co_is_zero_fast(bs, m->offset + m->cow_start.offset,
+    if (!m->cow_start.zero) {
+        ret = bdrv_co_is_zero_fast(bs, m->offset + m->cow_start.offset,
                                    m->cow_start.nb_bytes);
-    if (ret <= 0) {
-        return ret;
+        if (ret <= 0) {
+            return ret;
+        }
     }
 
+    if (m->cow_end.zero) {
+        return 1;
+    }
     return bdrv_co_is_zero_fast(bs, m->offset + m->cow_end.offset,
                                 m->cow_end.nb_bytes);
 }
@@ -2890,6 +3042,7 @@ qcow2_do_close(BlockDriverState *bs, bool close_data_file)
     }
 
     cache_clean_timer_del_and_wait(bs);
+    metadata_writeback_timer_del(bs);
     qcow2_cache_destroy(s->l2_table_cache);
     qcow2_cache_destroy(s->refcount_block_cache);
 
@@ -4261,6 +4414,7 @@ qcow2_co_pwrite_zeroes(BlockDriverState *bs, int64_t offset, int64_t bytes,
 
     /* Whatever is left can use real zero subclusters */
     ret = qcow2_subcluster_zeroize(bs, offset, bytes, flags);
+    metadata_writeback_schedule(bs);
     qemu_co_mutex_unlock(&s->lock);
 
     return ret;
@@ -4291,6 +4445,7 @@ qcow2_co_pdiscard(BlockDriverState *bs, int64_t offset, int64_t bytes)
     qemu_co_mutex_lock(&s->lock);
     ret = qcow2_cluster_discard(bs, offset, bytes, QCOW2_DISCARD_REQUEST,
                                 false);
+    metadata_writeback_schedule(bs);
     qemu_co_mutex_unlock(&s->lock);
     return ret;
 }
@@ -6356,6 +6511,8 @@ BlockDriver bdrv_qcow2 = {
 
     .bdrv_detach_aio_context            = qcow2_detach_aio_context,
     .bdrv_attach_aio_context            = qcow2_attach_aio_context,
+    .bdrv_drain_begin                   = qcow2_drain_begin,
+    .bdrv_drain_end                     = qcow2_drain_end,
 
     .bdrv_supports_persistent_dirty_bitmap =
             qcow2_supports_persistent_dirty_bitmap,
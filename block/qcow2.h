@@ -151,6 +151,8 @@
 #define QCOW2_OPT_L2_CACHE_ENTRY_SIZE "l2-cache-entry-size"
 #define QCOW2_OPT_REFCOUNT_CACHE_SIZE "refcount-cache-size"
 #define QCOW2_OPT_CACHE_CLEAN_INTERVAL "cache-clean-interval"
+#define QCOW2_OPT_METADATA_WRITEBACK_DELAY "metadata-writeback-delay"
+#define QCOW2_OPT_MAX_THREADS "max-threads"
 
 typedef struct QCowHeader {
     uint32_t magic;
@@ -323,7 +325,10 @@ typedef struct Qcow2BitmapHeaderExt {
     uint64_t bitmap_directory_offset;
 } QEMU_PACKED Qcow2BitmapHeaderExt;
 
+/* Default for max-threads */
 #define QCOW2_MAX_THREADS 4
+/* Upper limit for max-threads */
+#define QCOW2_MAX_THREADS_LIMIT 64
 
 typedef struct BDRVQcow2State {
     int cluster_bits;
@@ -351,6 +356,11 @@ typedef struct BDRVQcow2State {
     unsigned cache_clean_interval;
     QemuCoSleep cache_clean_timer_wake;
     CoQueue cache_clean_timer_exit;
+    /* Non-NULL if metadata-writeback-delay is set */
+    QEMUTimer *metadata_writeback_timer;
+    unsigned metadata_writeback_delay;
+    /* Tables were modified while drained, arm the timer on drain_end */
+    bool metadata_writeback_deferred;
 
     QLIST_HEAD(, QCowL2Meta) cluster_allocs;
 
@@ -414,6 +424,7 @@ typedef struct BDRVQcow2State {
 
     CoQueue thread_task_queue;
     int nb_threads;
+    int max_threads;
 
     BdrvChild *data_file;
 
@@ -437,6 +448,12 @@ typedef struct Qcow2COWRegion {
 
     /** Number of bytes to copy */
     unsigned    nb_bytes;
+
+    /**
+     * The region is known to read as zeroes, so it does not need to be
+     * read from the old cluster or the backing file.
+     */
+    bool        zero;
 } Qcow2COWRegion;
 
 /**
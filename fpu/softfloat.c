@@ -2632,7 +2632,8 @@ float16 float64_to_float16(float64 a, bool ieee, float_status *s)
     return float16a_round_pack_canonical(&p, s, fmt);
 }
 
-float32 float64_to_float32(float64 a, float_status *s)
+static float32 QEMU_SOFTFLOAT_ATTR
+soft_float64_to_float32(float64 a, float_status *s)
 {
     FloatParts64 p = float64_unpack_canonical(a, s);
 
@@ -2640,6 +2641,27 @@ float32 float64_to_float32(float64 a, float_status *s)
     return float32_round_pack_canonical(&p, s);
 }
 
+float32 float64_to_float32(float64 a, float_status *s)
+{
+    union_float64 ud;
+    union_float32 uf;
+
+    /*
+     * The host narrowing conversion rounds like us under can_use_fpu,
+     * and inexact is already set.  Leave inputs that are tiny for float32,
+     * whatever the tininess detection mode, and overflow to softfloat.
+     */
+    ud.s = a;
+    if (likely(float64_is_normal(a) && fabs(ud.h) >= FLT_MIN) &&
+        can_use_fpu(s)) {
+        uf.h = ud.h;
+        if (likely(!f32_is_inf(uf))) {
+            return uf.s;
+        }
+    }
+    return soft_float64_to_float32(a, s);
+}
+
 float8_e4m3 bfloat16_to_float8_e4m3(bfloat16 a, bool saturate, float_status *s)
 {
     FloatParts64 p = bfloat16_unpack_canonical(a, s);
@@ -4061,6 +4083,31 @@ float128 uint128_to_float128(Int128 a, float_status *status)
  * Minimum and maximum
  */
 
+/*
+ * For zero and normal inputs, which raise no exceptions, the result
+ * is one of the inputs unchanged and can be picked by comparing the
+ * sign-magnitude encodings directly, as partsN(minmax) would.
+ */
+static inline bool minmax_pick_b(uint64_t a, uint64_t b,
+                                 uint64_t sign_bit, int flags)
+{
+    uint64_t a_mag = a & ~sign_bit, b_mag = b & ~sign_bit;
+    bool a_sign = a & sign_bit, b_sign = b & sign_bit;
+    int cmp = a_mag < b_mag ? -1 : a_mag > b_mag;
+
+    if (!(flags & float_minmax_ismag) || cmp == 0) {
+        if (a_sign != b_sign) {
+            cmp = a_sign ? -1 : 1;
+        } else if (a_sign) {
+            cmp = -cmp;
+        }
+    }
+    if (flags & float_minmax_ismin) {
+        cmp = -cmp;
+    }
+    return cmp < 0;
+}
+
 float16 float16_minmax(float16 a, float16 b, float_status *s, int flags)
 {
     FloatParts64 pa = float16_unpack_canonical(a, s);
@@ -4081,18 +4128,34 @@ bfloat16 bfloat16_minmax(bfloat16 a, bfloat16 b, float_status *s, int flags)
 
 float32 float32_minmax(float32 a, float32 b, float_status *s, int flags)
 {
-    FloatParts64 pa = float32_unpack_canonical(a, s);
-    FloatParts64 pb = float32_unpack_canonical(b, s);
-    FloatParts64 *pr = parts64_minmax(&pa, &pb, s, flags);
+    FloatParts64 pa, pb, *pr;
+
+    if (likely(float32_is_zero_or_normal(a) &&
+               float32_is_zero_or_normal(b))) {
+        return minmax_pick_b(float32_val(a), float32_val(b),
+                             1u << 31, flags) ? b : a;
+    }
+
+    pa = float32_unpack_canonical(a, s);
+    pb = float32_unpack_canonical(b, s);
+    pr = parts64_minmax(&pa, &pb, s, flags);
 
     return float32_round_pack_canonical(pr, s);
 }
 
 float64 float64_minmax(float64 a, float64 b, float_status *s, int flags)
 {
-    FloatParts64 pa = float64_unpack_canonical(a, s);
-    FloatParts64 pb = float64_unpack_canonical(b, s);
-    FloatParts64 *pr = parts64_minmax(&pa, &pb, s, flags);
+    FloatParts64 pa, pb, *pr;
+
+    if (likely(float64_is_zero_or_normal(a) &&
+               float64_is_zero_or_normal(b))) {
+        return minmax_pick_b(float64_val(a), float64_val(b),
+                             1ull << 63, flags) ? b : a;
+    }
+
+    pa = float64_unpack_canonical(a, s);
+    pb = float64_unpack_canonical(b, s);
+    pr = parts64_minmax(&pa, &pb, s, flags);
 
     return float64_round_pack_canonical(pr, s);
 }
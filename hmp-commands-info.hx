@@ -245,6 +245,21 @@ SRST
     Show dynamic compiler info.
 ERST
 
+#if defined(CONFIG_TCG)
+    {
+        .name       = "tb-profile",
+        .args_type  = "",
+        .params     = "",
+        .help       = "show the hottest translation blocks",
+    },
+#endif
+
+SRST
+  ``info tb-profile``
+    Show the translation blocks sampled by the TCG TB profiler, enabled
+    with ``-accel tcg,profile-hz=n``.
+ERST
+
     {
         .name       = "sync-profile",
         .args_type  = "mean:-m,no_coalesce:-n,max:i?",
@@ -640,17 +640,24 @@ SRST
 ERST
     {
         .name       = "sync-profile",
-        .args_type  = "op:s?",
-        .params     = "[on|off|reset]",
+        .args_type  = "op:s?,period:i?",
+        .params     = "[on [period]|off|reset]",
         .help       = "enable, disable or reset synchronization profiling. "
+                      "With 'on', only time one in every 'period' operations "
+                      "of each thread (default 1). "
                       "With no arguments, prints whether profiling is on or off.",
         .cmd        = hmp_sync_profile,
     },
 
 SRST
-``sync-profile [on|off|reset]``
+``sync-profile [on [period]|off|reset]``
   Enable, disable or reset synchronization profiling. With no arguments, prints
   whether profiling is on or off.
+
+  With ``on``, a *period* greater than 1 only times one in every *period*
+  operations of each thread, which keeps the overhead low enough to leave
+  profiling enabled on a running VM.  Reported wait times and acquisition
+  counts are scaled by *period*.
 ERST
 
     {
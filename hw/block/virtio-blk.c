@@ -14,6 +14,8 @@
 #include "qemu/osdep.h"
 #include "qemu/defer-call.h"
 #include "qapi/error.h"
+#include "qapi/qapi-visit-common.h"
+#include "qapi/visitor.h"
 #include "qemu/iov.h"
 #include "qemu/module.h"
 #include "qemu/error-report.h"
@@ -1873,6 +1875,117 @@ static void virtio_blk_device_unrealize(DeviceState *dev)
     virtio_cleanup(vdev);
 }
 
+/*
+ * Only IOThreads named in iothread-vq-mapping are valid targets, they are
+ * the ones virtio_blk_vq_aio_context_init() holds a reference to.
+ */
+static IOThread *virtio_blk_find_mapped_iothread(VirtIOBlock *s,
+                                                 const char *id)
+{
+    IOThreadVirtQueueMappingList *node;
+
+    for (node = s->conf.iothread_vq_mapping_list; node; node = node->next) {
+        if (!strcmp(node->value->iothread, id)) {
+            return iothread_by_id(id);
+        }
+    }
+    return NULL;
+}
+
+static void virtio_blk_get_vq_iothreads(Object *obj, Visitor *v,
+                                        const char *name, void *opaque,
+                                        Error **errp)
+{
+    VirtIOBlock *s = VIRTIO_BLK(obj);
+    IOThreadVirtQueueMappingList *node;
+    g_autoptr(strList) list = NULL;
+    strList **tail = &list;
+
+    for (uint16_t i = 0; s->vq_aio_context && i < s->conf.num_queues; i++) {
+        for (node = s->conf.iothread_vq_mapping_list; node;
+             node = node->next) {
+            IOThread *iothread = iothread_by_id(node->value->iothread);
+
+            if (iothread &&
+                iothread_get_aio_context(iothread) == s->vq_aio_context[i]) {
+                QAPI_LIST_APPEND(tail, g_strdup(node->value->iothread));
+                break;
+            }
+        }
+    }
+
+    visit_type_strList(v, name, &list, errp);
+}
+
+/*
+ * Move virtqueues between the IOThreads of iothread-vq-mapping at runtime.
+ * The value lists one IOThread id per virtqueue.  Picking the assignment
+ * is left to management, which can see per-IOThread load.
+ *
+ * Context: BQL held
+ */
+static void virtio_blk_set_vq_iothreads(Object *obj, Visitor *v,
+                                        const char *name, void *opaque,
+                                        Error **errp)
+{
+    VirtIOBlock *s = VIRTIO_BLK(obj);
+    g_autoptr(strList) list = NULL;
+    g_autofree AioContext **vq_aio_context = NULL;
+    BlockDriverState *bs;
+    strList *node;
+    uint16_t i = 0;
+
+    if (!visit_type_strList(v, name, &list, errp)) {
+        return;
+    }
+
+    if (!DEVICE(obj)->realized || !s->conf.iothread_vq_mapping_list) {
+        error_setg(errp, "%s can only be changed on a realized device "
+                   "with iothread-vq-mapping", name);
+        return;
+    }
+
+    vq_aio_context = g_new(AioContext *, s->conf.num_queues);
+    for (node = list; node; node = node->next, i++) {
+        IOThread *iothread;
+
+        if (i >= s->conf.num_queues) {
+            error_setg(errp, "%s has more entries than the device has "
+                       "virtqueues (%u)", name, s->conf.num_queues);
+            return;
+        }
+
+        iothread = virtio_blk_find_mapped_iothread(s, node->value);
+        if (!iothread) {
+            error_setg(errp, "IOThread \"%s\" is not part of "
+                       "iothread-vq-mapping", node->value);
+            return;
+        }
+        vq_aio_context[i] = iothread_get_aio_context(iothread);
+    }
+    if (i != s->conf.num_queues) {
+        error_setg(errp, "%s needs one entry per virtqueue (%u)",
+                   name, s->conf.num_queues);
+        return;
+    }
+
+    bs = blk_bs(s->blk);
+    if (!bs) {
+        error_setg(errp, "%s needs a medium", name);
+        return;
+    }
+
+    /*
+     * Draining detaches the host notifiers from the old AioContexts and
+     * waits for in-flight requests, virtio_blk_drained_end() then attaches
+     * them to the new ones.
+     */
+    bdrv_drained_begin(bs);
+    memcpy(s->vq_aio_context, vq_aio_context,
+           s->conf.num_queues * sizeof(AioContext *));
+    bdrv_drained_end(bs);
+}
+
 static void virtio_blk_instance_init(Object *obj)
 {
     VirtIOBlock *s = VIRTIO_BLK(obj);
@@ -1880,6 +1993,9 @@ static void virtio_blk_instance_init(Object *obj)
     device_add_bootindex_property(obj, &s->conf.conf.bootindex,
                                   "bootindex", "/disk@0,0",
                                   DEVICE(obj));
+    object_property_add(obj, "x-vq-iothreads", "strList",
+                        virtio_blk_get_vq_iothreads,
+                        virtio_blk_set_vq_iothreads, NULL, NULL);
 }
 
 static const VMStateDescription vmstate_virtio_blk = {
@@ -70,6 +70,7 @@ CPUState *cpu_create(const char *typename)
 
 void cpu_reset_interrupt(CPUState *cpu, int mask)
 {
+    qatomic_and(&cpu->quantum_interrupt_request, ~mask);
     qatomic_and(&cpu->interrupt_request, ~mask);
 }
 
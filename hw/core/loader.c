@@ -64,6 +64,7 @@
 #include "hw/core/boards.h"
 #include "qemu/cutils.h"
 #include "system/runstate.h"
+#include "system/startup-timing.h"
 #include "tcg/debuginfo.h"
 
 #include <zlib.h>
@@ -1088,6 +1089,7 @@ ssize_t rom_add_file(const char *file, const char *fw_dir,
     gsize size;
     g_autoptr(GError) gerr = NULL;
     char devpath[100];
+    int64_t t;
 
     if (as && mr) {
         fprintf(stderr, "Specifying an Address Space and Memory Region is " \
@@ -1104,12 +1106,14 @@ ssize_t rom_add_file(const char *file, const char *fw_dir,
         rom->path = g_strdup(file);
     }
 
+    t = startup_timing_begin();
     if (!g_file_get_contents(rom->path, (gchar **) &rom->data,
                              &size, &gerr)) {
         fprintf(stderr, "rom: file %-20s: error %s\n",
                 rom->name, gerr->message);
         goto err;
     }
+    startup_timing_end(STARTUP_EVENT_KIND_ROM, rom->name, t);
 
     if (fw_dir) {
         rom->fw_dir  = g_strdup(fw_dir);
@@ -262,6 +262,7 @@ static const uint32_t nvme_feature_cap[NVME_FID_MAX] = {
     [NVME_ERROR_RECOVERY]           = NVME_FEAT_CAP_CHANGE | NVME_FEAT_CAP_NS,
     [NVME_VOLATILE_WRITE_CACHE]     = NVME_FEAT_CAP_CHANGE,
     [NVME_NUMBER_OF_QUEUES]         = NVME_FEAT_CAP_CHANGE,
+    [NVME_INTERRUPT_COALESCING]     = NVME_FEAT_CAP_CHANGE,
     [NVME_WRITE_ATOMICITY]          = NVME_FEAT_CAP_CHANGE,
     [NVME_ASYNCHRONOUS_EVENT_CONF]  = NVME_FEAT_CAP_CHANGE,
     [NVME_TIMESTAMP]                = NVME_FEAT_CAP_CHANGE,
@@ -1513,12 +1514,61 @@ static void nvme_update_cq_head(NvmeCQueue *cq)
     trace_pci_nvme_update_cq_head(cq->cqid, cq->head);
 }
 
+/*
+ * Interrupt Coalescing does not apply to the interrupt vector of the Admin
+ * Completion Queue, which Get Features reports with Coalescing Disable
+ * set, so I/O queues sharing that vector are not coalesced either.  For
+ * other I/O queues, hold back the interrupt until more than THR entries have been
+ * posted since the last one, or until TIME * 100 microseconds have passed.
+ * A zero THR or TIME disables coalescing.
+ *
+ * Returns true if the interrupt for @cq should be delayed.
+ */
+static bool nvme_cq_coalesce(NvmeCtrl *n, NvmeCQueue *cq, uint32_t posted)
+{
+    uint8_t thr = NVME_INTC_THR(n->features.int_coalescing);
+    uint8_t time = NVME_INTC_TIME(n->features.int_coalescing);
+
+    if (cq->vector == n->admin_cq.vector || !thr || !time) {
+        return false;
+    }
+
+    if (!posted) {
+        /* nothing new, only re-assert if no interrupt is pending already */
+        return timer_pending(cq->coalesce_timer);
+    }
+
+    cq->coalesced += posted;
+    if (cq->coalesced > thr) {
+        cq->coalesced = 0;
+        timer_del(cq->coalesce_timer);
+        return false;
+    }
+
+    if (!timer_pending(cq->coalesce_timer)) {
+        timer_mod(cq->coalesce_timer,
+                  qemu_clock_get_us(QEMU_CLOCK_VIRTUAL) + time * 100);
+    }
+    return true;
+}
+
+static void nvme_cq_coalesce_timer_cb(void *opaque)
+{
+    NvmeCQueue *cq = opaque;
+
+    cq->coalesced = 0;
+    if (cq->tail != cq->head) {
+        nvme_irq_assert(cq->ctrl, cq);
+    }
+}
+
 static void nvme_post_cqes(void *opaque)
 {
     NvmeCQueue *cq = opaque;
     NvmeCtrl *n = cq->ctrl;
     NvmeRequest *req, *next;
     bool pending = cq->head != cq->tail;
+    uint32_t posted = 0;
     int ret;
 
     QTAILQ_FOREACH_SAFE(req, &cq->req_list, entry, next) {
@@ -1562,6 +1612,7 @@ static void nvme_post_cqes(void *opaque)
         QTAILQ_REMOVE(&cq->req_list, req, entry);
 
         nvme_inc_cq_tail(cq);
+        posted++;
 
         if (QTAILQ_EMPTY(&sq->req_list) && !nvme_sq_empty(sq)) {
             qemu_bh_schedule(sq->bh);
@@ -1574,7 +1625,9 @@ static void nvme_post_cqes(void *opaque)
             n->cq_pending++;
         }
 
-        nvme_irq_assert(n, cq);
+        if (!nvme_cq_coalesce(n, cq, posted)) {
+            nvme_irq_assert(n, cq);
+        }
     }
 }
 
@@ -5569,6 +5622,7 @@ static void nvme_free_cq(NvmeCQueue *cq, NvmeCtrl *n)
 
     n->cq[cq->cqid] = NULL;
     qemu_bh_delete(cq->bh);
+    timer_free(cq->coalesce_timer);
     if (cq->ioeventfd_enabled) {
         memory_region_del_eventfd(&n->iomem,
                                   0x1000 + offset, 4, false, 0, &cq->notifier);
@@ -5634,6 +5688,9 @@ static void __nvme_init_cq(NvmeCQueue *cq)
     n->cq[cqid] = cq;
     cq->bh = qemu_bh_new_guarded(nvme_post_cqes, cq,
                                  &DEVICE(cq->ctrl)->mem_reentrancy_guard);
+    cq->coalesce_timer = timer_new_us(QEMU_CLOCK_VIRTUAL,
+                                      nvme_cq_coalesce_timer_cb, cq);
+    cq->coalesced = 0;
 }
 
 static void nvme_init_cq(NvmeCQueue *cq, NvmeCtrl *n, uint64_t dma_addr,
@@ -6469,6 +6526,9 @@ static uint16_t nvme_get_feature(NvmeCtrl *n, NvmeRequest *req)
     case NVME_ASYNCHRONOUS_EVENT_CONF:
         result = n->features.async_config;
         goto out;
+    case NVME_INTERRUPT_COALESCING:
+        result = n->features.int_coalescing;
+        goto out;
     case NVME_TIMESTAMP:
         return nvme_get_feature_timestamp(n, req);
     case NVME_HOST_BEHAVIOR_SUPPORT:
@@ -6811,6 +6871,9 @@ static uint16_t nvme_set_feature(NvmeCtrl *n, NvmeRequest *req)
     case NVME_ASYNCHRONOUS_EVENT_CONF:
         n->features.async_config = dw11;
         break;
+    case NVME_INTERRUPT_COALESCING:
+        n->features.int_coalescing = dw11 & 0xffff;
+        break;
     case NVME_TIMESTAMP:
         return nvme_set_feature_timestamp(n, req);
     case NVME_HOST_BEHAVIOR_SUPPORT:
@@ -10468,6 +10531,24 @@ static bool nvme_ctrl_post_load(void *opaque, int version_id, Error **errp)
     return true;
 }
 
+static bool nvme_int_coalescing_needed(void *opaque)
+{
+    NvmeCtrl *n = opaque;
+
+    return n->features.int_coalescing != 0;
+}
+
+static const VMStateDescription nvme_vmstate_int_coalescing = {
+    .name = "nvme/int-coalescing",
+    .version_id = 1,
+    .minimum_version_id = 1,
+    .needed = nvme_int_coalescing_needed,
+    .fields = (const VMStateField[]) {
+        VMSTATE_UINT32(features.int_coalescing, NvmeCtrl),
+        VMSTATE_END_OF_LIST()
+    },
+};
+
 static const VMStateDescription nvme_vmstate = {
     .name = "nvme",
     .minimum_version_id = 1,
@@ -10526,6 +10607,10 @@ static const VMStateDescription nvme_vmstate = {
 
         VMSTATE_END_OF_LIST()
     },
+    .subsections = (const VMStateDescription * const []) {
+        &nvme_vmstate_int_coalescing,
+        NULL
+    },
 };
 
 static void nvme_class_init(ObjectClass *oc, const void *data)
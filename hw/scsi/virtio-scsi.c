@@ -18,6 +18,7 @@
 #include "standard-headers/linux/virtio_ids.h"
 #include "hw/virtio/virtio-scsi.h"
 #include "migration/qemu-file-types.h"
+#include "qemu/coroutine.h"
 #include "qemu/defer-call.h"
 #include "qemu/error-report.h"
 #include "qemu/iov.h"
@@ -1346,7 +1347,15 @@ static void virtio_scsi_device_realize(DeviceState *dev, Error **errp)
     /* override default SCSI bus hotplug-handler, with virtio-scsi's one */
     qbus_set_hotplug_handler(BUS(&s->bus), OBJECT(dev));
 
-    virtio_scsi_dataplane_setup(s, errp);
+    virtio_scsi_dataplane_setup(s, &err);
+    if (err != NULL) {
+        error_propagate(errp, err);
+        return;
+    }
+
+    /* scsi-disk submits every request through a block layer coroutine */
+    qemu_coroutine_inc_pool_size(s->parent_obj.conf.num_queues *
+                                 s->parent_obj.conf.virtqueue_size / 2);
 }
 
 void virtio_scsi_common_unrealize(DeviceState *dev)
@@ -1369,6 +1378,8 @@ static void virtio_scsi_device_unrealize(DeviceState *dev)
 {
     VirtIOSCSI *s = VIRTIO_SCSI(dev);
 
+    qemu_coroutine_dec_pool_size(s->parent_obj.conf.num_queues *
+                                 s->parent_obj.conf.virtqueue_size / 2);
     virtio_scsi_dataplane_cleanup(s);
     qbus_set_hotplug_handler(BUS(&s->bus), NULL);
     virtio_scsi_common_unrealize(dev);
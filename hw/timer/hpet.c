@@ -646,6 +646,7 @@ static const MemoryRegionOps hpet_ram_ops = {
         .max_access_size = 8,
     },
     .endianness = DEVICE_LITTLE_ENDIAN,
+    .lockless_io = true,
 };
 
 static void hpet_reset(DeviceState *d)
@@ -707,7 +708,6 @@ static void hpet_init(Object *obj)
     seqlock_init(&s->state_version);
     /* HPET Area */
     memory_region_init_io(&s->iomem, obj, &hpet_ram_ops, s, "hpet", HPET_LEN);
-    memory_region_enable_lockless_io(&s->iomem);
     sysbus_init_mmio(sbd, &s->iomem);
 }
 
@@ -84,11 +84,17 @@ uint16_t vhost_svq_available_slots(const VhostShadowVirtqueue *svq)
  * @iovec: Source qemu's VA addresses
  * @num: Length of iovec and minimum length of vaddr
  * @gpas: Descriptors' GPAs, if backed by guest memory
+ *
+ * Buffers of one chain usually fall into the same guest memory region, so
+ * the map found for a segment is tried first for the next one before
+ * searching the tree again.
  */
 static bool vhost_svq_translate_addr(const VhostShadowVirtqueue *svq,
                                      hwaddr *addrs, const struct iovec *iovec,
                                      size_t num, const hwaddr *gpas)
 {
+    const DMAMap *map = NULL;
+
     if (num == 0) {
         return true;
     }
@@ -96,23 +102,30 @@ static bool vhost_svq_translate_addr(const VhostShadowVirtqueue *svq,
     for (size_t i = 0; i < num; ++i) {
         Int128 needle_last, map_last;
         size_t off;
-        const DMAMap *map;
         DMAMap needle;
 
+        needle = (DMAMap) {
+            .translated_addr = gpas ? gpas[i] :
+                               (hwaddr)(uintptr_t)iovec[i].iov_base,
+            .size = iovec[i].iov_len,
+        };
+        needle_last = int128_add(int128_make64(needle.translated_addr),
+                                 int128_makes64(iovec[i].iov_len - 1));
+
+        if (map && needle.translated_addr >= map->translated_addr &&
+            !int128_gt(needle_last,
+                       int128_make64(map->translated_addr + map->size))) {
+            addrs[i] = map->iova + (needle.translated_addr -
+                                    map->translated_addr);
+            continue;
+        }
+
         /* Check if the descriptor is backed by guest memory  */
         if (gpas) {
             /* Search the GPA->IOVA tree */
-            needle = (DMAMap) {
-                .translated_addr = gpas[i],
-                .size = iovec[i].iov_len,
-            };
             map = vhost_iova_tree_find_gpa(svq->iova_tree, &needle);
         } else {
             /* Search the IOVA->HVA tree */
-            needle = (DMAMap) {
-                .translated_addr = (hwaddr)(uintptr_t)iovec[i].iov_base,
-                .size = iovec[i].iov_len,
-            };
             map = vhost_iova_tree_find_iova(svq->iova_tree, &needle);
         }
 
@@ -130,8 +143,6 @@ static bool vhost_svq_translate_addr(const VhostShadowVirtqueue *svq,
         off = needle.translated_addr - map->translated_addr;
         addrs[i] = map->iova + off;
 
-        needle_last = int128_add(int128_make64(needle.translated_addr),
-                                 int128_makes64(iovec[i].iov_len - 1));
         map_last = int128_make64(map->translated_addr + map->size);
         if (unlikely(int128_gt(needle_last, map_last))) {
             qemu_log_mask(LOG_GUEST_ERROR,
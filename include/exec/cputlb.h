@@ -49,7 +49,8 @@ void tlb_reset_dirty_range_all(ram_addr_t start, ram_addr_t length);
  *
  * At most one entry for a given virtual address is permitted. Only a
  * single TARGET_PAGE_SIZE region is mapped; @full->lg_page_size is only
- * used by tlb_flush_page.
+ * used by tlb_flush_page.  If @full->lg_contig_size is set, later misses
+ * within the same guest huge page are filled from @full directly.
  */
 void tlb_set_page_full(CPUState *cpu, int mmu_idx, vaddr addr,
                        CPUTLBEntryFull *full);
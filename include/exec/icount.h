@@ -43,6 +43,12 @@ extern ICountMode use_icount;
  */
 void icount_update(CPUState *cpu);
 
+/*
+ * With multi-threaded icount, add the instructions that all vCPUs
+ * executed during the quantum that just ended to the icount.
+ */
+void icount_quantum_publish(void);
+
 /* get raw icount value */
 int64_t icount_get_raw(void);
 
@@ -203,8 +203,26 @@ struct CPUClass {
 #define NB_MMU_MODES 22
 typedef uint32_t MMUIdxMap;
 
-/* Use a fully associative victim tlb of 8 entries. */
+/*
+ * Use a fully associative victim tlb of 8 entries by default.
+ * The size may be raised, up to CPU_VTLB_MAX_SIZE, with the
+ * tlb-victim-size accelerator property.
+ */
 #define CPU_VTLB_SIZE 8
+#define CPU_VTLB_MAX_SIZE 256
+
+/*
+ * Number of remote page or range flushes that may be queued for a cpu
+ * before they are folded into a flush of the entire mmu_idx.
+ */
+#define CPU_TLB_PENDING_SIZE 16
+
+typedef struct CPUTLBPendingFlush {
+    vaddr addr;
+    vaddr len;
+    MMUIdxMap idxmap;
+    unsigned bits;
+} CPUTLBPendingFlush;
 
 /*
  * The full TLB entry, which is not accessed by generated TCG code,
@@ -239,6 +257,16 @@ struct CPUTLBEntryFull {
     /* @lg_page_size contains the log2 of the page size. */
     uint8_t lg_page_size;
 
+    /*
+     * @lg_contig_size, if larger than TARGET_PAGE_BITS and no larger
+     * than @lg_page_size, is the log2 of the size of the naturally
+     * aligned region around the page whose translation is identical,
+     * apart from the offset into @phys_addr: i.e. a guest huge page.
+     * Other pages of the region may then be entered into the tlb
+     * without calling tlb_fill again.  Zero if unknown.
+     */
+    uint8_t lg_contig_size;
+
     /* Additional tlb flags requested by tlb_fill. */
     uint8_t tlb_fill_flags;
 
@@ -290,9 +318,20 @@ typedef struct CPUTLBDesc {
     size_t n_used_entries;
     /* The next index to use in the tlb victim table.  */
     size_t vindex;
+    /* The number of entries in the tlb victim table; a power of 2.  */
+    size_t vsize;
     /* The tlb victim table, in two parts.  */
-    CPUTLBEntry vtable[CPU_VTLB_SIZE];
-    CPUTLBEntryFull vfulltlb[CPU_VTLB_SIZE];
+    CPUTLBEntry *vtable;
+    CPUTLBEntryFull *vfulltlb;
+    /*
+     * The most recent fill of a page within a guest huge page, as
+     * described by CPUTLBEntryFull.lg_contig_size, together with its
+     * page address, or -1 if none.  Cleared when the mmu_idx is flushed;
+     * since the huge page is also covered by large_page_addr, any page
+     * flush within it flushes the entire mmu_idx.
+     */
+    vaddr lp_fill_addr;
+    CPUTLBEntryFull lp_fill;
     CPUTLBEntryFull *fulltlb;
 } CPUTLBDesc;
 
@@ -308,6 +347,16 @@ typedef struct CPUTLBCommon {
      * Protected by tlb_c.lock.
      */
     MMUIdxMap dirty;
+    /*
+     * Flushes requested by other cpus, accumulated until this cpu next
+     * processes its queued work.  Contiguous requests are merged, and
+     * once the queue overflows the remainder is folded into pending_full.
+     * Protected by tlb_c.lock.
+     */
+    bool pending_queued;
+    MMUIdxMap pending_full;
+    unsigned pending_count;
+    CPUTLBPendingFlush pending[CPU_TLB_PENDING_SIZE];
     /*
      * Statistics.  These are not lock protected, but are read and
      * written atomically.  This allows the monitor to print a snapshot
@@ -316,6 +365,7 @@ typedef struct CPUTLBCommon {
     size_t full_flush_count;
     size_t part_flush_count;
     size_t elide_flush_count;
+    size_t coalesce_flush_count;
 } CPUTLBCommon;
 
 /*
@@ -433,6 +483,8 @@ struct qemu_work_item;
  *   the one provided by cpu_exit(), especially when processing interrupt
  *   flags.  In this case, the write and read happen in the same thread
  *   and the write therefore can use qemu_atomic_set().
+ * @tb_profile_pending: Set by the TCG TB profiler to ask the vCPU thread
+ *   to record the TB it exits from at the next forced exit.
  * @interrupt_request: Indicates a pending interrupt request.
  *   Only used by system emulation.
  * @halted: Nonzero if the CPU is in suspended state.
@@ -442,6 +494,13 @@ struct qemu_work_item;
  * @crash_occurred: Indicates the OS reported a crash (panic) for this CPU
  * @singlestep_flags: Flags for single-stepping.
  * @icount_extra: Instructions until next timer event.
+ * @icount_quantum_left: Instructions left in the current icount quantum.
+ * @icount_quantum_done: Instructions executed in the current icount
+ *   quantum, not yet added to the global instruction counter.
+ * @icount_quantum_gen: Last icount quantum this CPU took part in.
+ * @icount_quantum_active: The CPU is executing the current icount quantum.
+ * @quantum_interrupt_request: Interrupts raised by other vCPUs during
+ *   the current icount quantum, delivered at its end.
  * @cpu_ases: Pointer to array of CPUAddressSpaces (which define the
  *            AddressSpaces this CPU has)
  * @as: Pointer to the first AddressSpace, for the convenience of targets which
@@ -502,12 +561,18 @@ struct CPUState {
     bool unplug;
     bool crash_occurred;
     bool exit_request;
+    bool tb_profile_pending;
     int exclusive_context_count;
     uint32_t cflags_next_tb;
     uint32_t interrupt_request;
     unsigned singlestep_flags;
     int64_t icount_budget;
     int64_t icount_extra;
+    int64_t icount_quantum_left;
+    int64_t icount_quantum_done;
+    unsigned icount_quantum_gen;
+    bool icount_quantum_active;
+    uint32_t quantum_interrupt_request;
     uint64_t random_seed;
     sigjmp_buf jmp_env;
 
@@ -37,6 +37,7 @@ OBJECT_DECLARE_TYPE(QIOChannel, QIOChannelClass,
 #define QIO_CHANNEL_READ_FLAG_MSG_PEEK 0x1
 #define QIO_CHANNEL_READ_FLAG_RELAXED_EOF 0x2
 #define QIO_CHANNEL_READ_FLAG_FD_PRESERVE_BLOCKING 0x4
+#define QIO_CHANNEL_READ_FLAG_WAITALL 0x8
 
 typedef enum QIOChannelFeature QIOChannelFeature;
 
@@ -257,6 +258,13 @@ void qio_channel_set_name(QIOChannel *ioc,
  * unless qio_channel_has_feature() returns a true
  * value for the QIO_CHANNEL_FEATURE_FD_PASS constant.
  *
+ * If QIO_CHANNEL_READ_FLAG_WAITALL is set, channels
+ * that support it will try to fill all of @iov before
+ * returning, saving a wakeup per partially filled
+ * read. This is only a hint: a short read is still
+ * possible, e.g. on a signal, EOF, or a non-blocking
+ * channel, so callers must be prepared to handle it.
+ *
  * Returns: the number of bytes read, or -1 on error,
  * or QIO_CHANNEL_ERR_BLOCK if no data is available
  * and the channel is non-blocking
@@ -315,6 +315,17 @@ struct AioContext {
     /* AIO engine parameters */
     int64_t aio_max_batch;  /* maximum number of requests in a batch */
 
+    /*
+     * Event loop accounting for query-stats, only written by the home
+     * thread.  The times reuse the timestamps taken for adaptive polling,
+     * so they do not advance while polling is disabled.
+     */
+    uint64_t poll_hits;         /* polling found an event */
+    uint64_t poll_misses;       /* polling timed out, fell back to fdmon */
+    uint64_t poll_time_ns;      /* time spent polling */
+    uint64_t idle_time_ns;      /* time spent polling or blocked in fdmon */
+    uint64_t dispatch_time_ns;  /* time spent running callbacks */
+
     /*
      * List of handlers participating in userspace polling.  Protected by
      * ctx->list_lock.  Iterated and modified mostly by the event loop thread
@@ -51,6 +51,9 @@
 #ifndef bit_BMI2
 #define bit_BMI2        (1 << 8)
 #endif
+#ifndef bit_RTM
+#define bit_RTM         (1 << 11)
+#endif
 #ifndef bit_AVX512F
 #define bit_AVX512F     (1 << 16)
 #endif
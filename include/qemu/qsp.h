@@ -22,6 +22,8 @@ void qsp_report(size_t max, enum QSPSortBy sort_by,
 bool qsp_is_enabled(void);
 void qsp_enable(void);
 void qsp_disable(void);
+void qsp_set_sample_period(unsigned int period);
+unsigned int qsp_get_sample_period(void);
 void qsp_reset(void);
 
 #endif /* QEMU_QSP_H */
@@ -314,6 +314,11 @@ struct MemoryRegionOps {
                                     MemTxAttrs attrs);
 
     enum device_endian endianness;
+    /*
+     * If true, the callbacks are invoked without the BQL, as with
+     * memory_region_enable_lockless_io(), and must do their own locking.
+     */
+    bool lockless_io;
     /* Guest-visible constraints: */
     struct {
         /* If nonzero, specify bounds on access sizes beyond which a machine
@@ -941,6 +946,8 @@ struct FlatView {
     unsigned nr_allocated;
     struct AddressSpaceDispatch *dispatch;
     MemoryRegion *root;
+    /* Unique and never reused, unlike the FlatView's address. */
+    uint64_t gen;
 };
 
 static inline FlatView *address_space_to_flatview(const AddressSpace *as)
@@ -2029,7 +2036,10 @@ void memory_region_clear_flush_coalesced(MemoryRegion *mr);
  *
  * Enable BQL-free access for devices that are well prepared to handle
  * locking during I/O themselves: either by doing fine grained locking or
- * by providing lock-free I/O schemes.
+ * by providing lock-free I/O schemes.  Devices whose callbacks are always
+ * safe to call without the BQL can instead set
+ * #MemoryRegionOps.lockless_io, which enables this for every region
+ * initialized with those ops.
  *
  * @mr: the memory region to be updated.
  */
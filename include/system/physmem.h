@@ -64,6 +64,9 @@ void physical_memory_write(hwaddr addr, const void *buf, hwaddr len);
 #define DIRTY_CLIENTS_ALL     ((1 << DIRTY_MEMORY_NUM) - 1)
 #define DIRTY_CLIENTS_NOCODE  (DIRTY_CLIENTS_ALL & ~(1 << DIRTY_MEMORY_CODE))
 
+bool physical_memory_get_dirty(ram_addr_t start, ram_addr_t length,
+                               unsigned client);
+
 bool physical_memory_get_dirty_flag(ram_addr_t addr, unsigned client);
 
 bool physical_memory_is_clean(ram_addr_t addr);
@@ -45,6 +45,16 @@ struct RAMBlock {
     size_t page_size;
     /* dirty bitmap used during migration */
     unsigned long *bmap;
+    /*
+     * For each chunk of the block, which of the last bitmap syncs found
+     * it dirty, the latest in bit 0.  Only used by x-ram-cold-first.
+     */
+    uint8_t *dirty_history;
+    /*
+     * Parts of the private anonymous memory are mapped copy-on-write
+     * from a file, see qemu_ram_map_file_cow().
+     */
+    bool file_cow;
 
     /*
      * Below fields are only used by mapped-ram migration
@@ -132,6 +142,8 @@ static inline void *ramblock_ptr(RAMBlock *block, ram_addr_t offset)
 /* memory API */
 
 void qemu_ram_remap(ram_addr_t addr);
+int qemu_ram_map_file_cow(RAMBlock *block, ram_addr_t offset, size_t length,
+                          int fd, off_t fd_offset);
 /* This should not be used by devices.  */
 ram_addr_t qemu_ram_addr_from_host(void *ptr);
 ram_addr_t qemu_ram_addr_from_host_nofail(void *ptr);
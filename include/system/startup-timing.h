@@ -0,0 +1,39 @@
+/*
+ * QEMU startup timing recorder
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef SYSTEM_STARTUP_TIMING_H
+#define SYSTEM_STARTUP_TIMING_H
+
+#include "qapi/qapi-types-machine.h"
+
+/* Start recording, called first thing in qemu_init() */
+void startup_timing_init(void);
+
+/*
+ * Return the start time of an event to pass to startup_timing_end(),
+ * or 0 if startup is not being recorded.
+ */
+int64_t startup_timing_begin(void);
+
+/* Record an event of @kind named @name that started at @begin */
+void startup_timing_end(StartupEventKind kind, const char *name,
+                        int64_t begin);
+
+/*
+ * Like startup_timing_end(), for work that was only queued and completes
+ * in the background.  The event ends at the next call to
+ * startup_timing_end_deferred().
+ */
+void startup_timing_defer(StartupEventKind kind, const char *name,
+                          int64_t begin);
+
+/* End all deferred events, once the background work they wait for is done */
+void startup_timing_end_deferred(void);
+
+/* Stop recording, once the machine is ready */
+void startup_timing_finish(void);
+
+#endif
@@ -14,6 +14,9 @@ void perf_enable_perfmap(void);
 /* Start writing jit-<pid>.dump. */
 void perf_enable_jitdump(void);
 
+/* Start streaming jitdump records to the Unix socket at @path. */
+void perf_enable_jitdump_socket(const char *path);
+
 /* Add information about TCG prologue to profiler maps. */
 void perf_report_prologue(const void *start, size_t size);
 
@@ -32,6 +35,10 @@ static inline void perf_enable_jitdump(void)
 {
 }
 
+static inline void perf_enable_jitdump_socket(const char *path)
+{
+}
+
 static inline void perf_report_prologue(const void *start, size_t size)
 {
 }
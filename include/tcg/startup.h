@@ -30,11 +30,13 @@
  * @tb_size: translation buffer size
  * @splitwx: use separate rw and rx mappings
  * @max_threads: number of vcpu threads in system mode
+ * @numa_local: release the pages of the JIT buffer whenever it is reset
  *
  * Allocate and initialize TCG resources, especially the JIT buffer.
  * In user-only mode, @max_threads is unused.
  */
-void tcg_init(size_t tb_size, int splitwx, unsigned max_threads);
+void tcg_init(size_t tb_size, int splitwx, unsigned max_threads,
+              bool numa_local);
 
 /**
  * tcg_register_thread: Register this thread with the TCG runtime
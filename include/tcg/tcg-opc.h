@@ -146,6 +146,7 @@ DEF(smin_vec, 1, 2, 0, TCG_OPF_VECTOR)
 DEF(umin_vec, 1, 2, 0, TCG_OPF_VECTOR)
 DEF(smax_vec, 1, 2, 0, TCG_OPF_VECTOR)
 DEF(umax_vec, 1, 2, 0, TCG_OPF_VECTOR)
+DEF(uavg_vec, 1, 2, 0, TCG_OPF_VECTOR)
 
 DEF(and_vec, 1, 2, 0, TCG_OPF_VECTOR)
 DEF(or_vec, 1, 2, 0, TCG_OPF_VECTOR)
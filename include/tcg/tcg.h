@@ -623,6 +623,19 @@ TranslationBlock *tcg_tb_alloc(TCGContext *s);
 
 void tcg_region_reset_all(void);
 
+/**
+ * tcg_region_reclaim:
+ * @func: callback
+ * @user_data: opaque value to pass to @func
+ *
+ * Release the least recently allocated full region, after calling @func
+ * for each translation block inserted into it.  Must be called from a
+ * safe-work context.
+ *
+ * Returns: false if no region could be reclaimed.
+ */
+bool tcg_region_reclaim(GTraverseFunc func, gpointer user_data);
+
 size_t tcg_code_size(void);
 size_t tcg_code_capacity(void);
 
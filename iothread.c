@@ -21,6 +21,7 @@
 #include "system/iothread.h"
 #include "qapi/error.h"
 #include "qapi/qapi-commands-misc.h"
+#include "system/stats.h"
 #include "qemu/error-report.h"
 #include "qemu/rcu.h"
 #include "qemu/main-loop.h"
@@ -308,6 +309,127 @@ static void iothread_set_poll_param(Object *obj, Visitor *v,
     }
 }
 
+typedef struct IOThreadStat {
+    const char *name;
+    StatsType type;
+    int16_t exponent;   /* of seconds, or 0 for a plain count */
+    uint64_t (*get)(AioContext *ctx);
+} IOThreadStat;
+
+typedef struct IOThreadStatsArgs {
+    StatsResultList **result;
+    strList *names;
+} IOThreadStatsArgs;
+
+static uint64_t iothread_stat_poll_ns(AioContext *ctx)
+{
+    /* Written by the IOThread itself, a slightly stale value is fine */
+    return ctx->poll_ns;
+}
+
+#define IOTHREAD_STAT_ACCESSOR(field)                                   \
+    static uint64_t iothread_stat_##field(AioContext *ctx)              \
+    {                                                                   \
+        return qatomic_read(&ctx->field);                               \
+    }
+
+IOTHREAD_STAT_ACCESSOR(poll_hits)
+IOTHREAD_STAT_ACCESSOR(poll_misses)
+IOTHREAD_STAT_ACCESSOR(poll_time_ns)
+IOTHREAD_STAT_ACCESSOR(idle_time_ns)
+IOTHREAD_STAT_ACCESSOR(dispatch_time_ns)
+
+#undef IOTHREAD_STAT_ACCESSOR
+
+static const IOThreadStat iothread_stats[] = {
+    { "poll-ns", STATS_TYPE_INSTANT, -9, iothread_stat_poll_ns },
+    { "poll-hits", STATS_TYPE_CUMULATIVE, 0, iothread_stat_poll_hits },
+    { "poll-misses", STATS_TYPE_CUMULATIVE, 0, iothread_stat_poll_misses },
+    { "poll-time", STATS_TYPE_CUMULATIVE, -9, iothread_stat_poll_time_ns },
+    { "idle-time", STATS_TYPE_CUMULATIVE, -9, iothread_stat_idle_time_ns },
+    { "dispatch-time", STATS_TYPE_CUMULATIVE, -9,
+      iothread_stat_dispatch_time_ns },
+};
+
+static int iothread_stats_query(Object *obj, void *opaque)
+{
+    IOThreadStatsArgs *stats_args = opaque;
+    StatsList *stats_list = NULL;
+    IOThread *iothread;
+
+    if (!object_dynamic_cast(obj, TYPE_IOTHREAD)) {
+        return 0;
+    }
+
+    iothread = IOTHREAD(obj);
+    if (!iothread->ctx) {
+        return 0;
+    }
+
+    for (int i = ARRAY_SIZE(iothread_stats) - 1; i >= 0; i--) {
+        const IOThreadStat *desc = &iothread_stats[i];
+        Stats *stats;
+
+        if (!apply_str_list_filter(desc->name, stats_args->names)) {
+            continue;
+        }
+
+        stats = g_new0(Stats, 1);
+        stats->name = g_strdup(desc->name);
+        stats->value = g_new0(StatsValue, 1);
+        stats->value->type = QTYPE_QNUM;
+        stats->value->u.scalar = desc->get(iothread->ctx);
+        QAPI_LIST_PREPEND(stats_list, stats);
+    }
+
+    if (stats_list) {
+        g_autofree char *path = object_get_canonical_path(obj);
+
+        add_stats_entry(stats_args->result, STATS_PROVIDER_IOTHREAD, path,
+                        stats_list);
+    }
+    return 0;
+}
+
+static void iothread_stats_cb(StatsResultList **result, StatsTarget target,
+                              strList *names, strList *targets, Error **errp)
+{
+    IOThreadStatsArgs stats_args = {
+        .result = result,
+        .names = names,
+    };
+
+    if (target != STATS_TARGET_IOTHREAD) {
+        return;
+    }
+    object_child_foreach(object_get_objects_root(), iothread_stats_query,
+                         &stats_args);
+}
+
+static void iothread_schemas_cb(StatsSchemaList **result, Error **errp)
+{
+    StatsSchemaValueList *stats_list = NULL;
+
+    for (int i = ARRAY_SIZE(iothread_stats) - 1; i >= 0; i--) {
+        const IOThreadStat *desc = &iothread_stats[i];
+        StatsSchemaValue *value = g_new0(StatsSchemaValue, 1);
+
+        value->name = g_strdup(desc->name);
+        value->type = desc->type;
+        if (desc->exponent) {
+            value->has_unit = true;
+            value->unit = STATS_UNIT_SECONDS;
+            value->has_base = true;
+            value->base = 10;
+            value->exponent = desc->exponent;
+        }
+        QAPI_LIST_PREPEND(stats_list, value);
+    }
+
+    add_stats_schema(result, STATS_PROVIDER_IOTHREAD, STATS_TARGET_IOTHREAD,
+                     stats_list);
+}
+
 static void iothread_class_init(ObjectClass *klass, const void *class_data)
 {
     EventLoopBaseClass *bc = EVENT_LOOP_BASE_CLASS(klass);
@@ -331,6 +453,9 @@ static void iothread_class_init(ObjectClass *klass, const void *class_data)
                               iothread_get_poll_param,
                               iothread_set_poll_param,
                               NULL, &poll_weight_info);
+
+    add_stats_callbacks(STATS_PROVIDER_IOTHREAD, iothread_stats_cb,
+                        iothread_schemas_cb);
 }
 
 static const TypeInfo iothread_info = {
@@ -16,6 +16,7 @@
 #ifndef FD_TRANS_H
 #define FD_TRANS_H
 
+#include "qemu/atomic.h"
 #include "qemu/lockable.h"
 
 typedef abi_long (*TargetFdDataFunc)(void *, size_t);
@@ -31,6 +32,13 @@ extern QemuMutex target_fd_trans_lock;
 
 extern unsigned int target_fd_max;
 
+/*
+ * Number of non-NULL entries in target_fd_trans.  Most processes never
+ * register a translator, so the lookups below use this to skip taking
+ * target_fd_trans_lock on every read, write, send and recv.
+ */
+extern unsigned int target_fd_trans_count;
+
 static inline void fd_trans_init(void)
 {
     qemu_mutex_init(&target_fd_trans_lock);
@@ -48,7 +56,7 @@ static inline void fd_trans_postfork(void)
 
 static inline TargetFdDataFunc fd_trans_target_to_host_data(int fd)
 {
-    if (fd < 0) {
+    if (fd < 0 || !qatomic_read(&target_fd_trans_count)) {
         return NULL;
     }
 
@@ -61,7 +69,7 @@ static inline TargetFdDataFunc fd_trans_target_to_host_data(int fd)
 
 static inline TargetFdDataFunc fd_trans_host_to_target_data(int fd)
 {
-    if (fd < 0) {
+    if (fd < 0 || !qatomic_read(&target_fd_trans_count)) {
         return NULL;
     }
 
@@ -74,7 +82,7 @@ static inline TargetFdDataFunc fd_trans_host_to_target_data(int fd)
 
 static inline TargetFdAddrFunc fd_trans_target_to_host_addr(int fd)
 {
-    if (fd < 0) {
+    if (fd < 0 || !qatomic_read(&target_fd_trans_count)) {
         return NULL;
     }
 
@@ -98,6 +106,9 @@ static inline void internal_fd_trans_register_unsafe(int fd,
         memset((void *)(target_fd_trans + oldmax), 0,
                (target_fd_max - oldmax) * sizeof(TargetFdTrans *));
     }
+    if (!target_fd_trans[fd]) {
+        qatomic_set(&target_fd_trans_count, target_fd_trans_count + 1);
+    }
     target_fd_trans[fd] = trans;
 }
 
@@ -109,7 +120,8 @@ static inline void fd_trans_register(int fd, TargetFdTrans *trans)
 
 static inline void internal_fd_trans_unregister_unsafe(int fd)
 {
-    if (fd >= 0 && fd < target_fd_max) {
+    if (fd >= 0 && fd < target_fd_max && target_fd_trans[fd]) {
+        qatomic_set(&target_fd_trans_count, target_fd_trans_count - 1);
         target_fd_trans[fd] = NULL;
     }
 }
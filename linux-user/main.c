@@ -456,6 +456,11 @@ static void handle_arg_jitdump(const char *arg)
     perf_enable_jitdump();
 }
 
+static void handle_arg_jitdump_socket(const char *arg)
+{
+    perf_enable_jitdump_socket(arg);
+}
+
 static QemuPluginList plugins = QTAILQ_HEAD_INITIALIZER(plugins);
 
 #ifdef CONFIG_PLUGIN
@@ -534,6 +539,8 @@ static const struct qemu_argument arg_table[] = {
      "",           "Generate a /tmp/perf-${pid}.map file for perf"},
     {"jitdump",    "QEMU_JITDUMP",     false, handle_arg_jitdump,
      "",           "Generate a jit-${pid}.dump file for perf"},
+    {"jitdump-socket", "QEMU_JITDUMP_SOCKET", true, handle_arg_jitdump_socket,
+     "path",       "Stream jitdump records to a Unix socket"},
     {NULL, NULL, false, NULL, NULL, NULL}
 };
 
@@ -370,6 +370,67 @@ _syscall4(int, pidfd_send_signal, int, pidfd, int, sig, siginfo_t *, info,
 #if defined(__NR_pidfd_getfd) && defined(TARGET_NR_pidfd_getfd)
 _syscall3(int, pidfd_getfd, int, pidfd, int, targetfd, unsigned int, flags);
 #endif
+/*
+ * io_uring is emulated on top of a host ring that the guest cannot
+ * reach.  The kernel's rings live in QEMU's own memory
+ * (IORING_SETUP_NO_MMAP); the guest maps rings of the same layout from
+ * a memfd instead.  io_uring_enter() copies each new SQE out of the
+ * guest's ring, checks every guest buffer the kernel will access,
+ * translates the addresses (iovec arrays and msghdrs are copied as
+ * well) and only then queues the SQE on the kernel's ring.  SQEs that
+ * fail the checks complete with -EFAULT.  Completions move to the
+ * guest's CQ ring on every io_uring_enter(), so IORING_SQ_TASKRUN is
+ * always set for the guest to make liburing enter the kernel instead
+ * of waiting on its CQ ring.  Checking buffers that the kernel writes
+ * to also unprotects pages holding translated code.
+ *
+ * The kernel still executes the SQEs itself, so the guest and the host
+ * have to agree on errno and flag values and on the layout of the data
+ * behind the checked buffers (timespecs, sockaddrs, control messages).
+ * Kernel-side submission (SQPOLL) is not available.  Rings need Linux
+ * 6.5, and before 6.14 they also have to fit into a host page;
+ * otherwise io_uring_setup() fails with -ENOSYS, as if io_uring were
+ * not emulated at all.
+ */
+#if defined(TARGET_NR_io_uring_setup) && defined(__NR_io_uring_setup) && \
+    HOST_BIG_ENDIAN == TARGET_BIG_ENDIAN && \
+    HOST_LONG_BITS == TARGET_ABI_BITS && \
+    !defined(TARGET_ALPHA) && !defined(TARGET_HPPA) && \
+    !defined(TARGET_MIPS) && !defined(TARGET_SPARC)
+#define IO_URING_EMULATION
+#define __NR_sys_io_uring_setup __NR_io_uring_setup
+_syscall2(int, sys_io_uring_setup, unsigned int, entries,
+          struct qemu_io_uring_params *, p)
+#define __NR_sys_io_uring_register __NR_io_uring_register
+_syscall4(int, sys_io_uring_register, unsigned int, fd, unsigned int, opcode,
+          void *, arg, unsigned int, nr_args)
+#define __NR_sys_kcmp __NR_kcmp
+_syscall5(int, sys_kcmp, pid_t, pid1, pid_t, pid2, int, type,
+          unsigned long, idx1, unsigned long, idx2)
+static abi_long io_uring_mmap(int *fd, off_t *offset, abi_ulong len);
+static bool io_uring_fd_is_ring(int fd);
+static void io_uring_gc(void);
+static void io_uring_fork_start(void);
+static void io_uring_fork_end(bool child);
+#else
+static inline abi_long io_uring_mmap(int *fd, off_t *offset, abi_ulong len)
+{
+    return 0;
+}
+static inline bool io_uring_fd_is_ring(int fd)
+{
+    return false;
+}
+static inline void io_uring_gc(void)
+{
+}
+static inline void io_uring_fork_start(void)
+{
+}
+static inline void io_uring_fork_end(bool child)
+{
+}
+#endif
 #define __NR_sys_sched_getaffinity __NR_sched_getaffinity
 _syscall3(int, sys_sched_getaffinity, pid_t, pid, unsigned int, len,
           unsigned long *, user_mask_ptr);
@@ -811,6 +872,12 @@ safe_syscall4(int, fchmodat2, int, dfd, const char *, filename,
               unsigned short, mode, unsigned int, flags)
 #endif
 
+#ifdef IO_URING_EMULATION
+safe_syscall6(int, io_uring_enter, unsigned int, fd, unsigned int, to_submit,
+              unsigned int, min_complete, unsigned int, flags,
+              const void *, argp, size_t, argsz)
+#endif
+
 /* We do ioctl like this rather than via safe_syscall3 to preserve the
  * "third argument might be integer or pointer or not present" behaviour of
  * the libc function.
@@ -6192,6 +6259,13 @@ static abi_long do_mmap(abi_ulong addr, abi_ulong len, int prot,
     }
     host_flags |= target_to_host_bitmask(target_flags, mmap_flags_tbl);
 
+    if (!(host_flags & MAP_ANONYMOUS)) {
+        abi_long ret = io_uring_mmap(&fd, &offset, len);
+
+        if (ret) {
+            return ret;
+        }
+    }
     return get_errno(target_mmap(addr, len, prot, host_flags, fd, offset));
 }
 
@@ -6970,10 +7044,12 @@ static void *clone_func(void *arg)
 void clone_fork_start(void)
 {
     pthread_mutex_lock(&clone_lock);
+    io_uring_fork_start();
 }
 
 void clone_fork_end(bool child)
 {
+    io_uring_fork_end(child);
     if (child) {
         pthread_mutex_init(&clone_lock, NULL);
     } else {
@@ -9756,6 +9832,1067 @@ _syscall3(int, sys_fsmount, int, fs_fd, unsigned int, flags,
 _syscall3(int, sys_fspick, int, dfd, const char *, path, unsigned int, flags)
 #endif
 
+#ifdef IO_URING_EMULATION
+/* struct io_sqring_offsets and struct io_cqring_offsets */
+enum {
+    IO_URING_SQ_HEAD, IO_URING_SQ_TAIL, IO_URING_SQ_RING_MASK,
+    IO_URING_SQ_RING_ENTRIES, IO_URING_SQ_FLAGS, IO_URING_SQ_DROPPED,
+    IO_URING_SQ_ARRAY,
+};
+enum {
+    IO_URING_CQ_HEAD, IO_URING_CQ_TAIL, IO_URING_CQ_RING_MASK,
+    IO_URING_CQ_RING_ENTRIES, IO_URING_CQ_OVERFLOW, IO_URING_CQ_CQES,
+    IO_URING_CQ_FLAGS,
+};
+#define IO_URING_USER_ADDR      8   /* index of the u64 user_addr field */
+#define IO_URING_MAX_ENTRIES    32768
+#define IO_URING_MAX_CQ_ENTRIES (2 * IO_URING_MAX_ENTRIES)
+#define IO_URING_RINGS_HEADER   4096 /* more than struct io_rings needs */
+
+/* The setup flags the guest may ask for, see the comment at the top */
+#define IO_URING_SETUP_FLAGS \
+    (QEMU_IORING_SETUP_IOPOLL | QEMU_IORING_SETUP_CQSIZE | \
+     QEMU_IORING_SETUP_CLAMP | QEMU_IORING_SETUP_ATTACH_WQ | \
+     QEMU_IORING_SETUP_SUBMIT_ALL | QEMU_IORING_SETUP_COOP_TASKRUN | \
+     QEMU_IORING_SETUP_TASKRUN_FLAG | QEMU_IORING_SETUP_SQE128 | \
+     QEMU_IORING_SETUP_CQE32 | QEMU_IORING_SETUP_SINGLE_ISSUER | \
+     QEMU_IORING_SETUP_DEFER_TASKRUN | QEMU_IORING_SETUP_NO_SQARRAY)
+
+typedef struct IOURing {
+    QLIST_ENTRY(IOURing) next;
+    unsigned refs;              /* protected by io_uring_lock */
+    bool seen;                  /* likewise, for io_uring_gc() */
+    dev_t dev;
+    ino_t ino;
+    int fd;                     /* QEMU's own fd for the kernel ring */
+    struct qemu_io_uring_params p;
+    size_t sqe_size;
+    size_t cqe_size;
+
+    /* The kernel's rings, in memory the guest cannot reach */
+    void *rings;
+    size_t rings_alloc;
+    void *sqes;
+    size_t sqes_alloc;
+
+    /* The guest's rings, which the guest maps from @memfd */
+    int memfd;
+    void *grings;
+    size_t grings_size;
+    void *gsqes;
+    size_t gsqes_size;
+
+    /* Protects everything below and the contents of the rings */
+    pthread_mutex_t lock;
+    uint32_t sq_head;           /* guest SQ head */
+    uint32_t sq_dropped;
+    uint32_t cq_tail;           /* guest CQ tail */
+    uint32_t cq_overflow;       /* CQEs lost on a full guest CQ ring */
+    uint32_t ksq_tail;          /* kernel SQ tail */
+    void **scratch;             /* iovecs and msghdrs of the kernel SQEs */
+} IOURing;
+
+static pthread_mutex_t io_uring_lock = PTHREAD_MUTEX_INITIALIZER;
+static QLIST_HEAD(, IOURing) io_urings = QLIST_HEAD_INITIALIZER(io_urings);
+
+static void *io_uring_sq(IOURing *r, void *rings, int field)
+{
+    return rings + r->p.sq_off[field];
+}
+
+static void *io_uring_cq(IOURing *r, void *rings, int field)
+{
+    return rings + r->p.cq_off[field];
+}
+
+static void io_uring_free(IOURing *r)
+{
+    unsigned i;
+
+    if (r->scratch) {
+        for (i = 0; i < r->p.sq_entries; i++) {
+            g_free(r->scratch[i]);
+        }
+        g_free(r->scratch);
+    }
+    if (r->fd >= 0) {
+        close(r->fd);
+    }
+    qemu_memfd_free(r->grings, r->grings_size + r->gsqes_size, r->memfd);
+    if (r->rings) {
+        munmap(r->rings, r->rings_alloc);
+    }
+    if (r->sqes) {
+        munmap(r->sqes, r->sqes_alloc);
+    }
+    pthread_mutex_destroy(&r->lock);
+    g_free(r);
+}
+
+/*
+ * Rings are told apart by their inode; kernels before 6.7 share one
+ * inode between all rings, and then kcmp() is needed as well.
+ */
+static bool io_uring_match(IOURing *r, int fd, const struct stat *st)
+{
+    if (r->dev != st->st_dev || r->ino != st->st_ino) {
+        return false;
+    }
+    if (fd == r->fd) {
+        return true;
+    }
+    /* KCMP_FILE; without kcmp() do_io_uring_setup() keeps inodes unique */
+    return sys_kcmp(getpid(), getpid(), 0, fd, r->fd) <= 0;
+}
+
+/* Find the ring behind the guest's @fd and take a reference to it */
+static IOURing *io_uring_get(int fd)
+{
+    struct stat st;
+    IOURing *r = NULL;
+
+    pthread_mutex_lock(&io_uring_lock);
+    if (!QLIST_EMPTY(&io_urings) && fstat(fd, &st) == 0) {
+        QLIST_FOREACH(r, &io_urings, next) {
+            if (io_uring_match(r, fd, &st)) {
+                r->refs++;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&io_uring_lock);
+    return r;
+}
+
+static void io_uring_put(IOURing *r)
+{
+    pthread_mutex_lock(&io_uring_lock);
+    if (--r->refs == 0) {
+        io_uring_free(r);
+    }
+    pthread_mutex_unlock(&io_uring_lock);
+}
+
+static bool io_uring_fd_is_ring(int fd)
+{
+    IOURing *r = io_uring_get(fd);
+
+    if (r) {
+        io_uring_put(r);
+    }
+    return r != NULL;
+}
+
+/* Drop the rings that no file descriptor of the guest refers to anymore */
+static void io_uring_gc(void)
+{
+    IOURing *r, *tmp;
+    struct dirent *de;
+    struct stat st;
+    DIR *dir;
+    int fd;
+
+    pthread_mutex_lock(&io_uring_lock);
+    dir = QLIST_EMPTY(&io_urings) ? NULL : opendir("/proc/self/fd");
+    if (!dir) {
+        pthread_mutex_unlock(&io_uring_lock);
+        return;
+    }
+    QLIST_FOREACH(r, &io_urings, next) {
+        r->seen = false;
+    }
+    while ((de = readdir(dir))) {
+        if (qemu_strtoi(de->d_name, NULL, 10, &fd) || fd == dirfd(dir) ||
+            fstat(fd, &st)) {
+            continue;
+        }
+        QLIST_FOREACH(r, &io_urings, next) {
+            if (fd != r->fd && fd != r->memfd && io_uring_match(r, fd, &st)) {
+                r->seen = true;
+            }
+        }
+    }
+    closedir(dir);
+    QLIST_FOREACH_SAFE(r, &io_urings, next, tmp) {
+        if (!r->seen) {
+            QLIST_REMOVE(r, next);
+            if (--r->refs == 0) {
+                io_uring_free(r);
+            }
+        }
+    }
+    pthread_mutex_unlock(&io_uring_lock);
+}
+
+static void io_uring_fork_start(void)
+{
+    pthread_mutex_lock(&io_uring_lock);
+}
+
+static void io_uring_fork_end(bool child)
+{
+    IOURing *r, *tmp;
+
+    if (!child) {
+        pthread_mutex_unlock(&io_uring_lock);
+        return;
+    }
+    /*
+     * The kernel only lets the task that created a ring submit to it
+     * with IORING_SETUP_SINGLE_ISSUER, and the threads that held a
+     * reference to a ring are gone.  Rings do not survive fork(); the
+     * copied fds fail io_uring_enter() with -EOPNOTSUPP in the child.
+     */
+    QLIST_FOREACH_SAFE(r, &io_urings, next, tmp) {
+        QLIST_REMOVE(r, next);
+        pthread_mutex_init(&r->lock, NULL);
+        io_uring_free(r);
+    }
+    pthread_mutex_init(&io_uring_lock, NULL);
+}
+
+/* Redirect the guest's mmap() of a ring to the memfd behind its rings */
+static abi_long io_uring_mmap(int *fd, off_t *offset, abi_ulong len)
+{
+    IOURing *r = io_uring_get(*fd);
+    size_t size;
+
+    if (!r) {
+        return 0;
+    }
+    switch (*offset) {
+    case QEMU_IORING_OFF_SQ_RING:
+    case QEMU_IORING_OFF_CQ_RING:
+        *offset = 0;
+        size = r->grings_size;
+        break;
+    case QEMU_IORING_OFF_SQES:
+        *offset = r->grings_size;
+        size = r->gsqes_size;
+        break;
+    default:
+        size = 0;
+        break;
+    }
+    *fd = r->memfd;
+    io_uring_put(r);
+    return len <= size ? 0 : -TARGET_EINVAL;
+}
+
+/* Publish QEMU's view of the guest's rings to the guest */
+static void io_uring_publish(IOURing *r)
+{
+    uint32_t *kcq_head = io_uring_cq(r, r->rings, IO_URING_CQ_HEAD);
+    uint32_t *kcq_tail = io_uring_cq(r, r->rings, IO_URING_CQ_TAIL);
+    uint32_t sq_flags;
+
+    /*
+     * IORING_SQ_TASKRUN makes liburing enter the kernel to look for
+     * completions instead of only peeking at the CQ ring, which is what
+     * moves them to the guest's CQ ring.
+     */
+    sq_flags = qatomic_read((uint32_t *)io_uring_sq(r, r->rings,
+                                                    IO_URING_SQ_FLAGS));
+    sq_flags |= QEMU_IORING_SQ_TASKRUN;
+    if (qatomic_read(kcq_head) != qatomic_read(kcq_tail)) {
+        sq_flags |= QEMU_IORING_SQ_CQ_OVERFLOW;
+    }
+    qatomic_set((uint32_t *)io_uring_sq(r, r->grings, IO_URING_SQ_FLAGS),
+                sq_flags);
+    qatomic_set((uint32_t *)io_uring_sq(r, r->grings, IO_URING_SQ_DROPPED),
+                r->sq_dropped);
+    qatomic_set((uint32_t *)io_uring_cq(r, r->grings, IO_URING_CQ_OVERFLOW),
+                qatomic_read((uint32_t *)io_uring_cq(r, r->rings,
+                                                     IO_URING_CQ_OVERFLOW)) +
+                r->cq_overflow);
+    /* IORING_CQ_EVENTFD_DISABLED belongs to the guest */
+    qatomic_set((uint32_t *)io_uring_cq(r, r->rings, IO_URING_CQ_FLAGS),
+                qatomic_read((uint32_t *)io_uring_cq(r, r->grings,
+                                                     IO_URING_CQ_FLAGS)));
+    qatomic_store_release((uint32_t *)io_uring_sq(r, r->grings,
+                                                  IO_URING_SQ_HEAD),
+                          r->sq_head);
+    qatomic_store_release((uint32_t *)io_uring_cq(r, r->grings,
+                                                  IO_URING_CQ_TAIL),
+                          r->cq_tail);
+}
+
+/* Return how many CQEs the guest's CQ ring has room for */
+static uint32_t io_uring_cq_space(IOURing *r)
+{
+    uint32_t head = qatomic_load_acquire((uint32_t *)io_uring_cq(r, r->grings,
+                                                         IO_URING_CQ_HEAD));
+    uint32_t used = r->cq_tail - head;
+
+    /* A guest that moved its head past the tail gets no more CQEs */
+    return used < r->p.cq_entries ? r->p.cq_entries - used : 0;
+}
+
+static void *io_uring_cqe(IOURing *r, void *rings, uint32_t idx)
+{
+    return io_uring_cq(r, rings, IO_URING_CQ_CQES) +
+           (size_t)(idx & (r->p.cq_entries - 1)) * r->cqe_size;
+}
+
+/* Complete an SQE that never reached the kernel */
+static void io_uring_post_cqe(IOURing *r, uint64_t user_data, int32_t res)
+{
+    struct qemu_io_uring_cqe *cqe;
+
+    if (!io_uring_cq_space(r)) {
+        r->cq_overflow++;
+        return;
+    }
+    cqe = io_uring_cqe(r, r->grings, r->cq_tail++);
+    memset(cqe, 0, r->cqe_size);
+    cqe->user_data = user_data;
+    cqe->res = res;
+}
+
+/* Move the kernel's CQEs to the guest's CQ ring, as far as they fit */
+static void io_uring_reap(IOURing *r)
+{
+    uint32_t *khead = io_uring_cq(r, r->rings, IO_URING_CQ_HEAD);
+    uint32_t ktail = qatomic_load_acquire((uint32_t *)io_uring_cq(r, r->rings,
+                                                          IO_URING_CQ_TAIL));
+    uint32_t head = qatomic_read(khead);
+    uint32_t n = MIN(ktail - head, io_uring_cq_space(r));
+
+    for (; n; n--) {
+        memcpy(io_uring_cqe(r, r->grings, r->cq_tail++),
+               io_uring_cqe(r, r->rings, head++), r->cqe_size);
+    }
+    qatomic_store_release(khead, head);
+    io_uring_publish(r);
+}
+
+/* Check a buffer the kernel will access and translate its address */
+static bool io_uring_buf(uint64_t *addr, uint64_t len, int type)
+{
+    if (*addr != (abi_ulong)*addr) {
+        return false;
+    }
+    if (len == 0) {
+        /* Nothing is accessed, but fixed buffers still check the address */
+        *addr = guest_addr_valid_untagged(*addr) ?
+                (uintptr_t)g2h_untagged(*addr) : 0;
+        return true;
+    }
+    if (len != (abi_ulong)len || !access_ok_untagged(type, *addr, len)) {
+        return false;
+    }
+    *addr = (uintptr_t)g2h_untagged(*addr);
+    return true;
+}
+
+/*
+ * Convert @count guest iovecs at @target_addr to @iov.  Without
+ * @check the bases are not used (IOSQE_BUFFER_SELECT) and are passed
+ * through as they are.
+ */
+static abi_long io_uring_iov(struct iovec *iov, abi_ulong target_addr,
+                             uint64_t count, int type, bool check)
+{
+    struct target_iovec *tiov;
+    uint64_t i, base, len;
+
+    if (count == 0) {
+        return 0;
+    }
+    tiov = lock_user(VERIFY_READ, target_addr, count * sizeof(*tiov), 1);
+    if (!tiov) {
+        return -TARGET_EFAULT;
+    }
+    for (i = 0; i < count; i++) {
+        base = tswapal(tiov[i].iov_base);
+        len = tswapal(tiov[i].iov_len);
+        if (check && !io_uring_buf(&base, len, type)) {
+            unlock_user(tiov, target_addr, 0);
+            return -TARGET_EFAULT;
+        }
+        iov[i].iov_base = (void *)(uintptr_t)base;
+        iov[i].iov_len = len;
+    }
+    unlock_user(tiov, target_addr, 0);
+    return 0;
+}
+
+static abi_long io_uring_msghdr(struct qemu_io_uring_sqe *sqe, void **scratch)
+{
+    struct target_msghdr *tmsg;
+    uint64_t name, namelen, control, controllen, iovlen;
+    abi_ulong target_iov;
+    struct msghdr *msg;
+    uint32_t flags;
+    abi_long ret;
+
+    tmsg = lock_user(VERIFY_READ, sqe->addr, sizeof(*tmsg), 1);
+    if (!tmsg) {
+        return -TARGET_EFAULT;
+    }
+    name = tswapal(tmsg->msg_name);
+    namelen = (uint32_t)tswap32(tmsg->msg_namelen);
+    target_iov = tswapal(tmsg->msg_iov);
+    iovlen = tswapal(tmsg->msg_iovlen);
+    control = tswapal(tmsg->msg_control);
+    controllen = tswapal(tmsg->msg_controllen);
+    flags = tswap32(tmsg->msg_flags);
+    unlock_user(tmsg, sqe->addr, 0);
+
+    if (iovlen > IOV_MAX) {
+        return -TARGET_EMSGSIZE;
+    }
+    if (!io_uring_buf(&name, namelen, VERIFY_READ) ||
+        !io_uring_buf(&control, controllen, VERIFY_READ)) {
+        return -TARGET_EFAULT;
+    }
+
+    msg = g_malloc0(sizeof(*msg) + iovlen * sizeof(struct iovec));
+    ret = io_uring_iov((struct iovec *)(msg + 1), target_iov, iovlen,
+                       VERIFY_READ, !(sqe->flags & QEMU_IOSQE_BUFFER_SELECT));
+    if (ret) {
+        g_free(msg);
+        return ret;
+    }
+    msg->msg_name = (void *)(uintptr_t)name;
+    msg->msg_namelen = namelen;
+    msg->msg_iov = (struct iovec *)(msg + 1);
+    msg->msg_iovlen = iovlen;
+    msg->msg_control = (void *)(uintptr_t)control;
+    msg->msg_controllen = controllen;
+    msg->msg_flags = flags;
+    sqe->addr = (uintptr_t)msg;
+    *scratch = msg;
+    return 0;
+}
+
+/*
+ * Check and translate every address in the guest's @sqe.  What the
+ * kernel reads from guest memory through the SQE is copied to @scratch,
+ * which has to stay around until the kernel has consumed the SQE.
+ */
+static abi_long io_uring_translate(struct qemu_io_uring_sqe *sqe,
+                                   void **scratch)
+{
+    bool select = sqe->flags & QEMU_IOSQE_BUFFER_SELECT;
+    /* struct __kernel_timespec */
+    const uint64_t ts_size = 2 * sizeof(int64_t);
+    struct iovec *iov;
+    uint16_t addr_len;
+    abi_long ret;
+
+    /* attr_ptr, or the command area of IORING_OP_URING_CMD */
+    if (sqe->pad2[0] || sqe->pad2[1]) {
+        return -TARGET_EINVAL;
+    }
+
+    switch (sqe->opcode) {
+    case 0:  /* IORING_OP_NOP */
+    case 3:  /* IORING_OP_FSYNC */
+    case 6:  /* IORING_OP_POLL_ADD */
+    case 7:  /* IORING_OP_POLL_REMOVE */
+    case 8:  /* IORING_OP_SYNC_FILE_RANGE */
+    case 14: /* IORING_OP_ASYNC_CANCEL */
+    case 17: /* IORING_OP_FALLOCATE */
+    case 24: /* IORING_OP_FADVISE */
+    case 30: /* IORING_OP_SPLICE */
+    case 32: /* IORING_OP_REMOVE_BUFFERS */
+    case 33: /* IORING_OP_TEE */
+        /* Offsets, lengths and user_data only */
+        return 0;
+    case 1:  /* IORING_OP_READV */
+    case 2:  /* IORING_OP_WRITEV */
+        if (sqe->len > IOV_MAX) {
+            return -TARGET_EINVAL;
+        }
+        iov = g_new(struct iovec, sqe->len);
+        ret = io_uring_iov(iov, sqe->addr, sqe->len,
+                           sqe->opcode == 1 ? VERIFY_WRITE : VERIFY_READ,
+                           !select);
+        if (ret) {
+            g_free(iov);
+            return ret;
+        }
+        sqe->addr = (uintptr_t)iov;
+        *scratch = iov;
+        return 0;
+    case 4:  /* IORING_OP_READ_FIXED */
+    case 22: /* IORING_OP_READ */
+    case 27: /* IORING_OP_RECV */
+        if (select || io_uring_buf(&sqe->addr, sqe->len, VERIFY_WRITE)) {
+            return 0;
+        }
+        return -TARGET_EFAULT;
+    case 26: /* IORING_OP_SEND */
+        /* addr_len shares its place with splice_fd_in */
+        memcpy(&addr_len, &sqe->splice_fd_in, sizeof(addr_len));
+        if (!io_uring_buf(&sqe->off, addr_len, VERIFY_READ)) {
+            return -TARGET_EFAULT;
+        }
+        /* fall through */
+    case 5:  /* IORING_OP_WRITE_FIXED */
+    case 23: /* IORING_OP_WRITE */
+        if (select || io_uring_buf(&sqe->addr, sqe->len, VERIFY_READ)) {
+            return 0;
+        }
+        return -TARGET_EFAULT;
+    case 9:  /* IORING_OP_SENDMSG */
+        return io_uring_msghdr(sqe, scratch);
+    case 11: /* IORING_OP_TIMEOUT */
+    case 15: /* IORING_OP_LINK_TIMEOUT */
+        return io_uring_buf(&sqe->addr, ts_size, VERIFY_READ) ?
+               0 : -TARGET_EFAULT;
+    case 12: /* IORING_OP_TIMEOUT_REMOVE */
+        if ((sqe->rw_flags & QEMU_IORING_TIMEOUT_UPDATE_MASK) &&
+            !io_uring_buf(&sqe->off, ts_size, VERIFY_READ)) {
+            return -TARGET_EFAULT;
+        }
+        return 0;
+    case 13: /* IORING_OP_ACCEPT */
+        if (sqe->addr &&
+            (!io_uring_buf(&sqe->off, sizeof(socklen_t), VERIFY_WRITE) ||
+             !io_uring_buf(&sqe->addr, sizeof(struct sockaddr_storage),
+                           VERIFY_WRITE))) {
+            return -TARGET_EFAULT;
+        }
+        return 0;
+    case 16: /* IORING_OP_CONNECT */
+        return io_uring_buf(&sqe->addr, sqe->off, VERIFY_READ) ?
+               0 : -TARGET_EFAULT;
+    case 20: /* IORING_OP_FILES_UPDATE */
+        /* The kernel writes back the slots of IORING_FILE_INDEX_ALLOC */
+        return io_uring_buf(&sqe->addr, (uint64_t)sqe->len * sizeof(int32_t),
+                            VERIFY_WRITE) ? 0 : -TARGET_EFAULT;
+    case 31: /* IORING_OP_PROVIDE_BUFFERS */
+        return io_uring_buf(&sqe->addr,
+                            (uint64_t)sqe->len * (uint32_t)sqe->fd,
+                            VERIFY_WRITE) ? 0 : -TARGET_EFAULT;
+    default:
+        /* What the restrictions of do_io_uring_setup() would return */
+        return -TARGET_EACCES;
+    }
+}
+
+/*
+ * Move up to @to_submit SQEs from the guest's SQ ring to the kernel's.
+ * An SQE that fails the checks completes with the error right away,
+ * and takes the rest of its link chain with it, like a failed prep in
+ * the kernel.  Returns how many SQEs the guest's ring gave up.
+ */
+static uint32_t io_uring_submit(IOURing *r, uint32_t to_submit)
+{
+    uint32_t *gtail = io_uring_sq(r, r->grings, IO_URING_SQ_TAIL);
+    uint32_t *garray = (r->p.flags & QEMU_IORING_SETUP_NO_SQARRAY) ? NULL :
+                       io_uring_sq(r, r->grings, IO_URING_SQ_ARRAY);
+    uint32_t *khead = io_uring_sq(r, r->rings, IO_URING_SQ_HEAD);
+    uint32_t mask = r->p.sq_entries - 1;
+    uint32_t n = qatomic_load_acquire(gtail) - r->sq_head;
+    uint32_t ktail = r->ksq_tail, chain = ktail, idx, slot = 0, done, k;
+    union {
+        struct qemu_io_uring_sqe sqe;
+        uint8_t raw[2 * sizeof(struct qemu_io_uring_sqe)];
+    } u;
+    struct qemu_io_uring_sqe *ksqe;
+    bool failing = false;
+    abi_long err;
+
+    n = MIN(MIN(n, r->p.sq_entries), to_submit);
+    for (done = 0; done < n; done++) {
+        idx = r->sq_head + done;
+        idx = garray ? qatomic_read(&garray[idx & mask]) : idx & mask;
+        if (idx >= r->p.sq_entries) {
+            /* The kernel drops invalid entries and stops there */
+            r->sq_dropped++;
+            done++;
+            break;
+        }
+        if (!failing && ktail - qatomic_load_acquire(khead) == mask + 1) {
+            break;
+        }
+
+        /* Work on a copy, the guest can change its ring at any time */
+        memcpy(&u, r->gsqes + (size_t)idx * r->sqe_size, r->sqe_size);
+        err = failing ? -TARGET_ECANCELED : 0;
+        if (!failing) {
+            slot = ktail & mask;
+            g_free(r->scratch[slot]);
+            r->scratch[slot] = NULL;
+            err = io_uring_translate(&u.sqe, &r->scratch[slot]);
+        }
+        if (err == 0) {
+            memcpy(r->sqes + (size_t)slot * r->sqe_size, &u, r->sqe_size);
+            ktail++;
+        } else if (!failing) {
+            /* Cancel what there is of the chain in the kernel SQ ring */
+            for (k = chain; k != ktail; k++) {
+                ksqe = r->sqes + (size_t)(k & mask) * r->sqe_size;
+                io_uring_post_cqe(r, ksqe->user_data, -TARGET_ECANCELED);
+            }
+            ktail = chain;
+        }
+        if (err) {
+            io_uring_post_cqe(r, u.sqe.user_data, err);
+        }
+
+        failing = err &&
+                  (u.sqe.flags & (QEMU_IOSQE_IO_LINK | QEMU_IOSQE_IO_HARDLINK));
+        if (!(u.sqe.flags & (QEMU_IOSQE_IO_LINK | QEMU_IOSQE_IO_HARDLINK))) {
+            chain = ktail;
+        }
+    }
+
+    r->sq_head += done;
+    r->ksq_tail = ktail;
+    qatomic_store_release((uint32_t *)io_uring_sq(r, r->rings,
+                                                  IO_URING_SQ_TAIL), ktail);
+    io_uring_publish(r);
+    return done;
+}
+
+/* IORING_SETUP_NO_MMAP needs Linux 6.5 */
+static bool io_uring_no_mmap_supported(void)
+{
+    static int supported = -1;
+    struct qemu_io_uring_params p = { .flags = QEMU_IORING_SETUP_NO_MMAP };
+    size_t page = qemu_real_host_page_size();
+    uint64_t user_addr;
+    void *mem;
+    int fd = -1;
+
+    if (qatomic_read(&supported) < 0) {
+        mem = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem != MAP_FAILED) {
+            user_addr = (uintptr_t)mem;
+            memcpy(&p.sq_off[IO_URING_USER_ADDR], &user_addr,
+                   sizeof(user_addr));
+            user_addr += page;
+            memcpy(&p.cq_off[IO_URING_USER_ADDR], &user_addr,
+                   sizeof(user_addr));
+            fd = sys_io_uring_setup(1, &p);
+            if (fd >= 0) {
+                close(fd);
+            }
+            munmap(mem, 2 * page);
+        }
+        qatomic_set(&supported, fd >= 0);
+    }
+    return qatomic_read(&supported);
+}
+
+static abi_long do_io_uring_setup(abi_ulong entries, abi_ulong target_params)
+{
+    /*
+     * The kernel executes SQEs on its own, bypassing path translation,
+     * the fd translators and QEMU's signal handling.  Restrict the ring
+     * to the operations whose operands io_uring_translate() knows and
+     * that mean the same to the host as to the guest.  Anything else
+     * completes with -EACCES.  IORING_OP_RECVMSG is left out because the
+     * kernel writes the msghdr back only when the operation completes.
+     */
+    static const uint8_t sqe_ops[] = {
+        0,  /* IORING_OP_NOP */
+        1,  /* IORING_OP_READV */
+        2,  /* IORING_OP_WRITEV */
+        3,  /* IORING_OP_FSYNC */
+        4,  /* IORING_OP_READ_FIXED */
+        5,  /* IORING_OP_WRITE_FIXED */
+        6,  /* IORING_OP_POLL_ADD */
+        7,  /* IORING_OP_POLL_REMOVE */
+        8,  /* IORING_OP_SYNC_FILE_RANGE */
+        9,  /* IORING_OP_SENDMSG */
+        11, /* IORING_OP_TIMEOUT */
+        12, /* IORING_OP_TIMEOUT_REMOVE */
+        13, /* IORING_OP_ACCEPT */
+        14, /* IORING_OP_ASYNC_CANCEL */
+        15, /* IORING_OP_LINK_TIMEOUT */
+        16, /* IORING_OP_CONNECT */
+        17, /* IORING_OP_FALLOCATE */
+        20, /* IORING_OP_FILES_UPDATE */
+        22, /* IORING_OP_READ */
+        23, /* IORING_OP_WRITE */
+        24, /* IORING_OP_FADVISE */
+        26, /* IORING_OP_SEND */
+        27, /* IORING_OP_RECV */
+        30, /* IORING_OP_SPLICE */
+        31, /* IORING_OP_PROVIDE_BUFFERS */
+        32, /* IORING_OP_REMOVE_BUFFERS */
+        33, /* IORING_OP_TEE */
+    };
+    static const uint8_t register_ops[] = {
+        0,  /* IORING_REGISTER_BUFFERS */
+        1,  /* IORING_UNREGISTER_BUFFERS */
+        2,  /* IORING_REGISTER_FILES */
+        3,  /* IORING_UNREGISTER_FILES */
+        4,  /* IORING_REGISTER_EVENTFD */
+        5,  /* IORING_UNREGISTER_EVENTFD */
+        6,  /* IORING_REGISTER_FILES_UPDATE */
+        7,  /* IORING_REGISTER_EVENTFD_ASYNC */
+        8,  /* IORING_REGISTER_PROBE */
+    };
+    struct qemu_io_uring_restriction
+        res[ARRAY_SIZE(sqe_ops) + ARRAY_SIZE(register_ops) + 1] = { };
+    struct qemu_io_uring_params params, *target_p;
+    size_t page = qemu_real_host_page_size();
+    size_t rings_size, sqes_size;
+    uint32_t guest_flags, sq, cq, i;
+    uint64_t user_addr;
+    bool unique = true;
+    struct stat st;
+    IOURing *r, *o;
+    abi_long ret;
+    int fd, n = 0;
+
+    if (!io_uring_no_mmap_supported()) {
+        return -TARGET_ENOSYS;
+    }
+
+    target_p = lock_user(VERIFY_WRITE, target_params, sizeof(params), 1);
+    if (!target_p) {
+        return -TARGET_EFAULT;
+    }
+    memcpy(&params, target_p, sizeof(params));
+    guest_flags = params.flags;
+    if (guest_flags & ~IO_URING_SETUP_FLAGS) {
+        unlock_user(target_p, target_params, 0);
+        return -TARGET_EINVAL;
+    }
+
+    /*
+     * Size the kernel's rings for the largest ones the kernel may set up
+     * for these parameters, see rings_size() in io_uring/io_uring.c.
+     */
+    r = g_new0(IOURing, 1);
+    r->refs = 1;
+    r->fd = -1;
+    r->memfd = -1;
+    pthread_mutex_init(&r->lock, NULL);
+    r->sqe_size = sizeof(struct qemu_io_uring_sqe);
+    if (guest_flags & QEMU_IORING_SETUP_SQE128) {
+        r->sqe_size *= 2;
+    }
+    r->cqe_size = sizeof(struct qemu_io_uring_cqe);
+    if (guest_flags & QEMU_IORING_SETUP_CQE32) {
+        r->cqe_size *= 2;
+    }
+    sq = pow2ceil(MIN(MAX(entries, 1), IO_URING_MAX_ENTRIES));
+    cq = 2 * sq;
+    if (guest_flags & QEMU_IORING_SETUP_CQSIZE) {
+        cq = MAX(cq, pow2ceil(MIN(MAX(params.cq_entries, 1),
+                                  IO_URING_MAX_CQ_ENTRIES)));
+    }
+    r->rings_alloc = ROUND_UP(IO_URING_RINGS_HEADER + cq * r->cqe_size +
+                              64 + sq * sizeof(uint32_t), page);
+    r->sqes_alloc = ROUND_UP(sq * r->sqe_size, page);
+    r->rings = mmap(NULL, r->rings_alloc, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    r->sqes = mmap(NULL, r->sqes_alloc, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (r->rings == MAP_FAILED || r->sqes == MAP_FAILED) {
+        ret = -TARGET_ENOMEM;
+        r->rings = r->rings == MAP_FAILED ? NULL : r->rings;
+        r->sqes = r->sqes == MAP_FAILED ? NULL : r->sqes;
+        goto fail;
+    }
+
+    params.flags |= QEMU_IORING_SETUP_R_DISABLED | QEMU_IORING_SETUP_NO_MMAP;
+    user_addr = (uintptr_t)r->sqes;
+    memcpy(&params.sq_off[IO_URING_USER_ADDR], &user_addr, sizeof(user_addr));
+    user_addr = (uintptr_t)r->rings;
+    memcpy(&params.cq_off[IO_URING_USER_ADDR], &user_addr, sizeof(user_addr));
+    fd = sys_io_uring_setup(entries, &params);
+    if (fd < 0) {
+        ret = get_errno(fd);
+        /*
+         * Before Linux 6.14 the kernel only takes rings that are
+         * physically contiguous, which anonymous memory is not beyond
+         * a page.
+         */
+        if (ret == -TARGET_EINVAL &&
+            (r->rings_alloc > page || r->sqes_alloc > page)) {
+            ret = -TARGET_ENOSYS;
+        }
+        goto fail;
+    }
+    r->fd = fd;
+    r->p = params;
+
+    /* SQEs are copied to the kernel ring before being checked. */
+    ret = -TARGET_ENOSYS;
+    if (!(params.features & QEMU_IORING_FEAT_SUBMIT_STABLE)) {
+        goto fail;
+    }
+    rings_size = (size_t)params.cq_off[IO_URING_CQ_CQES] +
+                 (size_t)params.cq_entries * r->cqe_size;
+    if (!(params.flags & QEMU_IORING_SETUP_NO_SQARRAY)) {
+        rings_size = MAX(rings_size, params.sq_off[IO_URING_SQ_ARRAY] +
+                         (size_t)params.sq_entries * sizeof(uint32_t));
+    }
+    sqes_size = (size_t)params.sq_entries * r->sqe_size;
+    if (rings_size > r->rings_alloc || sqes_size > r->sqes_alloc) {
+        goto fail;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(sqe_ops); i++, n++) {
+        res[n].opcode = QEMU_IORING_RESTRICTION_SQE_OP;
+        res[n].op = sqe_ops[i];
+    }
+    for (i = 0; i < ARRAY_SIZE(register_ops); i++, n++) {
+        res[n].opcode = QEMU_IORING_RESTRICTION_REGISTER_OP;
+        res[n].op = register_ops[i];
+    }
+    res[n].opcode = QEMU_IORING_RESTRICTION_SQE_FLAGS_ALLOWED;
+    res[n++].op = 0xff;
+
+    ret = get_errno(sys_io_uring_register(fd,
+                                          QEMU_IORING_REGISTER_RESTRICTIONS,
+                                          res, n));
+    if (!is_error(ret)) {
+        ret = get_errno(sys_io_uring_register(fd,
+                                              QEMU_IORING_REGISTER_ENABLE_RINGS,
+                                              NULL, 0));
+    }
+    if (is_error(ret)) {
+        goto fail;
+    }
+
+    /* The guest's rings have the same layout as the kernel's. */
+    r->grings_size = ROUND_UP(rings_size, page);
+    r->gsqes_size = ROUND_UP(sqes_size, page);
+    r->grings = qemu_memfd_alloc("io_uring", r->grings_size + r->gsqes_size,
+                                 0, &r->memfd, NULL);
+    if (!r->grings) {
+        ret = -TARGET_ENOMEM;
+        goto fail;
+    }
+    r->gsqes = r->grings + r->grings_size;
+    memcpy(r->grings, r->rings, rings_size);
+    if (!(params.flags & QEMU_IORING_SETUP_NO_SQARRAY)) {
+        uint32_t *array = io_uring_sq(r, r->rings, IO_URING_SQ_ARRAY);
+
+        for (i = 0; i < params.sq_entries; i++) {
+            array[i] = i;
+        }
+    }
+    r->scratch = g_new0(void *, params.sq_entries);
+
+    /* The guest gets its own fd, so that it cannot close QEMU's. */
+    fd = fcntl(r->fd, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0 || fstat(r->fd, &st)) {
+        ret = -host_to_target_errno(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        goto fail;
+    }
+    r->dev = st.st_dev;
+    r->ino = st.st_ino;
+
+    io_uring_gc();
+    pthread_mutex_lock(&io_uring_lock);
+    if (sys_kcmp(getpid(), getpid(), 0, fd, r->fd) < 0) {
+        QLIST_FOREACH(o, &io_urings, next) {
+            unique &= o->dev != r->dev || o->ino != r->ino;
+        }
+    }
+    if (unique) {
+        QLIST_INSERT_HEAD(&io_urings, r, next);
+    }
+    pthread_mutex_unlock(&io_uring_lock);
+    if (!unique) {
+        /* Shared inodes and no kcmp(): no way to tell the rings apart */
+        close(fd);
+        ret = -TARGET_ENOSYS;
+        goto fail;
+    }
+
+    params.flags = guest_flags;
+    memset(&params.sq_off[IO_URING_USER_ADDR], 0, sizeof(user_addr));
+    memset(&params.cq_off[IO_URING_USER_ADDR], 0, sizeof(user_addr));
+    memcpy(target_p, &params, sizeof(params));
+    unlock_user(target_p, target_params, sizeof(params));
+    fd_trans_unregister(fd);
+    return fd;
+
+fail:
+    io_uring_free(r);
+    unlock_user(target_p, target_params, 0);
+    return ret;
+}
+
+static abi_long do_io_uring_enter(abi_long fd, abi_long to_submit,
+                                  abi_long min_complete, abi_long flags,
+                                  abi_ulong target_arg, abi_ulong argsz)
+{
+    struct qemu_io_uring_getevents_arg ext;
+    const void *host_arg = NULL;
+    size_t host_argsz = 0;
+    sigset_t *set = NULL;
+    uint64_t ts[2];
+    uint32_t submitted = 0, pending, avail, nr_wait = 0;
+    IOURing *r;
+    abi_long ret;
+
+    /* Registered ring fds would bypass QEMU. */
+    if (flags & ~(QEMU_IORING_ENTER_GETEVENTS | QEMU_IORING_ENTER_SQ_WAKEUP |
+                  QEMU_IORING_ENTER_SQ_WAIT | QEMU_IORING_ENTER_EXT_ARG |
+                  QEMU_IORING_ENTER_ABS_TIMER |
+                  QEMU_IORING_ENTER_EXT_ARG_REG)) {
+        return -TARGET_EINVAL;
+    }
+
+    r = io_uring_get(fd);
+    if (!r) {
+        return -TARGET_EOPNOTSUPP;
+    }
+
+    ret = 0;
+    if (flags & QEMU_IORING_ENTER_EXT_ARG_REG) {
+        /* The argument is an offset into a registered wait region. */
+        host_arg = (const void *)(uintptr_t)target_arg;
+        host_argsz = argsz;
+    } else if (flags & QEMU_IORING_ENTER_EXT_ARG) {
+        if (target_arg) {
+            if (argsz != sizeof(ext)) {
+                ret = -TARGET_EINVAL;
+            } else if (copy_from_user(&ext, target_arg, sizeof(ext))) {
+                ret = -TARGET_EFAULT;
+            } else if (ext.ts) {
+                /* The timeout is a fixed-layout struct __kernel_timespec. */
+                if (ext.ts != (abi_ulong)ext.ts ||
+                    copy_from_user(ts, ext.ts, sizeof(ts))) {
+                    ret = -TARGET_EFAULT;
+                }
+                ext.ts = (uintptr_t)ts;
+            }
+            if (ret == 0 && ext.sigmask) {
+                ret = process_sigsuspend_mask(&set, ext.sigmask,
+                                              ext.sigmask_sz);
+                ext.sigmask = (uintptr_t)set;
+                ext.sigmask_sz = SIGSET_T_SIZE;
+            }
+            host_arg = &ext;
+            host_argsz = sizeof(ext);
+        }
+    } else if (target_arg) {
+        ret = process_sigsuspend_mask(&set, target_arg, argsz);
+        host_arg = set;
+        host_argsz = SIGSET_T_SIZE;
+    }
+    if (ret != 0) {
+        io_uring_put(r);
+        return ret;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    io_uring_reap(r);
+    if (to_submit) {
+        submitted = io_uring_submit(r, to_submit);
+    }
+    pending = r->ksq_tail -
+              qatomic_read((uint32_t *)io_uring_sq(r, r->rings,
+                                                   IO_URING_SQ_HEAD));
+    avail = r->p.cq_entries - io_uring_cq_space(r);
+    if ((flags & QEMU_IORING_ENTER_GETEVENTS) &&
+        (uint32_t)min_complete > avail) {
+        nr_wait = min_complete - avail;
+    }
+    pthread_mutex_unlock(&r->lock);
+
+    ret = get_errno(safe_io_uring_enter(r->fd, pending, nr_wait, flags,
+                                        host_arg, host_argsz));
+
+    pthread_mutex_lock(&r->lock);
+    io_uring_reap(r);
+    pthread_mutex_unlock(&r->lock);
+    io_uring_put(r);
+
+    /* What the guest submitted is gone from its SQ ring either way. */
+    if (submitted || !is_error(ret)) {
+        ret = submitted;
+    }
+    if (set) {
+        finish_sigsuspend_mask(ret);
+    }
+    return ret;
+}
+
+static abi_long do_io_uring_register(abi_long fd, abi_long opcode,
+                                     abi_ulong target_arg, abi_long nr_args)
+{
+    struct qemu_io_uring_files_update up;
+    struct iovec *iov = NULL;
+    abi_ulong size = 0;
+    int type = VERIFY_READ;
+    void *p = NULL, *host_arg = NULL;
+    IOURing *r;
+    abi_long ret = 0;
+
+    switch (opcode) {
+    case QEMU_IORING_REGISTER_BUFFERS:
+    case QEMU_IORING_REGISTER_FILES_UPDATE:
+    case QEMU_IORING_UNREGISTER_BUFFERS:
+    case QEMU_IORING_UNREGISTER_FILES:
+    case QEMU_IORING_UNREGISTER_EVENTFD:
+        break;
+    case QEMU_IORING_REGISTER_FILES:
+        size = (abi_ulong)(uint32_t)nr_args * sizeof(int32_t);
+        break;
+    case QEMU_IORING_REGISTER_EVENTFD:
+    case QEMU_IORING_REGISTER_EVENTFD_ASYNC:
+        size = sizeof(int32_t);
+        break;
+    case QEMU_IORING_REGISTER_PROBE:
+        /* struct io_uring_probe with @nr_args struct io_uring_probe_op */
+        size = 16 + (abi_ulong)(uint32_t)nr_args * 8;
+        type = VERIFY_WRITE;
+        break;
+    default:
+        /* What the restrictions of do_io_uring_setup() would return */
+        return -TARGET_EACCES;
+    }
+
+    r = io_uring_get(fd);
+    if (!r) {
+        return -TARGET_EOPNOTSUPP;
+    }
+
+    if (opcode == QEMU_IORING_REGISTER_BUFFERS) {
+        /* IORING_MAX_REG_BUFFERS */
+        if ((uint32_t)nr_args > 1 << 14) {
+            ret = -TARGET_EINVAL;
+        } else {
+            iov = g_new(struct iovec, (uint32_t)nr_args);
+            ret = io_uring_iov(iov, target_arg, (uint32_t)nr_args,
+                               VERIFY_WRITE, true);
+            host_arg = iov;
+        }
+    } else if (opcode == QEMU_IORING_REGISTER_FILES_UPDATE) {
+        if (copy_from_user(&up, target_arg, sizeof(up)) ||
+            !io_uring_buf(&up.fds, (uint64_t)(uint32_t)nr_args *
+                          sizeof(int32_t), VERIFY_READ)) {
+            ret = -TARGET_EFAULT;
+        }
+        host_arg = &up;
+    } else if (target_arg && size) {
+        p = lock_user(type, target_arg, size, 1);
+        if (!p) {
+            ret = -TARGET_EFAULT;
+        }
+        host_arg = p;
+    }
+
+    if (ret == 0) {
+        ret = get_errno(sys_io_uring_register(r->fd, opcode, host_arg,
+                                              nr_args));
+    }
+    unlock_user(p, target_arg, type == VERIFY_WRITE ? size : 0);
+    g_free(iov);
+    io_uring_put(r);
+    return ret;
+}
+#endif
+
 /* This is an internal helper for do_syscall so that it is easier
  * to have a single return point, so that actions, such as logging
  * of syscall results, can be performed.
@@ -9896,6 +11033,14 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
         fd_trans_unregister(ret);
         return ret;
 #endif
+#ifdef IO_URING_EMULATION
+    case TARGET_NR_io_uring_setup:
+        return do_io_uring_setup(arg1, arg2);
+    case TARGET_NR_io_uring_enter:
+        return do_io_uring_enter(arg1, arg2, arg3, arg4, arg5, arg6);
+    case TARGET_NR_io_uring_register:
+        return do_io_uring_register(arg1, arg2, arg3, arg4);
+#endif
 #if defined(__NR_pidfd_open) && defined(TARGET_NR_pidfd_open)
     case TARGET_NR_pidfd_open:
         return get_errno(pidfd_open(arg1, arg2));
@@ -9927,6 +11072,11 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
 #endif
     case TARGET_NR_close:
         fd_trans_unregister(arg1);
+        if (io_uring_fd_is_ring(arg1)) {
+            ret = get_errno(close(arg1));
+            io_uring_gc();
+            return ret;
+        }
         return get_errno(close(arg1));
 #if defined(__NR_close_range) && defined(TARGET_NR_close_range)
     case TARGET_NR_close_range:
@@ -9937,6 +11087,7 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
             for (fd = arg1; fd < maxfd; fd++) {
                 fd_trans_unregister(fd);
             }
+            io_uring_gc();
         }
         return ret;
 #endif
@@ -10487,24 +11638,36 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
         return ret;
 #ifdef TARGET_NR_dup2
     case TARGET_NR_dup2:
+    {
+        bool ring = arg1 != arg2 && io_uring_fd_is_ring(arg2);
+
         ret = get_errno(dup2(arg1, arg2));
         if (ret >= 0) {
             fd_trans_dup(arg1, arg2);
+            if (ring) {
+                io_uring_gc();
+            }
         }
         return ret;
+    }
 #endif
 #if defined(CONFIG_DUP3) && defined(TARGET_NR_dup3)
     case TARGET_NR_dup3:
     {
         int host_flags;
+        bool ring;
 
         if ((arg3 & ~TARGET_O_CLOEXEC) != 0) {
             return -EINVAL;
         }
         host_flags = target_to_host_bitmask(arg3, fcntl_flags_tbl);
+        ring = io_uring_fd_is_ring(arg2);
         ret = get_errno(dup3(arg1, arg2, host_flags));
         if (ret >= 0) {
             fd_trans_dup(arg1, arg2);
+            if (ring) {
+                io_uring_gc();
+            }
         }
         return ret;
     }
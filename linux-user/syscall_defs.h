@@ -2780,6 +2780,105 @@ struct target_open_how_ver0 {
 #ifndef RESOLVE_IN_ROOT
 #define RESOLVE_IN_ROOT         0x10
 #endif
+/* from kernel's include/uapi/linux/io_uring.h */
+struct qemu_io_uring_params {
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t flags;
+    uint32_t sq_thread_cpu;
+    uint32_t sq_thread_idle;
+    uint32_t features;
+    uint32_t wq_fd;
+    uint32_t resv[3];
+    uint32_t sq_off[10];
+    uint32_t cq_off[10];
+};
+struct qemu_io_uring_restriction {
+    uint16_t opcode;
+    uint8_t op;         /* register_op, sqe_op or sqe_flags */
+    uint8_t resv;
+    uint32_t resv2[3];
+};
+struct qemu_io_uring_getevents_arg {
+    uint64_t sigmask;
+    uint32_t sigmask_sz;
+    uint32_t min_wait_usec;
+    uint64_t ts;
+};
+struct qemu_io_uring_sqe {
+    uint8_t opcode;
+    uint8_t flags;
+    uint16_t ioprio;
+    int32_t fd;
+    uint64_t off;       /* or addr2 */
+    uint64_t addr;
+    uint32_t len;
+    uint32_t rw_flags;
+    uint64_t user_data;
+    uint16_t buf_index;
+    uint16_t personality;
+    int32_t splice_fd_in;
+    uint64_t pad2[2];
+};
+struct qemu_io_uring_cqe {
+    uint64_t user_data;
+    int32_t res;
+    uint32_t flags;
+};
+struct qemu_io_uring_files_update {
+    uint32_t offset;
+    uint32_t resv;
+    uint64_t fds;
+};
+#define QEMU_IORING_OFF_SQ_RING                     0ULL
+#define QEMU_IORING_OFF_CQ_RING                     0x8000000ULL
+#define QEMU_IORING_OFF_SQES                        0x10000000ULL
+#define QEMU_IORING_SETUP_IOPOLL                    (1U << 0)
+#define QEMU_IORING_SETUP_SQPOLL                    (1U << 1)
+#define QEMU_IORING_SETUP_SQ_AFF                    (1U << 2)
+#define QEMU_IORING_SETUP_CQSIZE                    (1U << 3)
+#define QEMU_IORING_SETUP_CLAMP                     (1U << 4)
+#define QEMU_IORING_SETUP_ATTACH_WQ                 (1U << 5)
+#define QEMU_IORING_SETUP_R_DISABLED                (1U << 6)
+#define QEMU_IORING_SETUP_SUBMIT_ALL                (1U << 7)
+#define QEMU_IORING_SETUP_COOP_TASKRUN              (1U << 8)
+#define QEMU_IORING_SETUP_TASKRUN_FLAG              (1U << 9)
+#define QEMU_IORING_SETUP_SQE128                    (1U << 10)
+#define QEMU_IORING_SETUP_CQE32                     (1U << 11)
+#define QEMU_IORING_SETUP_SINGLE_ISSUER             (1U << 12)
+#define QEMU_IORING_SETUP_DEFER_TASKRUN             (1U << 13)
+#define QEMU_IORING_SETUP_NO_MMAP                   (1U << 14)
+#define QEMU_IORING_SETUP_REGISTERED_FD_ONLY        (1U << 15)
+#define QEMU_IORING_SETUP_NO_SQARRAY                (1U << 16)
+#define QEMU_IORING_ENTER_GETEVENTS                 (1U << 0)
+#define QEMU_IORING_ENTER_SQ_WAKEUP                 (1U << 1)
+#define QEMU_IORING_ENTER_SQ_WAIT                   (1U << 2)
+#define QEMU_IORING_ENTER_EXT_ARG                   (1U << 3)
+#define QEMU_IORING_ENTER_REGISTERED_RING           (1U << 4)
+#define QEMU_IORING_ENTER_ABS_TIMER                 (1U << 5)
+#define QEMU_IORING_ENTER_EXT_ARG_REG               (1U << 6)
+#define QEMU_IORING_FEAT_SUBMIT_STABLE              (1U << 2)
+#define QEMU_IORING_SQ_CQ_OVERFLOW                  (1U << 1)
+#define QEMU_IORING_SQ_TASKRUN                      (1U << 2)
+#define QEMU_IOSQE_IO_LINK                          (1U << 2)
+#define QEMU_IOSQE_IO_HARDLINK                      (1U << 3)
+#define QEMU_IOSQE_BUFFER_SELECT                    (1U << 5)
+#define QEMU_IORING_TIMEOUT_UPDATE_MASK             ((1U << 1) | (1U << 4))
+#define QEMU_IORING_REGISTER_BUFFERS                0
+#define QEMU_IORING_UNREGISTER_BUFFERS              1
+#define QEMU_IORING_REGISTER_FILES                  2
+#define QEMU_IORING_UNREGISTER_FILES                3
+#define QEMU_IORING_REGISTER_EVENTFD                4
+#define QEMU_IORING_UNREGISTER_EVENTFD              5
+#define QEMU_IORING_REGISTER_FILES_UPDATE           6
+#define QEMU_IORING_REGISTER_EVENTFD_ASYNC          7
+#define QEMU_IORING_REGISTER_PROBE                  8
+#define QEMU_IORING_REGISTER_RESTRICTIONS           11
+#define QEMU_IORING_REGISTER_ENABLE_RINGS           12
+#define QEMU_IORING_RESTRICTION_REGISTER_OP         0
+#define QEMU_IORING_RESTRICTION_SQE_OP              1
+#define QEMU_IORING_RESTRICTION_SQE_FLAGS_ALLOWED   2
+
 #if (defined(TARGET_I386) && defined(TARGET_ABI32)) || \
     (defined(TARGET_ARM) && defined(TARGET_ABI32)) || \
     defined(TARGET_M68K) || defined(TARGET_MICROBLAZE) || \
@@ -256,6 +256,7 @@ query_dirty_rate_info(TimeUnit calc_time_unit)
     int64_t dirty_rate = DirtyStat.dirty_rate;
     struct DirtyRateInfo *info = g_new0(DirtyRateInfo, 1);
     DirtyRateVcpuList *head = NULL, **tail = &head;
+    DirtyRateRAMBlockList *blocks = NULL, **blocks_tail = &blocks;
 
     info->status = CalculatingState;
     info->start_time = DirtyStat.start_time;
@@ -289,6 +290,27 @@ query_dirty_rate_info(TimeUnit calc_time_unit)
         if (dirtyrate_mode == DIRTY_RATE_MEASURE_MODE_DIRTY_BITMAP) {
             info->sample_pages = 0;
         }
+
+        if (dirtyrate_mode == DIRTY_RATE_MEASURE_MODE_PAGE_SAMPLING &&
+            DirtyStat.calc_time_ms > 0) {
+            info->has_ramblock_dirty_rate = true;
+            for (i = 0; i < DirtyStat.page_sampling.nblocks; i++) {
+                RamblockDirtyStat *stat = &DirtyStat.page_sampling.blocks[i];
+                DirtyRateRAMBlock *rate;
+
+                if (!stat->sample_count) {
+                    continue;
+                }
+                rate = g_new0(DirtyRateRAMBlock, 1);
+                rate->id = g_strdup(stat->idstr);
+                rate->size = stat->block_mem_MB;
+                rate->dirty_rate = stat->dirty_samples * stat->block_mem_MB *
+                                   1000 / (stat->sample_count *
+                                           DirtyStat.calc_time_ms);
+                QAPI_LIST_APPEND(blocks_tail, rate);
+            }
+            info->ramblock_dirty_rate = blocks;
+        }
     }
 
     trace_query_dirty_rate_info(DirtyRateStatus_str(CalculatingState));
@@ -308,6 +330,8 @@ static void init_dirtyrate_stat(struct DirtyRateConfig config)
         DirtyStat.page_sampling.total_dirty_samples = 0;
         DirtyStat.page_sampling.total_sample_count = 0;
         DirtyStat.page_sampling.total_block_mem_MB = 0;
+        DirtyStat.page_sampling.nblocks = 0;
+        DirtyStat.page_sampling.blocks = NULL;
         break;
     case DIRTY_RATE_MEASURE_MODE_DIRTY_RING:
         DirtyStat.dirty_ring.nvcpu = -1;
@@ -324,11 +348,23 @@ static void cleanup_dirtyrate_stat(struct DirtyRateConfig config)
     if (dirtyrate_mode == DIRTY_RATE_MEASURE_MODE_DIRTY_RING) {
         free(DirtyStat.dirty_ring.rates);
         DirtyStat.dirty_ring.rates = NULL;
+    } else if (dirtyrate_mode == DIRTY_RATE_MEASURE_MODE_PAGE_SAMPLING) {
+        g_free(DirtyStat.page_sampling.blocks);
+        DirtyStat.page_sampling.blocks = NULL;
+        DirtyStat.page_sampling.nblocks = 0;
     }
 }
 
 static void update_dirtyrate_stat(struct RamblockDirtyInfo *info)
 {
+    RamblockDirtyStat *stat =
+        &DirtyStat.page_sampling.blocks[DirtyStat.page_sampling.nblocks++];
+
+    g_strlcpy(stat->idstr, info->idstr, sizeof(stat->idstr));
+    stat->dirty_samples = info->sample_dirty_count;
+    stat->sample_count = info->sample_pages_count;
+    stat->block_mem_MB = qemu_target_pages_to_MiB(info->ramblock_pages);
+
     DirtyStat.page_sampling.total_dirty_samples += info->sample_dirty_count;
     DirtyStat.page_sampling.total_sample_count += info->sample_pages_count;
     /* size of total pages in MB */
@@ -570,6 +606,9 @@ static bool compare_page_hash_info(struct RamblockDirtyInfo *info,
     struct RamblockDirtyInfo *block_dinfo = NULL;
     RAMBlock *block;
 
+    /* Each sampled block is matched at most once */
+    DirtyStat.page_sampling.blocks = g_new0(RamblockDirtyStat, block_count);
+
     RAMBLOCK_FOREACH_MIGRATABLE(block) {
         if (skip_sample_ramblock(block)) {
             continue;
@@ -883,11 +922,21 @@ void hmp_info_dirty_rate(Monitor *mon, const QDict *qdict)
                                rate->value->dirty_rate);
             }
         }
+        if (info->has_ramblock_dirty_rate) {
+            DirtyRateRAMBlockList *rate;
+
+            for (rate = info->ramblock_dirty_rate; rate; rate = rate->next) {
+                monitor_printf(mon, "ramblock %s (%"PRIu64" MB), Dirty rate: "
+                               "%"PRIi64" (MB/s)\n", rate->value->id,
+                               rate->value->size, rate->value->dirty_rate);
+            }
+        }
     } else {
         monitor_printf(mon, "(not ready)\n");
     }
 
     qapi_free_DirtyRateVcpuList(info->vcpu_dirty_rate);
+    qapi_free_DirtyRateRAMBlockList(info->ramblock_dirty_rate);
     g_free(info);
 }
 
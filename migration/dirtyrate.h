@@ -63,10 +63,22 @@ struct RamblockDirtyInfo {
     uint32_t *hash_result; /* array of hash result for sampled pages */
 };
 
+/*
+ * Store sampling results for each ramblock.
+ */
+typedef struct RamblockDirtyStat {
+    char idstr[RAMBLOCK_INFO_MAX_LEN]; /* idstr for each ramblock */
+    uint64_t dirty_samples; /* dirty sampled pages */
+    uint64_t sample_count; /* sampled pages */
+    uint64_t block_mem_MB; /* size of the ramblock in MB */
+} RamblockDirtyStat;
+
 typedef struct SampleVMStat {
     uint64_t total_dirty_samples; /* total dirty sampled page */
     uint64_t total_sample_count; /* total sampled pages */
     uint64_t total_block_mem_MB; /* size of total sampled pages in MB */
+    int nblocks; /* number of entries in blocks */
+    RamblockDirtyStat *blocks; /* per-ramblock sampling results */
 } SampleVMStat;
 
 /*
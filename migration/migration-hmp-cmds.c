@@ -238,6 +238,10 @@ void hmp_info_migrate(Monitor *mon, const QDict *qdict)
 
         monitor_printf(mon, "  Others: \t\tdirty_syncs=%" PRIu64,
                        info->ram->dirty_sync_count);
+        if (info->ram->dirty_sync_time) {
+            monitor_printf(mon, ", last_sync_us=%" PRIu64,
+                           info->ram->dirty_sync_time);
+        }
         if (info->ram->postcopy_requests) {
             monitor_printf(mon, ", postcopy_req=%" PRIu64,
                            info->ram->postcopy_requests);
@@ -292,6 +296,24 @@ void hmp_info_migrate(Monitor *mon, const QDict *qdict)
     }
 
     migration_dump_blocktime(mon, info);
+
+    if (info->downtime_stats) {
+        MigrationDowntimeCheckpointList *c;
+        MigrationDowntimeSectionList *sec;
+
+        monitor_printf(mon, "Downtime checkpoints (us):\n");
+        for (c = info->downtime_stats->checkpoints; c; c = c->next) {
+            monitor_printf(mon, "  %-36s %10" PRIu64 "\n",
+                           c->value->name, c->value->time);
+        }
+        monitor_printf(mon, "Downtime sections (us):\n");
+        for (sec = info->downtime_stats->sections; sec; sec = sec->next) {
+            monitor_printf(mon, "  %-28s %5" PRIu32 " %-12s %10" PRIu64 "\n",
+                           sec->value->idstr, sec->value->instance_id,
+                           sec->value->iterable ? "iterable" : "non-iterable",
+                           sec->value->time);
+        }
+    }
 out:
     qapi_free_MigrationInfo(info);
 }
@@ -52,6 +52,11 @@ typedef struct {
      * starts from 1 for the 1st iteration.
      */
     uint64_t dirty_sync_count;
+    /*
+     * Duration of the last dirty bitmap synchronization, in
+     * microseconds.
+     */
+    uint64_t dirty_sync_time;
     /*
      * Number of times zero copy failed to send any page using zero
      * copy.
@@ -102,9 +102,111 @@ static bool stop_return_path_thread_on_source(MigrationState *s);
 static void migration_release_dst_files(MigrationState *ms);
 static void migration_completion_end(MigrationState *s);
 
+/*
+ * Bound on the checkpoints and sections kept per side, COLO goes through
+ * the switchover code on every checkpoint.
+ */
+#define MIGRATION_DOWNTIME_MAX_ENTRIES 1024
+
+typedef struct MigrationDowntimeProfile {
+    int64_t start_us;
+    unsigned int entries;
+    MigrationDowntimeCheckpointList *checkpoints;
+    MigrationDowntimeCheckpointList **checkpoints_tail;
+    MigrationDowntimeSectionList *sections;
+    MigrationDowntimeSectionList **sections_tail;
+} MigrationDowntimeProfile;
+
+/* Indexed by "incoming", protected by downtime_profile_lock */
+static MigrationDowntimeProfile downtime_profile[2];
+static QemuMutex downtime_profile_lock;
+
+static void migration_downtime_profile_reset(bool incoming)
+{
+    MigrationDowntimeProfile *p = &downtime_profile[incoming];
+
+    QEMU_LOCK_GUARD(&downtime_profile_lock);
+    qapi_free_MigrationDowntimeCheckpointList(p->checkpoints);
+    qapi_free_MigrationDowntimeSectionList(p->sections);
+    p->checkpoints = NULL;
+    p->checkpoints_tail = &p->checkpoints;
+    p->sections = NULL;
+    p->sections_tail = &p->sections;
+    p->entries = 0;
+    p->start_us = 0;
+}
+
+void migration_downtime_checkpoint(bool incoming, const char *name)
+{
+    MigrationDowntimeProfile *p = &downtime_profile[incoming];
+    int64_t now = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
+    MigrationDowntimeCheckpoint *c;
+
+    trace_vmstate_downtime_checkpoint(name);
+
+    QEMU_LOCK_GUARD(&downtime_profile_lock);
+    if (!p->checkpoints_tail || p->entries >= MIGRATION_DOWNTIME_MAX_ENTRIES) {
+        return;
+    }
+    if (!p->checkpoints) {
+        p->start_us = now;
+    }
+
+    c = g_new0(MigrationDowntimeCheckpoint, 1);
+    c->name = g_strdup(name);
+    c->time = now - p->start_us;
+    QAPI_LIST_APPEND(p->checkpoints_tail, c);
+    p->entries++;
+}
+
+void migration_downtime_section(bool incoming, bool iterable,
+                                const char *idstr, uint32_t instance_id,
+                                int64_t time_us)
+{
+    MigrationDowntimeProfile *p = &downtime_profile[incoming];
+    const char *type = iterable ? "iterable" : "non-iterable";
+    MigrationDowntimeSection *sec;
+
+    if (incoming) {
+        trace_vmstate_downtime_load(type, idstr, instance_id, time_us);
+    } else {
+        trace_vmstate_downtime_save(type, idstr, instance_id, time_us);
+    }
+
+    QEMU_LOCK_GUARD(&downtime_profile_lock);
+    if (!p->sections_tail || p->entries >= MIGRATION_DOWNTIME_MAX_ENTRIES) {
+        return;
+    }
+
+    sec = g_new0(MigrationDowntimeSection, 1);
+    sec->idstr = g_strdup(idstr);
+    sec->instance_id = instance_id;
+    sec->iterable = iterable;
+    sec->time = time_us;
+    QAPI_LIST_APPEND(p->sections_tail, sec);
+    p->entries++;
+}
+
+static void populate_downtime_info(MigrationInfo *info, bool incoming)
+{
+    MigrationDowntimeProfile *p = &downtime_profile[incoming];
+
+    QEMU_LOCK_GUARD(&downtime_profile_lock);
+    if (!p->checkpoints) {
+        return;
+    }
+
+    qapi_free_MigrationDowntimeStats(info->downtime_stats);
+    info->downtime_stats = g_new0(MigrationDowntimeStats, 1);
+    info->downtime_stats->checkpoints =
+        QAPI_CLONE(MigrationDowntimeCheckpointList, p->checkpoints);
+    info->downtime_stats->sections =
+        QAPI_CLONE(MigrationDowntimeSectionList, p->sections);
+}
+
 static void migration_downtime_start(MigrationState *s)
 {
-    trace_vmstate_downtime_checkpoint("src-downtime-start");
+    migration_downtime_checkpoint(false, "src-downtime-start");
     s->downtime_start = qemu_clock_get_ms(QEMU_CLOCK_REALTIME);
 }
 
@@ -139,7 +241,7 @@ static void migration_downtime_end(MigrationState *s)
      */
     if (!s->downtime) {
         s->downtime = now - s->downtime_start;
-        trace_vmstate_downtime_checkpoint("src-downtime-end");
+        migration_downtime_checkpoint(false, "src-downtime-end");
     }
 }
 
@@ -287,7 +389,7 @@ static int migration_stop_vm(MigrationState *s, RunState state)
 
     ret = vm_stop_force_state(state);
 
-    trace_vmstate_downtime_checkpoint("src-vm-stopped");
+    migration_downtime_checkpoint(false, "src-vm-stopped");
     trace_migration_completion_vm_stop(ret);
 
     return ret;
@@ -309,6 +411,7 @@ void migration_object_init(void)
     current_incoming->postcopy_remote_fds =
         g_array_new(FALSE, TRUE, sizeof(struct PostCopyFD));
     qemu_mutex_init(&current_incoming->rp_mutex);
+    qemu_mutex_init(&downtime_profile_lock);
     qemu_mutex_init(&current_incoming->postcopy_prio_thread_mutex);
     qemu_event_init(&current_incoming->main_thread_load_event, false);
     qemu_sem_init(&current_incoming->postcopy_pause_sem_dst, 0);
@@ -536,12 +639,12 @@ static int migrate_send_rp_message(MigrationIncomingState *mis,
  *   Start: Address offset within the RB
  *   Len: Length in bytes required - must be a multiple of pagesize
  */
-int migrate_send_rp_message_req_pages(MigrationIncomingState *mis,
-                                      RAMBlock *rb, ram_addr_t start)
+int migrate_send_rp_message_req_pages_range(MigrationIncomingState *mis,
+                                            RAMBlock *rb, ram_addr_t start,
+                                            size_t len)
 {
     uint8_t bufc[12 + 1 + 255]; /* start (8), len (4), rbname up to 256 */
     size_t msglen = 12; /* start + len */
-    size_t len = qemu_ram_pagesize(rb);
     enum mig_rp_message_type msg_type;
     const char *rbname;
     int rbname_len;
@@ -573,6 +676,13 @@ int migrate_send_rp_message_req_pages(MigrationIncomingState *mis,
     return migrate_send_rp_message(mis, msg_type, msglen, bufc);
 }
 
+int migrate_send_rp_message_req_pages(MigrationIncomingState *mis,
+                                      RAMBlock *rb, ram_addr_t start)
+{
+    return migrate_send_rp_message_req_pages_range(mis, rb, start,
+                                                   qemu_ram_pagesize(rb));
+}
+
 int migrate_send_rp_req_pages(MigrationIncomingState *mis,
                               RAMBlock *rb, ram_addr_t start, uint64_t haddr,
                               uint32_t tid)
@@ -680,7 +790,7 @@ static void process_incoming_migration_bh(void *opaque)
 {
     MigrationIncomingState *mis = opaque;
 
-    trace_vmstate_downtime_checkpoint("dst-precopy-bh-enter");
+    migration_downtime_checkpoint(true, "dst-precopy-bh-enter");
 
     /*
      * This must happen after all error conditions are dealt with and
@@ -688,7 +798,7 @@ static void process_incoming_migration_bh(void *opaque)
      */
     qemu_announce_self(&mis->announce_timer, migrate_announce_params());
 
-    trace_vmstate_downtime_checkpoint("dst-precopy-bh-announced");
+    migration_downtime_checkpoint(true, "dst-precopy-bh-announced");
 
     multifd_recv_shutdown();
 
@@ -719,7 +829,7 @@ static void process_incoming_migration_bh(void *opaque)
     } else {
         runstate_set(global_state_get_runstate());
     }
-    trace_vmstate_downtime_checkpoint("dst-precopy-bh-vm-started");
+    migration_downtime_checkpoint(true, "dst-precopy-bh-vm-started");
     /*
      * This must happen after any state changes since as soon as an external
      * observer sees this event they might start to prod at the VM assuming
@@ -756,6 +866,7 @@ process_incoming_migration_co(void *opaque)
 
     mis->largest_page_size = qemu_ram_pagesize_largest();
     postcopy_state_set(POSTCOPY_INCOMING_NONE);
+    migration_downtime_profile_reset(true);
     migrate_set_state(&mis->state, MIGRATION_STATUS_SETUP,
                       MIGRATION_STATUS_ACTIVE);
 
@@ -763,7 +874,7 @@ process_incoming_migration_co(void *opaque)
     ret = qemu_loadvm_state(mis->from_src_file, &local_err);
     mis->loadvm_co = NULL;
 
-    trace_vmstate_downtime_checkpoint("dst-precopy-loadvm-completed");
+    migration_downtime_checkpoint(true, "dst-precopy-loadvm-completed");
 
     trace_process_incoming_migration_co_end(ret);
     if (mis->have_listen_thread) {
@@ -1113,6 +1224,8 @@ static void populate_ram_info(MigrationInfo *info, MigrationState *s)
     info->ram->mbps = s->mbps;
     info->ram->dirty_sync_count =
         qatomic_read(&mig_stats.dirty_sync_count);
+    info->ram->dirty_sync_time =
+        qatomic_read(&mig_stats.dirty_sync_time);
     info->ram->dirty_sync_missed_zero_copy =
         qatomic_read(&mig_stats.dirty_sync_missed_zero_copy);
     info->ram->postcopy_requests =
@@ -1224,6 +1337,7 @@ static void fill_source_migration_info(MigrationInfo *info)
         break;
     }
     info->status = state;
+    populate_downtime_info(info, false);
 
     QEMU_LOCK_GUARD(&s->error_mutex);
     if (s->error) {
@@ -1263,6 +1377,7 @@ static void fill_destination_migration_info(MigrationInfo *info)
         return;
     }
     info->status = mis->state;
+    populate_downtime_info(info, true);
 
     if (!info->error_desc) {
         MigrationState *s = migrate_get_current();
@@ -1727,6 +1842,7 @@ int migrate_init(MigrationState *s, Error **errp)
     mig_stats.dirty_sync_count = 1;
 
     migration_reset_vfio_bytes_transferred();
+    migration_downtime_profile_reset(false);
 
     s->postcopy_package_loaded = false;
 
@@ -2824,6 +2940,7 @@ static bool migration_switchover_start(MigrationState *s, Error **errp)
         error_setg(errp, "Switchover is interrupted");
         return false;
     }
+    migration_downtime_checkpoint(false, "src-switchover-prepared");
 
     /*
      * The final query to the whole system on dirty data to make sure we
@@ -2835,6 +2952,7 @@ static bool migration_switchover_start(MigrationState *s, Error **errp)
     if (!qemu_savevm_query_pending_final(s, &pending, errp)) {
         return false;
     }
+    migration_downtime_checkpoint(false, "src-final-dirty-synced");
 
     /* Inactivate disks except in COLO */
     if (!migrate_colo()) {
@@ -2846,6 +2964,7 @@ static bool migration_switchover_start(MigrationState *s, Error **errp)
             error_setg(errp, "Block inactivate failed during switchover");
             return false;
         }
+        migration_downtime_checkpoint(false, "src-block-inactivated");
     }
 
     migration_rate_set(RATE_LIMIT_DISABLED);
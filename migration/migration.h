@@ -510,6 +510,14 @@ struct MigrationState {
      */
     bool switchover_ack_legacy;
 
+    /*
+     * Whether device state may be sent over multifd channels when a
+     * compression method is configured.  Device state packets never go
+     * through the compression method, but older QEMUs refuse the
+     * combination, so machine types before 11.1 keep it off.
+     */
+    bool multifd_device_state_compression;
+
     /*
      * This save hostname when out-going migration starts
      */
@@ -562,6 +570,16 @@ void migration_start_incoming(void);
 
 int migration_call_notifiers(MigrationEventType type, Error **errp);
 
+/*
+ * Record a switchover checkpoint or the time spent saving/loading a
+ * section, for the downtime-stats reported by query-migrate.  Both also
+ * emit the matching vmstate_downtime_* trace event.
+ */
+void migration_downtime_checkpoint(bool incoming, const char *name);
+void migration_downtime_section(bool incoming, bool iterable,
+                                const char *idstr, uint32_t instance_id,
+                                int64_t time_us);
+
 int migrate_init(MigrationState *s, Error **errp);
 bool migration_is_blocked(Error **errp);
 /* True if outgoing migration has entered postcopy phase */
@@ -582,6 +600,9 @@ int migrate_send_rp_req_pages(MigrationIncomingState *mis, RAMBlock *rb,
                               ram_addr_t start, uint64_t haddr, uint32_t tid);
 int migrate_send_rp_message_req_pages(MigrationIncomingState *mis,
                                       RAMBlock *rb, ram_addr_t start);
+int migrate_send_rp_message_req_pages_range(MigrationIncomingState *mis,
+                                            RAMBlock *rb, ram_addr_t start,
+                                            size_t len);
 void migrate_send_rp_recv_bitmap(MigrationIncomingState *mis,
                                  char *block_name);
 void migrate_send_rp_resume_ack(MigrationIncomingState *mis, uint32_t value);
@@ -123,10 +123,20 @@ bool multifd_queue_device_state(char *idstr, uint32_t instance_id,
     return true;
 }
 
+/*
+ * Device state packets bypass the compression method: they only need the
+ * header and buffer iovecs, which every method allocates, and are received
+ * by multifd_device_state_recv() whatever the method.  Machine types
+ * before 11.1 still restrict them to uncompressed multifd.
+ */
 bool multifd_device_state_supported(void)
 {
-    return migrate_multifd() && !migrate_mapped_ram() &&
-        migrate_multifd_compression() == MULTIFD_COMPRESSION_NONE;
+    if (!migrate_multifd() || migrate_mapped_ram()) {
+        return false;
+    }
+
+    return migrate_multifd_device_state_compression() ||
+           migrate_multifd_compression() == MULTIFD_COMPRESSION_NONE;
 }
 
 static void multifd_device_state_save_thread_data_free(void *opaque)
@@ -99,7 +99,15 @@ static void multifd_send_prepare_iovs(MultiFDSendParams *p)
     uint32_t page_size = multifd_ram_page_size();
 
     for (int i = 0; i < pages->normal_num; i++) {
-        p->iov[p->iovs_num].iov_base = pages->block->host + pages->offset[i];
+        ram_addr_t offset = pages->offset[i];
+
+        /* Send runs of contiguous pages with a single iovec */
+        if (i && pages->offset[i - 1] + page_size == offset) {
+            p->iov[p->iovs_num - 1].iov_len += page_size;
+            continue;
+        }
+
+        p->iov[p->iovs_num].iov_base = pages->block->host + offset;
         p->iov[p->iovs_num].iov_len = page_size;
         p->iovs_num++;
     }
@@ -162,7 +170,10 @@ static void multifd_nocomp_recv_cleanup(MultiFDRecvParams *p)
 
 static int multifd_nocomp_recv(MultiFDRecvParams *p, Error **errp)
 {
+    uint32_t page_size = multifd_ram_page_size();
     uint32_t flags;
+    int niov = 0;
+    int ret;
 
     if (migrate_mapped_ram()) {
         return multifd_file_recv_data(p, errp);
@@ -183,11 +194,28 @@ static int multifd_nocomp_recv(MultiFDRecvParams *p, Error **errp)
     }
 
     for (int i = 0; i < p->normal_num; i++) {
-        p->iov[i].iov_base = p->host + p->normal[i];
-        p->iov[i].iov_len = multifd_ram_page_size();
         ramblock_recv_bitmap_set_offset(p->block, p->normal[i]);
+
+        /* Read runs of contiguous pages with a single iovec */
+        if (i && p->normal[i - 1] + page_size == p->normal[i]) {
+            p->iov[niov - 1].iov_len += page_size;
+            continue;
+        }
+
+        p->iov[niov].iov_base = p->host + p->normal[i];
+        p->iov[niov].iov_len = page_size;
+        niov++;
     }
-    return qio_channel_readv_all(p->c, p->iov, p->normal_num, errp);
+
+    ret = qio_channel_readv_full_all_eof(p->c, p->iov, niov, NULL, NULL,
+                                         p->read_flags &
+                                         QIO_CHANNEL_READ_FLAG_WAITALL,
+                                         errp);
+    if (ret == 0) {
+        error_setg(errp, "multifd %u: unexpected end-of-file", p->id);
+        return -1;
+    }
+    return ret < 0 ? -1 : 0;
 }
 
 static void multifd_pages_reset(MultiFDPages_t *pages)
@@ -459,6 +487,77 @@ bool multifd_send_prepare_common(MultiFDSendParams *p)
     return true;
 }
 
+/* Marks a page in zlen[] whose compression is still in flight */
+#define MULTIFD_COMPRESS_QUEUED UINT32_MAX
+
+static void multifd_send_fill_iov(MultiFDSendParams *p, void *base,
+                                  uint32_t len)
+{
+    p->iov[p->iovs_num].iov_base = base;
+    p->iov[p->iovs_num].iov_len = len;
+    p->iovs_num++;
+    p->next_packet_size += len;
+}
+
+/**
+ * multifd_send_compress_pages: compress the normal pages one by one
+ *
+ * Builds the payload shared by the per-page compression methods: an
+ * array of big endian lengths, one per normal page, followed by the
+ * pages themselves.  A page whose length equals the page size is sent
+ * uncompressed, which is done whenever compression fails or does not
+ * shrink it.
+ *
+ * All pages are submitted before any completion is waited for, so an
+ * asynchronous engine works on the whole packet at once.  Does not wait
+ * at all if @ops has no @submit hook.
+ *
+ * @p: Params for the channel being used
+ * @ops: compression hooks of the method
+ * @opaque: passed to the hooks
+ * @zlen: array of at least page count lengths
+ * @zbuf: output buffer of at least page count pages; page @i is
+ *        compressed to @zbuf + @i * page size
+ */
+void multifd_send_compress_pages(MultiFDSendParams *p,
+                                 const MultiFDCompressPageOps *ops,
+                                 void *opaque, uint32_t *zlen, uint8_t *zbuf)
+{
+    MultiFDPages_t *pages = &p->data->u.ram;
+    uint32_t page_size = multifd_ram_page_size();
+
+    multifd_send_fill_iov(p, zlen, pages->normal_num * sizeof(uint32_t));
+
+    for (int i = 0; i < pages->normal_num; i++) {
+        uint8_t *in = pages->block->host + pages->offset[i];
+        uint8_t *out = zbuf + (size_t)page_size * i;
+
+        if (ops->submit && ops->submit(opaque, i, in, out, page_size)) {
+            zlen[i] = MULTIFD_COMPRESS_QUEUED;
+        } else {
+            zlen[i] = ops->compress(opaque, in, out, page_size);
+        }
+    }
+
+    for (int i = 0; i < pages->normal_num; i++) {
+        uint8_t *in = pages->block->host + pages->offset[i];
+        uint8_t *out = zbuf + (size_t)page_size * i;
+        uint32_t len = zlen[i];
+
+        if (len == MULTIFD_COMPRESS_QUEUED) {
+            len = ops->complete(opaque, i);
+        }
+
+        if (len && len < page_size) {
+            zlen[i] = cpu_to_be32(len);
+            multifd_send_fill_iov(p, out, len);
+        } else {
+            zlen[i] = cpu_to_be32(page_size);
+            multifd_send_fill_iov(p, in, page_size);
+        }
+    }
+}
+
 static const MultiFDMethods multifd_nocomp_ops = {
     .send_setup = multifd_nocomp_send_setup,
     .send_cleanup = multifd_nocomp_send_cleanup,
@@ -26,10 +26,6 @@ typedef struct {
     qpl_job *job;
     /* indicates if fallback to software path is required */
     bool fallback_sw_path;
-    /* output data from the software path */
-    uint8_t *sw_output;
-    /* output data length from the software path */
-    uint32_t sw_output_len;
 } QplHwJob;
 
 typedef struct {
@@ -315,43 +311,6 @@ static void multifd_qpl_prepare_decomp_job(qpl_job *job, uint8_t *input,
     multifd_qpl_prepare_job(job, false, input, len, output, size);
 }
 
-/**
- * multifd_qpl_fill_iov: fill in the IOV
- *
- * Fill in the QPL packet IOV
- *
- * @p: Params for the channel being used
- * @data: pointer to the IOV data
- * @len: The length of the IOV data
- */
-static void multifd_qpl_fill_iov(MultiFDSendParams *p, uint8_t *data,
-                                 uint32_t len)
-{
-    p->iov[p->iovs_num].iov_base = data;
-    p->iov[p->iovs_num].iov_len = len;
-    p->iovs_num++;
-    p->next_packet_size += len;
-}
-
-/**
- * multifd_qpl_fill_packet: fill the compressed page into the QPL packet
- *
- * Fill the compressed page length and IOV into the QPL packet
- *
- * @idx: The index of the compressed length array
- * @p: Params for the channel being used
- * @data: pointer to the compressed page buffer
- * @len: The length of the compressed page
- */
-static void multifd_qpl_fill_packet(uint32_t idx, MultiFDSendParams *p,
-                                    uint8_t *data, uint32_t len)
-{
-    QplData *qpl = p->compress_data;
-
-    qpl->zlen[idx] = cpu_to_be32(len);
-    multifd_qpl_fill_iov(p, data, len);
-}
-
 /**
  * multifd_qpl_submit_job: submit a job to the hardware
  *
@@ -378,115 +337,79 @@ retry:
 }
 
 /**
- * multifd_qpl_compress_pages_slow_path: compress pages using slow path
- *
- * Compress the pages using software. If compression fails, the uncompressed
- * page will be sent.
+ * multifd_qpl_comp_submit: submit a page to the IAA for compression
  *
- * @p: Params for the channel being used
+ * Returns true if the job is submitted successfully, otherwise false.
  */
-static void multifd_qpl_compress_pages_slow_path(MultiFDSendParams *p)
+static bool multifd_qpl_comp_submit(void *opaque, uint32_t idx,
+                                    uint8_t *in, uint8_t *out, uint32_t size)
 {
-    QplData *qpl = p->compress_data;
-    MultiFDPages_t *pages = &p->data->u.ram;
-    uint32_t size = multifd_ram_page_size();
-    qpl_job *job = qpl->sw_job;
-    uint8_t *zbuf = qpl->zbuf;
-    uint8_t *buf;
+    QplData *qpl = opaque;
+    qpl_job *job = qpl->hw_jobs[idx].job;
 
-    for (int i = 0; i < pages->normal_num; i++) {
-        buf = pages->block->host + pages->offset[i];
-        multifd_qpl_prepare_comp_job(job, buf, zbuf, size);
-        if (qpl_execute_job(job) == QPL_STS_OK) {
-            multifd_qpl_fill_packet(i, p, zbuf, job->total_out);
-        } else {
-            /* send the uncompressed page */
-            multifd_qpl_fill_packet(i, p, buf, size);
-        }
-        zbuf += size;
-    }
+    multifd_qpl_prepare_comp_job(job, in, out, size);
+    /*
+     * If the IAA work queue is full, any immediate subsequent job
+     * submission is likely to fail, compressing the page via the QPL
+     * software path at this point gives us a better chance of finding
+     * the queue open for the next pages.
+     */
+    return multifd_qpl_submit_job(job);
 }
 
 /**
- * multifd_qpl_compress_pages: compress pages
- *
- * Submit the pages to the IAA hardware for compression. If hardware
- * compression fails, it falls back to software compression. If software
- * compression also fails, the uncompressed page is sent.
+ * multifd_qpl_comp_complete: wait for a submitted compression job
  *
- * @p: Params for the channel being used
+ * Returns the compressed length, or 0 if the hardware job failed.
  */
-static void multifd_qpl_compress_pages(MultiFDSendParams *p)
+static uint32_t multifd_qpl_comp_complete(void *opaque, uint32_t idx)
 {
-    QplData *qpl = p->compress_data;
-    MultiFDPages_t *pages = &p->data->u.ram;
-    uint32_t size = multifd_ram_page_size();
-    QplHwJob *hw_job;
-    uint8_t *buf;
-    uint8_t *zbuf;
+    QplData *qpl = opaque;
+    qpl_job *job = qpl->hw_jobs[idx].job;
 
-    for (int i = 0; i < pages->normal_num; i++) {
-        buf = pages->block->host + pages->offset[i];
-        zbuf = qpl->zbuf + (size * i);
-        hw_job = &qpl->hw_jobs[i];
-        multifd_qpl_prepare_comp_job(hw_job->job, buf, zbuf, size);
-        if (multifd_qpl_submit_job(hw_job->job)) {
-            hw_job->fallback_sw_path = false;
-        } else {
-            /*
-             * The IAA work queue is full, any immediate subsequent job
-             * submission is likely to fail, sending the page via the QPL
-             * software path at this point gives us a better chance of
-             * finding the queue open for the next pages.
-             */
-            hw_job->fallback_sw_path = true;
-            multifd_qpl_prepare_comp_job(qpl->sw_job, buf, zbuf, size);
-            if (qpl_execute_job(qpl->sw_job) == QPL_STS_OK) {
-                hw_job->sw_output = zbuf;
-                hw_job->sw_output_len = qpl->sw_job->total_out;
-            } else {
-                hw_job->sw_output = buf;
-                hw_job->sw_output_len = size;
-            }
-        }
-    }
+    return qpl_wait_job(job) == QPL_STS_OK ? job->total_out : 0;
+}
 
-    for (int i = 0; i < pages->normal_num; i++) {
-        buf = pages->block->host + pages->offset[i];
-        zbuf = qpl->zbuf + (size * i);
-        hw_job = &qpl->hw_jobs[i];
-        if (hw_job->fallback_sw_path) {
-            multifd_qpl_fill_packet(i, p, hw_job->sw_output,
-                                    hw_job->sw_output_len);
-            continue;
-        }
-        if (qpl_wait_job(hw_job->job) == QPL_STS_OK) {
-            multifd_qpl_fill_packet(i, p, zbuf, hw_job->job->total_out);
-        } else {
-            /* send the uncompressed page */
-            multifd_qpl_fill_packet(i, p, buf, size);
-        }
-    }
+/**
+ * multifd_qpl_comp_sw: compress a page using the software path
+ *
+ * Returns the compressed length, or 0 if compression failed.
+ */
+static uint32_t multifd_qpl_comp_sw(void *opaque, uint8_t *in, uint8_t *out,
+                                    uint32_t size)
+{
+    QplData *qpl = opaque;
+
+    multifd_qpl_prepare_comp_job(qpl->sw_job, in, out, size);
+    return qpl_execute_job(qpl->sw_job) == QPL_STS_OK ?
+           qpl->sw_job->total_out : 0;
 }
 
+static const MultiFDCompressPageOps multifd_qpl_hw_comp_ops = {
+    .submit = multifd_qpl_comp_submit,
+    .complete = multifd_qpl_comp_complete,
+    .compress = multifd_qpl_comp_sw,
+};
+
+static const MultiFDCompressPageOps multifd_qpl_sw_comp_ops = {
+    .compress = multifd_qpl_comp_sw,
+};
+
 static int multifd_qpl_send_prepare(MultiFDSendParams *p, Error **errp)
 {
     QplData *qpl = p->compress_data;
-    MultiFDPages_t *pages = &p->data->u.ram;
-    uint32_t len = 0;
 
     if (!multifd_send_prepare_common(p)) {
         goto out;
     }
 
-    /* The first IOV is used to store the compressed page lengths */
-    len = pages->normal_num * sizeof(uint32_t);
-    multifd_qpl_fill_iov(p, (uint8_t *) qpl->zlen, len);
-    if (qpl->hw_avail) {
-        multifd_qpl_compress_pages(p);
-    } else {
-        multifd_qpl_compress_pages_slow_path(p);
-    }
+    /*
+     * Send the compressed page lengths, followed by the pages. All pages
+     * are submitted to the IAA before waiting for any of them.
+     */
+    multifd_send_compress_pages(p, qpl->hw_avail ? &multifd_qpl_hw_comp_ops
+                                                 : &multifd_qpl_sw_comp_ops,
+                                qpl, qpl->zlen, qpl->zbuf);
 
 out:
     p->flags |= MULTIFD_FLAG_QPL;
@@ -46,7 +46,11 @@ static struct wd_data *multifd_uadk_init_sess(uint32_t count,
 {
     struct wd_comp_sess_setup ss = {0};
     struct sched_params param = {0};
-    uint32_t size = count * page_size;
+    /*
+     * The compressor may write up to two pages for the last page's slot,
+     * see multifd_uadk_compress(), so it gets one page past the slots.
+     */
+    size_t size = (size_t)(compress ? count + 1 : count) * page_size;
     struct wd_data *wd;
 
     wd = g_new0(struct wd_data, 1);
@@ -55,8 +59,6 @@ static struct wd_data *multifd_uadk_init_sess(uint32_t count,
         ss.alg_type = WD_ZLIB;
         if (compress) {
             ss.op_type = WD_DIR_COMPRESS;
-            /* Add an additional page for handling output > input */
-            size += page_size;
         } else {
             ss.op_type = WD_DIR_DECOMPRESS;
         }
@@ -136,68 +138,59 @@ static void multifd_uadk_send_cleanup(MultiFDSendParams *p, Error **errp)
     p->iov = NULL;
 }
 
-static inline void prepare_next_iov(MultiFDSendParams *p, void *base,
-                                    uint32_t len)
+static uint32_t multifd_uadk_compress(void *opaque, uint8_t *in,
+                                      uint8_t *out, uint32_t size)
 {
-    p->iov[p->iovs_num].iov_base = (uint8_t *)base;
-    p->iov[p->iovs_num].iov_len = len;
-    p->next_packet_size += len;
-    p->iovs_num++;
+    struct wd_data *uadk_data = opaque;
+    struct wd_comp_req creq = {
+        .op_type = WD_DIR_COMPRESS,
+        .src     = in,
+        .src_len = size,
+        .dst     = out,
+        /*
+         * Set dst_len to double the src in case compressed out >= page_size.
+         * Such a page is sent raw and pages are compressed in order, so
+         * spilling into the next page's slot is fine.  The buffer is
+         * allocated with one page past the last slot for its spill.
+         */
+        .dst_len = size * 2,
+    };
+    int ret;
+
+    /*
+     * Send raw data if no UADK hardware or if compressed out >= page_size.
+     * We might be better off sending raw data if output is slightly less
+     * than page_size as well because at the receive end we can skip the
+     * decompression. But it is tricky to find the right number here.
+     */
+    if (!uadk_data->handle) {
+        return 0;
+    }
+
+    ret = wd_do_comp_sync(uadk_data->handle, &creq);
+    if (ret || creq.status) {
+        warn_report_once("multifd: UADK compression failed, ret %d status %d, "
+                         "sending pages uncompressed", ret, creq.status);
+        return 0;
+    }
+    return creq.dst_len;
 }
 
+static const MultiFDCompressPageOps multifd_uadk_comp_ops = {
+    .compress = multifd_uadk_compress,
+};
+
 static int multifd_uadk_send_prepare(MultiFDSendParams *p, Error **errp)
 {
     struct wd_data *uadk_data = p->compress_data;
-    uint32_t hdr_size;
-    uint32_t page_size = multifd_ram_page_size();
-    uint8_t *buf = uadk_data->buf;
-    int ret = 0;
-    MultiFDPages_t *pages = &p->data->u.ram;
 
     if (!multifd_send_prepare_common(p)) {
         goto out;
     }
 
-    hdr_size = pages->normal_num * sizeof(uint32_t);
-    /* prepare the header that stores the lengths of all compressed data */
-    prepare_next_iov(p, uadk_data->buf_hdr, hdr_size);
-
-    for (int i = 0; i < pages->normal_num; i++) {
-        struct wd_comp_req creq = {
-            .op_type = WD_DIR_COMPRESS,
-            .src     = pages->block->host + pages->offset[i],
-            .src_len = page_size,
-            .dst     = buf,
-            /* Set dst_len to double the src in case compressed out >= page_size */
-            .dst_len = page_size * 2,
-        };
-
-        if (uadk_data->handle) {
-            ret = wd_do_comp_sync(uadk_data->handle, &creq);
-            if (ret || creq.status) {
-                error_setg(errp, "multifd %u: failed compression, ret %d status %d",
-                           p->id, ret, creq.status);
-                return -1;
-            }
-            if (creq.dst_len < page_size) {
-                uadk_data->buf_hdr[i] = cpu_to_be32(creq.dst_len);
-                prepare_next_iov(p, buf, creq.dst_len);
-                buf += creq.dst_len;
-            }
-        }
-        /*
-         * Send raw data if no UADK hardware or if compressed out >= page_size.
-         * We might be better off sending raw data if output is slightly less
-         * than page_size as well because at the receive end we can skip the
-         * decompression. But it is tricky to find the right number here.
-         */
-        if (!uadk_data->handle || creq.dst_len >= page_size) {
-            uadk_data->buf_hdr[i] = cpu_to_be32(page_size);
-            prepare_next_iov(p, pages->block->host + pages->offset[i],
-                             page_size);
-            buf += page_size;
-        }
-    }
+    /* The header stores the lengths of all compressed data */
+    multifd_send_compress_pages(p, &multifd_uadk_comp_ops, uadk_data,
+                                uadk_data->buf_hdr, uadk_data->buf);
 out:
     p->flags |= MULTIFD_FLAG_UADK;
     multifd_send_fill_packet(p);
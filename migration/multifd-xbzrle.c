@@ -0,0 +1,382 @@
+/*
+ * Multifd XBZRLE delta compression implementation
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/bswap.h"
+#include "qemu/thread.h"
+#include "system/ramblock.h"
+#include "exec/target_page.h"
+#include "qapi/error.h"
+#include "migration.h"
+#include "migration-stats.h"
+#include "options.h"
+#include "multifd.h"
+#include "page_cache.h"
+#include "xbzrle.h"
+
+/*
+ * The page cache holds what the destination currently has for a page,
+ * so it has to be shared by all channels: a page is not guaranteed to
+ * be sent on the same channel twice.  It is split in shards, selected
+ * by page index, so that channels rarely contend on the same lock.
+ */
+#define MULTIFD_XBZRLE_SHARDS 16
+
+typedef struct {
+    QemuMutex lock;
+    PageCache *cache;
+} MultiFDXbzrleShard;
+
+static struct {
+    QemuMutex lock;
+    unsigned int users;
+    MultiFDXbzrleShard shard[MULTIFD_XBZRLE_SHARDS];
+    uint8_t *zero_page;
+} multifd_xbzrle;
+
+struct xbzrle_data {
+    /* copy of the page being encoded, the guest may be writing to it */
+    uint8_t *buf;
+    /* encoded size of each page, big endian */
+    uint32_t *sizes;
+    /* encoded pages */
+    uint8_t *zbuff;
+    /* size of zbuff */
+    uint32_t zbuff_len;
+};
+
+static void multifd_xbzrle_cache_fini(void)
+{
+    int i;
+
+    for (i = 0; i < MULTIFD_XBZRLE_SHARDS; i++) {
+        if (multifd_xbzrle.shard[i].cache) {
+            cache_fini(multifd_xbzrle.shard[i].cache);
+            multifd_xbzrle.shard[i].cache = NULL;
+        }
+        qemu_mutex_destroy(&multifd_xbzrle.shard[i].lock);
+    }
+    g_free(multifd_xbzrle.zero_page);
+    multifd_xbzrle.zero_page = NULL;
+}
+
+static int multifd_xbzrle_cache_get(Error **errp)
+{
+    uint32_t page_size = multifd_ram_page_size();
+    uint64_t shard_size = migrate_xbzrle_cache_size() / MULTIFD_XBZRLE_SHARDS;
+    int ret = 0;
+    int i;
+
+    QEMU_LOCK_GUARD(&multifd_xbzrle.lock);
+
+    if (multifd_xbzrle.users++) {
+        return 0;
+    }
+
+    for (i = 0; i < MULTIFD_XBZRLE_SHARDS; i++) {
+        qemu_mutex_init(&multifd_xbzrle.shard[i].lock);
+    }
+    for (i = 0; i < MULTIFD_XBZRLE_SHARDS; i++) {
+        multifd_xbzrle.shard[i].cache = cache_init(shard_size, page_size,
+                                                   errp);
+        if (!multifd_xbzrle.shard[i].cache) {
+            error_prepend(errp, "xbzrle-cache-size is too small for %d "
+                          "multifd xbzrle shards: ", MULTIFD_XBZRLE_SHARDS);
+            ret = -1;
+            break;
+        }
+    }
+    if (ret) {
+        multifd_xbzrle_cache_fini();
+        multifd_xbzrle.users--;
+        return ret;
+    }
+    multifd_xbzrle.zero_page = g_malloc0(page_size);
+    return 0;
+}
+
+static void multifd_xbzrle_cache_put(void)
+{
+    QEMU_LOCK_GUARD(&multifd_xbzrle.lock);
+
+    assert(multifd_xbzrle.users);
+    if (!--multifd_xbzrle.users) {
+        multifd_xbzrle_cache_fini();
+    }
+}
+
+/*
+ * Consecutive pages go to consecutive shards; strip the shard index
+ * from the key so that every shard uses all of its slots.
+ */
+static MultiFDXbzrleShard *multifd_xbzrle_shard(ram_addr_t addr,
+                                                uint64_t *key)
+{
+    uint32_t page_size = multifd_ram_page_size();
+    uint64_t index = addr / page_size;
+
+    *key = (index / MULTIFD_XBZRLE_SHARDS) * page_size;
+    return &multifd_xbzrle.shard[index % MULTIFD_XBZRLE_SHARDS];
+}
+
+/* Multifd xbzrle compression */
+
+static int multifd_xbzrle_send_setup(MultiFDSendParams *p, Error **errp)
+{
+    struct xbzrle_data *z;
+    uint32_t page_count = multifd_ram_page_count();
+
+    if (multifd_xbzrle_cache_get(errp)) {
+        return -1;
+    }
+
+    z = g_new0(struct xbzrle_data, 1);
+    z->buf = g_malloc(multifd_ram_page_size());
+    z->sizes = g_new0(uint32_t, page_count);
+    z->zbuff_len = MULTIFD_PACKET_SIZE;
+    z->zbuff = g_malloc(z->zbuff_len);
+    p->compress_data = z;
+
+    /* Needs 3 IOVs: packet header, page sizes and encoded data */
+    p->iov = g_new0(struct iovec, 3);
+
+    return 0;
+}
+
+static void multifd_xbzrle_send_cleanup(MultiFDSendParams *p, Error **errp)
+{
+    struct xbzrle_data *z = p->compress_data;
+
+    if (!z) {
+        /* send_setup failed before taking a cache reference */
+        return;
+    }
+
+    g_free(z->buf);
+    g_free(z->sizes);
+    g_free(z->zbuff);
+    g_free(p->compress_data);
+    p->compress_data = NULL;
+
+    g_free(p->iov);
+    p->iov = NULL;
+
+    multifd_xbzrle_cache_put();
+}
+
+/*
+ * Until the first pass over RAM is complete nearly every page is sent
+ * for the first time, so do not bother with the cache.
+ */
+static bool multifd_xbzrle_started(uint64_t age)
+{
+    return age > 1;
+}
+
+static uint32_t multifd_xbzrle_encode(struct xbzrle_data *z, ram_addr_t addr,
+                                      uint8_t *dst, uint64_t age)
+{
+    uint32_t page_size = multifd_ram_page_size();
+    MultiFDXbzrleShard *s;
+    uint64_t key;
+    int len = -1;
+
+    if (!multifd_xbzrle_started(age)) {
+        memcpy(dst, z->buf, page_size);
+        return page_size;
+    }
+
+    s = multifd_xbzrle_shard(addr, &key);
+    qemu_mutex_lock(&s->lock);
+    if (cache_is_cached(s->cache, key, age)) {
+        /* Keep the delta strictly smaller than the page to tell them apart */
+        len = xbzrle_encode_buffer(get_cached_data(s->cache, key), z->buf,
+                                   page_size, dst, page_size - 1);
+    }
+    /* A failed insertion leaves no entry behind, which is fine */
+    cache_insert(s->cache, key, z->buf, age);
+    qemu_mutex_unlock(&s->lock);
+
+    if (len < 0) {
+        memcpy(dst, z->buf, page_size);
+        return page_size;
+    }
+    return len;
+}
+
+static void multifd_xbzrle_cache_zero_pages(MultiFDPages_t *pages,
+                                            uint64_t age)
+{
+    MultiFDXbzrleShard *s;
+    uint64_t key;
+    uint32_t i;
+
+    if (!multifd_xbzrle_started(age)) {
+        return;
+    }
+
+    /* Must let the cache know, a previously cached page would be stale */
+    for (i = pages->normal_num; i < pages->num; i++) {
+        s = multifd_xbzrle_shard(pages->block->offset + pages->offset[i],
+                                 &key);
+        qemu_mutex_lock(&s->lock);
+        cache_insert(s->cache, key, multifd_xbzrle.zero_page, age);
+        qemu_mutex_unlock(&s->lock);
+    }
+}
+
+static int multifd_xbzrle_send_prepare(MultiFDSendParams *p, Error **errp)
+{
+    MultiFDPages_t *pages = &p->data->u.ram;
+    struct xbzrle_data *z = p->compress_data;
+    uint64_t age = qatomic_read(&mig_stats.dirty_sync_count);
+    uint32_t page_size = multifd_ram_page_size();
+    uint32_t out_size = 0;
+    bool has_normal;
+    uint32_t i;
+
+    has_normal = multifd_send_prepare_common(p);
+    multifd_xbzrle_cache_zero_pages(pages, age);
+    if (!has_normal) {
+        goto out;
+    }
+
+    for (i = 0; i < pages->normal_num; i++) {
+        ram_addr_t offset = pages->offset[i];
+        uint32_t len;
+
+        /*
+         * The page may be changing while we encode it, and the cache must
+         * hold exactly what the destination ends up with.  Work on a copy.
+         */
+        memcpy(z->buf, pages->block->host + offset, page_size);
+        len = multifd_xbzrle_encode(z, pages->block->offset + offset,
+                                    z->zbuff + out_size, age);
+        z->sizes[i] = cpu_to_be32(len);
+        out_size += len;
+    }
+
+    p->iov[p->iovs_num].iov_base = z->sizes;
+    p->iov[p->iovs_num].iov_len = pages->normal_num * sizeof(uint32_t);
+    p->iovs_num++;
+    p->iov[p->iovs_num].iov_base = z->zbuff;
+    p->iov[p->iovs_num].iov_len = out_size;
+    p->iovs_num++;
+    p->next_packet_size = pages->normal_num * sizeof(uint32_t) + out_size;
+
+out:
+    p->flags |= MULTIFD_FLAG_XBZRLE;
+    multifd_send_fill_packet(p);
+    return 0;
+}
+
+static int multifd_xbzrle_recv_setup(MultiFDRecvParams *p, Error **errp)
+{
+    struct xbzrle_data *z = g_new0(struct xbzrle_data, 1);
+
+    z->zbuff_len = MULTIFD_PACKET_SIZE +
+                   multifd_ram_page_count() * sizeof(uint32_t);
+    z->zbuff = g_malloc(z->zbuff_len);
+    p->compress_data = z;
+    return 0;
+}
+
+static void multifd_xbzrle_recv_cleanup(MultiFDRecvParams *p)
+{
+    struct xbzrle_data *z = p->compress_data;
+
+    g_free(z->zbuff);
+    g_free(p->compress_data);
+    p->compress_data = NULL;
+}
+
+static int multifd_xbzrle_recv(MultiFDRecvParams *p, Error **errp)
+{
+    struct xbzrle_data *z = p->compress_data;
+    uint32_t in_size = p->next_packet_size;
+    uint32_t page_size = multifd_ram_page_size();
+    uint32_t flags = p->flags & MULTIFD_FLAG_COMPRESSION_MASK;
+    uint32_t hdr_size = p->normal_num * sizeof(uint32_t);
+    uint8_t *data;
+    int ret;
+    int i;
+
+    if (flags != MULTIFD_FLAG_XBZRLE) {
+        error_setg(errp, "multifd %u: flags received %x flags expected %x",
+                   p->id, flags, MULTIFD_FLAG_XBZRLE);
+        return -1;
+    }
+
+    multifd_recv_zero_page_process(p);
+
+    if (!p->normal_num) {
+        assert(in_size == 0);
+        return 0;
+    }
+
+    if (in_size < hdr_size || in_size > z->zbuff_len) {
+        error_setg(errp, "multifd %u: packet size %u out of range",
+                   p->id, in_size);
+        return -1;
+    }
+
+    ret = qio_channel_read_all(p->c, (void *)z->zbuff, in_size, errp);
+    if (ret != 0) {
+        return ret;
+    }
+
+    data = z->zbuff + hdr_size;
+    in_size -= hdr_size;
+
+    for (i = 0; i < p->normal_num; i++) {
+        uint32_t len = ldl_be_p(z->zbuff + i * sizeof(uint32_t));
+        uint8_t *host = p->host + p->normal[i];
+
+        if (len > page_size || len > in_size) {
+            error_setg(errp, "multifd %u: page %d has invalid size %u",
+                       p->id, i, len);
+            return -1;
+        }
+
+        ramblock_recv_bitmap_set_offset(p->block, p->normal[i]);
+        if (len == page_size) {
+            memcpy(host, data, page_size);
+        } else if (len &&
+                   xbzrle_decode_buffer(data, len, host, page_size) < 0) {
+            error_setg(errp, "multifd %u: failed to decode page %d",
+                       p->id, i);
+            return -1;
+        }
+        data += len;
+        in_size -= len;
+    }
+
+    if (in_size) {
+        error_setg(errp, "multifd %u: %u trailing bytes in packet",
+                   p->id, in_size);
+        return -1;
+    }
+
+    return 0;
+}
+
+static const MultiFDMethods multifd_xbzrle_ops = {
+    .send_setup = multifd_xbzrle_send_setup,
+    .send_cleanup = multifd_xbzrle_send_cleanup,
+    .send_prepare = multifd_xbzrle_send_prepare,
+    .recv_setup = multifd_xbzrle_recv_setup,
+    .recv_cleanup = multifd_xbzrle_recv_cleanup,
+    .recv = multifd_xbzrle_recv
+};
+
+static void multifd_xbzrle_register(void)
+{
+    qemu_mutex_init(&multifd_xbzrle.lock);
+    multifd_register_ops(MULTIFD_COMPRESSION_XBZRLE, &multifd_xbzrle_ops);
+}
+
+migration_init(multifd_xbzrle_register);
@@ -41,7 +41,8 @@ static void swap_page_offset(ram_addr_t *pages_offset, int a, int b)
  * multifd_send_zero_page_detect: Perform zero page detection on all pages.
  *
  * Sorts normal pages before zero pages in p->pages->offset and updates
- * p->pages->normal_num.
+ * p->pages->normal_num.  Normal pages keep their relative order, so
+ * that contiguous pages stay adjacent and can share an iovec.
  *
  * @param p A pointer to the send params.
  */
@@ -49,8 +50,7 @@ void multifd_send_zero_page_detect(MultiFDSendParams *p)
 {
     MultiFDPages_t *pages = &p->data->u.ram;
     RAMBlock *rb = pages->block;
-    int i = 0;
-    int j = pages->num - 1;
+    int normal = 0;
 
     if (!multifd_zero_page_enabled()) {
         pages->normal_num = pages->num;
@@ -61,20 +61,19 @@ void multifd_send_zero_page_detect(MultiFDSendParams *p)
      * Sort the page offset array by moving all normal pages to
      * the left and all zero pages to the right of the array.
      */
-    while (i <= j) {
+    for (int i = 0; i < pages->num; i++) {
         uint64_t offset = pages->offset[i];
 
-        if (!buffer_is_zero(rb->host + offset, multifd_ram_page_size())) {
-            i++;
+        if (buffer_is_zero(rb->host + offset, multifd_ram_page_size())) {
+            ram_release_page(rb->idstr, offset);
             continue;
         }
 
-        swap_page_offset(pages->offset, i, j);
-        ram_release_page(rb->idstr, offset);
-        j--;
+        swap_page_offset(pages->offset, normal, i);
+        normal++;
     }
 
-    pages->normal_num = i;
+    pages->normal_num = normal;
 
 out:
     qatomic_add(&mig_stats.normal_pages, pages->normal_num);
@@ -1288,8 +1288,13 @@ static void *multifd_recv_thread(void *opaque)
     trace_multifd_recv_thread_start(p->id);
     rcu_register_thread();
 
+    /*
+     * Packets are large and always read in full, let the kernel fill
+     * them instead of waking us up for every segment that arrives.
+     */
+    p->read_flags = QIO_CHANNEL_READ_FLAG_WAITALL;
     if (!s->multifd_clean_tls_termination) {
-        p->read_flags = QIO_CHANNEL_READ_FLAG_RELAXED_EOF;
+        p->read_flags |= QIO_CHANNEL_READ_FLAG_RELAXED_EOF;
     }
 
     while (true) {
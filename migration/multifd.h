@@ -66,6 +66,8 @@ MultiFDRecvData *multifd_get_recv_data(void);
 #define MULTIFD_FLAG_QPL (4 << 1)
 #define MULTIFD_FLAG_UADK (8 << 1)
 #define MULTIFD_FLAG_QATZIP (16 << 1)
+/* Methods are matched by value, so this one reuses a combination */
+#define MULTIFD_FLAG_XBZRLE (3 << 1)
 
 /*
  * If set it means that this packet contains device state
@@ -379,9 +381,37 @@ typedef struct {
     int (*recv)(MultiFDRecvParams *p, Error **errp);
 } MultiFDMethods;
 
+/*
+ * Hooks for methods that compress each page independently, usually on
+ * an offload engine.  See multifd_send_compress_pages().
+ */
+typedef struct {
+    /*
+     * Optional.  Queue the compression of page @idx from @in to @out
+     * without waiting for it.  Returns false if the job could not be
+     * queued, in which case @compress is used for that page instead.
+     */
+    bool (*submit)(void *opaque, uint32_t idx, uint8_t *in, uint8_t *out,
+                   uint32_t size);
+    /*
+     * Wait for the job queued for page @idx.  Returns the compressed
+     * length, or 0 if compression failed.
+     */
+    uint32_t (*complete)(void *opaque, uint32_t idx);
+    /*
+     * Compress @in to @out synchronously.  Returns the compressed
+     * length, or 0 if compression failed.
+     */
+    uint32_t (*compress)(void *opaque, uint8_t *in, uint8_t *out,
+                         uint32_t size);
+} MultiFDCompressPageOps;
+
 void multifd_register_ops(int method, const MultiFDMethods *ops);
 void multifd_send_fill_packet(MultiFDSendParams *p);
 bool multifd_send_prepare_common(MultiFDSendParams *p);
+void multifd_send_compress_pages(MultiFDSendParams *p,
+                                 const MultiFDCompressPageOps *ops,
+                                 void *opaque, uint32_t *zlen, uint8_t *zbuf);
 void multifd_send_zero_page_detect(MultiFDSendParams *p);
 void multifd_recv_zero_page_process(MultiFDRecvParams *p);
 
@@ -112,6 +112,8 @@ const Property migration_properties[] = {
                      multifd_clean_tls_termination, true),
     DEFINE_PROP_BOOL("switchover-ack-legacy", MigrationState,
                      switchover_ack_legacy, false),
+    DEFINE_PROP_BOOL("multifd-device-state-compression", MigrationState,
+                     multifd_device_state_compression, true),
 
     /* Migration parameters */
     DEFINE_PROP_UINT8("x-throttle-trigger-threshold", MigrationState,
@@ -215,6 +217,10 @@ const Property migration_properties[] = {
                         MIGRATION_CAPABILITY_SWITCHOVER_ACK),
     DEFINE_PROP_MIG_CAP("x-dirty-limit", MIGRATION_CAPABILITY_DIRTY_LIMIT),
     DEFINE_PROP_MIG_CAP("mapped-ram", MIGRATION_CAPABILITY_MAPPED_RAM),
+    DEFINE_PROP_MIG_CAP("x-mapped-ram-mmap",
+                        MIGRATION_CAPABILITY_X_MAPPED_RAM_MMAP),
+    DEFINE_PROP_MIG_CAP("x-ram-cold-first",
+                        MIGRATION_CAPABILITY_X_RAM_COLD_FIRST),
     DEFINE_PROP_MIG_CAP("x-ignore-shared",
                         MIGRATION_CAPABILITY_X_IGNORE_SHARED),
 };
@@ -350,6 +356,20 @@ bool migrate_mapped_ram(void)
     return s->capabilities[MIGRATION_CAPABILITY_MAPPED_RAM];
 }
 
+bool migrate_mapped_ram_mmap(void)
+{
+    MigrationState *s = migrate_get_current();
+
+    return s->capabilities[MIGRATION_CAPABILITY_X_MAPPED_RAM_MMAP];
+}
+
+bool migrate_ram_cold_first(void)
+{
+    MigrationState *s = migrate_get_current();
+
+    return s->capabilities[MIGRATION_CAPABILITY_X_RAM_COLD_FIRST];
+}
+
 bool migrate_ignore_shared(void)
 {
     MigrationState *s = migrate_get_current();
@@ -457,6 +477,13 @@ bool migrate_multifd_flush_after_each_section(void)
     return s->multifd_flush_after_each_section;
 }
 
+bool migrate_multifd_device_state_compression(void)
+{
+    MigrationState *s = migrate_get_current();
+
+    return s->multifd_device_state_compression;
+}
+
 bool migrate_postcopy(void)
 {
     return migrate_postcopy_ram() || migrate_dirty_bitmaps();
@@ -742,6 +769,10 @@ bool migrate_caps_check(bool *old_caps, bool *new_caps, Error **errp)
                        "Mapped-ram migration is incompatible with postcopy");
             return false;
         }
+    } else if (new_caps[MIGRATION_CAPABILITY_X_MAPPED_RAM_MMAP]) {
+        error_setg(errp, "Capability 'x-mapped-ram-mmap' requires capability "
+                   "'mapped-ram'");
+        return false;
     }
 
     /*
@@ -1278,6 +1309,13 @@ bool migrate_params_check(MigrationParameters *params, Error **errp)
         return false;
     }
 
+    if (params->multifd_compression == MULTIFD_COMPRESSION_XBZRLE &&
+        params->zero_page_detection == ZERO_PAGE_DETECTION_LEGACY) {
+        error_setg(errp, "multifd-compression xbzrle is not compatible with "
+                   "legacy zero-page-detection");
+        return false;
+    }
+
     if (params->x_vcpu_dirty_limit_period < 1 ||
         params->x_vcpu_dirty_limit_period > 1000) {
         error_setg(errp, "Option x-vcpu-dirty-limit-period expects "
@@ -1285,12 +1323,6 @@ bool migrate_params_check(MigrationParameters *params, Error **errp)
         return false;
     }
 
-    if (params->vcpu_dirty_limit < 1) {
-        error_setg(errp,
-                   "Parameter 'vcpu-dirty-limit' must be greater than 1 MB/s");
-        return false;
-    }
-
     if (params->direct_io && !qemu_has_direct_io()) {
         error_setg(errp, "No build-time support for direct-io");
         return false;
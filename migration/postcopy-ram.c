@@ -17,6 +17,7 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/units.h"
 #include "qemu/madvise.h"
 #include "exec/target_page.h"
 #include "migration.h"
@@ -973,6 +974,65 @@ static int postcopy_request_page(MigrationIncomingState *mis, RAMBlock *rb,
     return migrate_send_rp_req_pages(mis, rb, start, haddr, tid);
 }
 
+/*
+ * Fault-driven prefetch
+ *
+ * Faults that land right after the previous one are treated as a
+ * sequential access and grow the window of following pages requested
+ * together with the faulting one, up to POSTCOPY_PREFETCH_MAX bytes;
+ * any other fault shrinks it back.  The source already moves its
+ * background scan to the last requested page, so prefetching only
+ * needs to cover the distance the next faults are likely to reach
+ * before the scan gets there.
+ */
+#define POSTCOPY_PREFETCH_MIN_PAGES 4
+#define POSTCOPY_PREFETCH_MAX       (256 * KiB)
+
+typedef struct {
+    RAMBlock *rb;
+    /* Last fault, and the end of the range requested along with it */
+    ram_addr_t start;
+    ram_addr_t end;
+    size_t window;
+} PostcopyPrefetch;
+
+static void postcopy_prefetch(MigrationIncomingState *mis,
+                              PostcopyPrefetch *pf, RAMBlock *rb,
+                              ram_addr_t start)
+{
+    size_t pagesize = qemu_ram_pagesize(rb);
+    size_t min_window = pagesize * POSTCOPY_PREFETCH_MIN_PAGES;
+    ram_addr_t addr, limit;
+
+    if (min_window > POSTCOPY_PREFETCH_MAX) {
+        return;
+    }
+
+    if (pf->rb == rb && start > pf->start && start <= pf->end) {
+        /* Still walking through the range covered by the last fault */
+        pf->window = MIN(pf->window * 2, POSTCOPY_PREFETCH_MAX);
+        addr = MAX(pf->end, start + pagesize);
+    } else {
+        pf->rb = rb;
+        pf->window = min_window;
+        addr = start + pagesize;
+    }
+    pf->start = start;
+
+    limit = MIN(start + pagesize + pf->window, rb->used_length);
+    pf->end = addr;
+    while (pf->end < limit &&
+           !ramblock_recv_bitmap_test_byte_offset(rb, pf->end) &&
+           !ramblock_page_is_discarded(rb, pf->end)) {
+        pf->end += pagesize;
+    }
+
+    if (pf->end > addr) {
+        trace_postcopy_prefetch(qemu_ram_get_idstr(rb), addr, pf->end - addr);
+        migrate_send_rp_message_req_pages_range(mis, rb, addr, pf->end - addr);
+    }
+}
+
 /*
  * Callback from shared fault handlers to ask for a page,
  * the page must be specified by a RAMBlock and an offset in that rb
@@ -1277,6 +1337,7 @@ static void *postcopy_ram_fault_thread(void *opaque)
     int ret;
     size_t index;
     RAMBlock *rb = NULL;
+    PostcopyPrefetch prefetch = { };
 
     trace_postcopy_ram_fault_thread_entry();
     rcu_register_thread();
@@ -1398,6 +1459,7 @@ retry:
                 postcopy_pause_fault_thread(mis);
                 goto retry;
             }
+            postcopy_prefetch(mis, &prefetch, rb, rb_offset);
         }
 
         /* Now handle any requests from external processes on shared memory */
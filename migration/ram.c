@@ -27,6 +27,7 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/units.h"
 #include "qemu/cutils.h"
 #include "qemu/bitops.h"
 #include "qemu/bitmap.h"
@@ -57,8 +58,11 @@
 #include "system/ramblock.h"
 #include "savevm.h"
 #include "qemu/iov.h"
+#include "block/thread-pool.h"
+#include "io/channel-file.h"
 #include "multifd.h"
 #include "system/runstate.h"
+#include "system/system.h"
 #include "rdma.h"
 #include "options.h"
 #include "system/dirtylimit.h"
@@ -91,6 +95,17 @@
  */
 #define MAPPED_RAM_LOAD_BUF_SIZE 0x100000
 
+/*
+ * With x-mapped-ram-mmap, runs of saved pages at least this long are
+ * mapped from the file.  Every mapped run costs a VMA, so stop after
+ * MAPPED_RAM_MMAP_MAX_RUNS of them and read the rest as usual.
+ */
+#define MAPPED_RAM_MMAP_MIN_SIZE 0x200000
+#define MAPPED_RAM_MMAP_MAX_RUNS 16384
+
+/* Runs mapped during the current incoming migration */
+static unsigned int mapped_ram_mmap_runs;
+
 XBZRLECacheStats xbzrle_counters;
 
 /*
@@ -398,6 +413,8 @@ struct RAMState {
     uint64_t xbzrle_bytes_prev;
     /* Are we really using XBZRLE (e.g., after the first round). */
     bool xbzrle_started;
+    /* Skip hot chunks until the next wrap around RAM (x-ram-cold-first) */
+    bool defer_hot;
     /* Are we on the last stage of migration */
     bool last_stage;
 
@@ -414,6 +431,8 @@ struct RAMState {
      * - pss structures
      */
     QemuMutex bitmap_mutex;
+    /* Workers for migration_bitmap_sync() on large guests, or NULL */
+    ThreadPool *sync_pool;
     /* The RAMBlock used in the last src_page_requests */
     RAMBlock *last_req_rb;
     /* Queue of outstanding page requests from the destination */
@@ -936,67 +955,122 @@ bool ramblock_page_is_discarded(RAMBlock *rb, ram_addr_t start)
     return false;
 }
 
-/* Called with RCU critical section */
-static uint64_t physical_memory_sync_dirty_bitmap(RAMBlock *rb,
-                                                  ram_addr_t start,
-                                                  ram_addr_t length)
+/* Number of bitmap words checked at once for dirty pages */
+#define DIRTY_SYNC_CHUNK_LONGS  (512 / sizeof(long))
+
+/* Whether the range can be synced one bitmap word at a time */
+static bool physical_memory_sync_word_aligned(RAMBlock *rb, ram_addr_t start,
+                                              ram_addr_t length)
+{
+    ram_addr_t mask = (BITS_PER_LONG << TARGET_PAGE_BITS) - 1;
+
+    return !((start + rb->offset) & mask) && !(length & mask);
+}
+
+/*
+ * Move the dirty bits of a word aligned range of @rb from @src into
+ * rb->bmap.  Only touches the words of that range, so disjoint ranges
+ * can be scanned concurrently.
+ *
+ * Returns the number of pages that were not dirty in rb->bmap yet.
+ */
+static uint64_t physical_memory_sync_dirty_words(RAMBlock *rb,
+                                                 unsigned long * const *src,
+                                                 ram_addr_t start,
+                                                 ram_addr_t length)
 {
     unsigned long word = BIT_WORD((start + rb->offset) >> TARGET_PAGE_BITS);
-    uint64_t num_dirty = 0;
+    int k, n;
+    int nr = BITS_TO_LONGS(length >> TARGET_PAGE_BITS);
+    unsigned long idx = (word * BITS_PER_LONG) / DIRTY_MEMORY_BLOCK_SIZE;
+    unsigned long offset = BIT_WORD((word * BITS_PER_LONG) %
+                                    DIRTY_MEMORY_BLOCK_SIZE);
+    unsigned long page = BIT_WORD(start >> TARGET_PAGE_BITS);
     unsigned long *dest = rb->bmap;
+    uint64_t num_dirty = 0;
 
-    /* start address and length is aligned at the start of a word? */
-    if (((word * BITS_PER_LONG) << TARGET_PAGE_BITS) ==
-         (start + rb->offset) &&
-        !(length & ((BITS_PER_LONG << TARGET_PAGE_BITS) - 1))) {
-        int k;
-        int nr = BITS_TO_LONGS(length >> TARGET_PAGE_BITS);
-        unsigned long * const *src;
-        unsigned long idx = (word * BITS_PER_LONG) / DIRTY_MEMORY_BLOCK_SIZE;
-        unsigned long offset = BIT_WORD((word * BITS_PER_LONG) %
-                                        DIRTY_MEMORY_BLOCK_SIZE);
-        unsigned long page = BIT_WORD(start >> TARGET_PAGE_BITS);
-
-        src = qatomic_rcu_read(
-                &ram_list.dirty_memory[DIRTY_MEMORY_MIGRATION])->blocks;
-
-        for (k = page; k < page + nr; k++) {
-            if (src[idx][offset]) {
-                unsigned long bits = qatomic_xchg(&src[idx][offset], 0);
-                unsigned long new_dirty;
-                new_dirty = ~dest[k];
-                dest[k] |= bits;
-                new_dirty &= bits;
-                num_dirty += ctpopl(new_dirty);
-            }
+    for (k = page; k < page + nr; k += n) {
+        int j;
 
-            if (++offset >= BITS_TO_LONGS(DIRTY_MEMORY_BLOCK_SIZE)) {
-                offset = 0;
-                idx++;
+        n = MIN(page + nr - k,
+                BITS_TO_LONGS(DIRTY_MEMORY_BLOCK_SIZE) - offset);
+        n = MIN(n, DIRTY_SYNC_CHUNK_LONGS);
+
+        /*
+         * Dirty pages tend to be clustered, so skip clean stretches
+         * of the bitmap with the vectorized zero check.
+         */
+        if (!buffer_is_zero(&src[idx][offset], n * sizeof(long))) {
+            for (j = 0; j < n; j++) {
+                if (src[idx][offset + j]) {
+                    unsigned long bits =
+                        qatomic_xchg(&src[idx][offset + j], 0);
+                    unsigned long new_dirty;
+                    new_dirty = ~dest[k + j];
+                    dest[k + j] |= bits;
+                    new_dirty &= bits;
+                    num_dirty += ctpopl(new_dirty);
+                }
             }
         }
-        if (num_dirty) {
-            physical_memory_dirty_bits_cleared(start, length);
-        }
 
-        if (rb->clear_bmap) {
-            /*
-             * Postpone the dirty bitmap clear to the point before we
-             * really send the pages, also we will split the clear
-             * dirty procedure into smaller chunks.
-             */
-            clear_bmap_set(rb, start >> TARGET_PAGE_BITS,
-                           length >> TARGET_PAGE_BITS);
-        } else {
-            /* Slow path - still do that in a huge chunk */
-            memory_region_clear_dirty_bitmap(rb->mr, start, length);
+        offset += n;
+        if (offset >= BITS_TO_LONGS(DIRTY_MEMORY_BLOCK_SIZE)) {
+            offset = 0;
+            idx++;
         }
+    }
+
+    return num_dirty;
+}
+
+/* Second half of a word aligned sync, once the range has been scanned */
+static void physical_memory_sync_dirty_finish(RAMBlock *rb, ram_addr_t start,
+                                              ram_addr_t length,
+                                              uint64_t num_dirty)
+{
+    if (num_dirty) {
+        physical_memory_dirty_bits_cleared(start, length);
+    }
+
+    if (rb->clear_bmap) {
+        /*
+         * Postpone the dirty bitmap clear to the point before we
+         * really send the pages, also we will split the clear
+         * dirty procedure into smaller chunks.
+         */
+        clear_bmap_set(rb, start >> TARGET_PAGE_BITS,
+                       length >> TARGET_PAGE_BITS);
+    } else {
+        /* Slow path - still do that in a huge chunk */
+        memory_region_clear_dirty_bitmap(rb->mr, start, length);
+    }
+}
+
+static unsigned long * const *physical_memory_migration_dirty_blocks(void)
+{
+    return qatomic_rcu_read(
+            &ram_list.dirty_memory[DIRTY_MEMORY_MIGRATION])->blocks;
+}
+
+/* Called with RCU critical section */
+static uint64_t physical_memory_sync_dirty_bitmap(RAMBlock *rb,
+                                                  ram_addr_t start,
+                                                  ram_addr_t length)
+{
+    uint64_t num_dirty;
+
+    if (physical_memory_sync_word_aligned(rb, start, length)) {
+        num_dirty = physical_memory_sync_dirty_words(
+                        rb, physical_memory_migration_dirty_blocks(),
+                        start, length);
+        physical_memory_sync_dirty_finish(rb, start, length, num_dirty);
     } else {
         num_dirty = physical_memory_test_and_clear_dirty(
                         start + rb->offset,
                         length,
                         DIRTY_MEMORY_MIGRATION,
-                        dest);
+                        rb->bmap);
     }
 
     return num_dirty;
@@ -1012,6 +1086,106 @@ static void ramblock_sync_dirty_bitmap(RAMState *rs, RAMBlock *rb)
     rs->num_dirty_pages_period += new_dirty_pages;
 }
 
+/*
+ * Guests with at least RAM_SYNC_PARALLEL_MIN bytes of word aligned
+ * RAMBlocks get their dirty bitmaps merged by up to RAM_SYNC_THREADS
+ * workers, in pieces of RAM_SYNC_CHUNK bytes.
+ */
+#define RAM_SYNC_PARALLEL_MIN   (16 * GiB)
+#define RAM_SYNC_CHUNK          (1 * GiB)
+#define RAM_SYNC_THREADS        8
+
+typedef struct {
+    RAMBlock *block;
+    unsigned long * const *src;
+    ram_addr_t start;
+    ram_addr_t length;
+    uint64_t num_dirty;
+} RAMSyncChunk;
+
+static int ram_sync_chunk(void *opaque)
+{
+    RAMSyncChunk *c = opaque;
+
+    c->num_dirty = physical_memory_sync_dirty_words(c->block, c->src,
+                                                    c->start, c->length);
+    return 0;
+}
+
+/*
+ * Called with RCU critical section and bitmap_mutex held.  The workers
+ * rely on the caller's RCU critical section to keep the blocks and the
+ * dirty memory bitmaps alive.
+ *
+ * Returns false if the guest is too small to bother, and nothing was
+ * synced.
+ */
+static bool ram_sync_dirty_bitmap_parallel(RAMState *rs)
+{
+    unsigned long * const *src = physical_memory_migration_dirty_blocks();
+    RAMSyncChunk *chunks;
+    RAMBlock *block;
+    ram_addr_t total = 0;
+    int nchunks = 0;
+    int i = 0;
+
+    RAMBLOCK_FOREACH_NOT_IGNORED(block) {
+        if (physical_memory_sync_word_aligned(block, 0, block->used_length)) {
+            total += block->used_length;
+            nchunks += DIV_ROUND_UP(block->used_length, RAM_SYNC_CHUNK);
+        }
+    }
+    if (total < RAM_SYNC_PARALLEL_MIN) {
+        return false;
+    }
+
+    if (!rs->sync_pool) {
+        rs->sync_pool = thread_pool_new();
+        thread_pool_set_max_threads(rs->sync_pool, RAM_SYNC_THREADS);
+    }
+
+    chunks = g_new(RAMSyncChunk, nchunks);
+    RAMBLOCK_FOREACH_NOT_IGNORED(block) {
+        ram_addr_t start;
+
+        if (!physical_memory_sync_word_aligned(block, 0, block->used_length)) {
+            continue;
+        }
+        for (start = 0; start < block->used_length; start += RAM_SYNC_CHUNK) {
+            RAMSyncChunk *c = &chunks[i++];
+
+            c->block = block;
+            c->src = src;
+            c->start = start;
+            c->length = MIN(RAM_SYNC_CHUNK, block->used_length - start);
+            thread_pool_submit(rs->sync_pool, ram_sync_chunk, c, NULL);
+        }
+    }
+    assert(i == nchunks);
+
+    /* The odd unaligned blocks are small, sync them meanwhile */
+    RAMBLOCK_FOREACH_NOT_IGNORED(block) {
+        if (!physical_memory_sync_word_aligned(block, 0, block->used_length)) {
+            ramblock_sync_dirty_bitmap(rs, block);
+        }
+    }
+
+    thread_pool_wait(rs->sync_pool);
+
+    /* clear_bmap is not updated atomically, finish from this thread */
+    for (i = 0; i < nchunks; i++) {
+        RAMSyncChunk *c = &chunks[i];
+
+        physical_memory_sync_dirty_finish(c->block, c->start, c->length,
+                                          c->num_dirty);
+        rs->migration_dirty_pages += c->num_dirty;
+        rs->num_dirty_pages_period += c->num_dirty;
+    }
+    g_free(chunks);
+
+    return true;
+}
+
 /**
  * ram_pagesize_summary: calculate all the pagesizes of a VM
  *
@@ -1072,10 +1246,84 @@ static void migration_update_rates(RAMState *rs, int64_t end_time)
     }
 }
 
+typedef struct {
+    int cpu_index;
+    int64_t dirty_rate;
+} VcpuDirtyRateSample;
+
+static int vcpu_dirty_rate_sample_cmp(const void *a, const void *b)
+{
+    const VcpuDirtyRateSample *sa = a;
+    const VcpuDirtyRateSample *sb = b;
+
+    return sa->dirty_rate < sb->dirty_rate ? -1 :
+           sa->dirty_rate > sb->dirty_rate;
+}
+
+/*
+ * Adaptive dirty-limit, used when vcpu-dirty-limit is 0
+ *
+ * The guest may dirty memory at a total rate that lets one round worth
+ * of dirty pages be sent within the downtime limit.  That budget is
+ * shared out by water-filling: vCPUs dirtying less than an even share
+ * keep their rate and hand the rest over, and only the vCPUs above the
+ * final share get throttled.  Since each round measures the throttled
+ * rates, the quotas follow the working set from one round to the next.
+ */
+static void migration_dirty_limit_guest_adaptive(uint64_t bytes_dirty_period)
+{
+    MigrationState *s = migrate_get_current();
+    uint64_t bw = MAX(s->mbps, 0) / 8;
+    uint64_t budget, used;
+    VcpuDirtyRateSample *samples;
+    CPUState *cpu;
+    int ncpus = 0;
+    int i;
+
+    budget = bw * migrate_throttle_trigger_threshold() / 100;
+    if (bytes_dirty_period > s->threshold_size) {
+        budget = MIN(budget, bw * s->threshold_size / bytes_dirty_period);
+    }
+    budget = MAX(budget, 1);
+
+    if (!dirtylimit_in_service()) {
+        /*
+         * No per-vCPU rates before the dirty limit is running, so start
+         * by only capping vCPUs that would exceed the whole budget.
+         */
+        qmp_set_vcpu_dirty_limit(false, -1, budget, NULL);
+        trace_migration_dirty_limit_guest(budget);
+        return;
+    }
+
+    CPU_FOREACH(cpu) {
+        ncpus++;
+    }
+    samples = g_new(VcpuDirtyRateSample, ncpus);
+    i = 0;
+    CPU_FOREACH(cpu) {
+        samples[i].cpu_index = cpu->cpu_index;
+        samples[i].dirty_rate = vcpu_dirty_rate_get(cpu->cpu_index);
+        i++;
+    }
+    qsort(samples, ncpus, sizeof(*samples), vcpu_dirty_rate_sample_cmp);
+
+    for (i = 0; i < ncpus; i++) {
+        uint64_t share = MAX(budget / (ncpus - i), 1);
+
+        qmp_set_vcpu_dirty_limit(true, samples[i].cpu_index, share, NULL);
+        trace_migration_dirty_limit_vcpu(samples[i].cpu_index,
+                                         samples[i].dirty_rate, share);
+        used = MIN((uint64_t)MAX(samples[i].dirty_rate, 0), share);
+        budget = budget > used ? budget - used : 0;
+    }
+    g_free(samples);
+}
+
 /*
  * Enable dirty-limit to throttle down the guest
  */
-static void migration_dirty_limit_guest(void)
+static void migration_dirty_limit_guest(uint64_t bytes_dirty_period)
 {
     /*
      * dirty page rate quota for all vCPUs fetched from
@@ -1084,6 +1332,12 @@ static void migration_dirty_limit_guest(void)
     static int64_t quota_dirtyrate;
     MigrationState *s = migrate_get_current();
 
+    if (!s->parameters.vcpu_dirty_limit) {
+        quota_dirtyrate = 0;
+        migration_dirty_limit_guest_adaptive(bytes_dirty_period);
+        return;
+    }
+
     /*
      * If dirty limit already enabled and migration parameter
      * vcpu-dirty-limit untouched.
@@ -1126,14 +1380,67 @@ static void migration_trigger_throttle(RAMState *rs)
             mig_throttle_guest_down(bytes_dirty_period,
                                     bytes_dirty_threshold);
         } else if (migrate_dirty_limit()) {
-            migration_dirty_limit_guest();
+            migration_dirty_limit_guest(bytes_dirty_period);
         }
     }
 }
 
+/* Granularity of RAMBlock.dirty_history */
+#define RAM_DIRTY_HISTORY_CHUNK (2 * MiB)
+/* A chunk found dirty by both of the last two syncs is hot */
+#define RAM_DIRTY_HISTORY_HOT 0x3
+
+static unsigned int ram_dirty_history_shift(void)
+{
+    return ctz64(MAX(RAM_DIRTY_HISTORY_CHUNK >> TARGET_PAGE_BITS, 1));
+}
+
+static unsigned long ram_dirty_history_size(RAMBlock *rb)
+{
+    unsigned long pages = rb->max_length >> TARGET_PAGE_BITS;
+
+    return DIV_ROUND_UP(pages, 1UL << ram_dirty_history_shift());
+}
+
+/*
+ * Must be called before the block's dirty bitmap is synced: rb->bmap
+ * still holds pages left unsent from earlier rounds, so look at what the
+ * guest dirtied since the last sync in the global bitmap instead.
+ */
+static void ram_dirty_history_update(RAMBlock *rb)
+{
+    unsigned long pages = rb->used_length >> TARGET_PAGE_BITS;
+    unsigned int shift = ram_dirty_history_shift();
+    unsigned long chunk = 1UL << shift;
+    unsigned long page;
+
+    for (page = 0; page < pages; page += chunk) {
+        unsigned long end = MIN(page + chunk, pages);
+        bool dirty = physical_memory_get_dirty(
+            rb->offset + ((ram_addr_t)page << TARGET_PAGE_BITS),
+            (ram_addr_t)(end - page) << TARGET_PAGE_BITS,
+            DIRTY_MEMORY_MIGRATION);
+        uint8_t *history = &rb->dirty_history[page >> shift];
+
+        *history = (*history << 1) | dirty;
+    }
+}
+
+static bool ram_page_is_hot(RAMBlock *rb, unsigned long page)
+{
+    if (!rb->dirty_history ||
+        page >= (rb->used_length >> TARGET_PAGE_BITS)) {
+        return false;
+    }
+
+    return (rb->dirty_history[page >> ram_dirty_history_shift()] &
+            RAM_DIRTY_HISTORY_HOT) == RAM_DIRTY_HISTORY_HOT;
+}
+
 static void migration_bitmap_sync(RAMState *rs, bool last_stage)
 {
     RAMBlock *block;
+    int64_t start_time_us = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
     int64_t end_time;
 
     if (!rs->time_last_bitmap_sync) {
@@ -1145,13 +1452,24 @@ static void migration_bitmap_sync(RAMState *rs, bool last_stage)
 
     WITH_QEMU_LOCK_GUARD(&rs->bitmap_mutex) {
         WITH_RCU_READ_LOCK_GUARD() {
-            RAMBLOCK_FOREACH_NOT_IGNORED(block) {
-                ramblock_sync_dirty_bitmap(rs, block);
+            if (migrate_ram_cold_first()) {
+                RAMBLOCK_FOREACH_NOT_IGNORED(block) {
+                    ram_dirty_history_update(block);
+                }
+                rs->defer_hot = true;
+            }
+
+            if (!ram_sync_dirty_bitmap_parallel(rs)) {
+                RAMBLOCK_FOREACH_NOT_IGNORED(block) {
+                    ramblock_sync_dirty_bitmap(rs, block);
+                }
             }
         }
     }
 
     memory_global_after_dirty_log_sync();
+    qatomic_set(&mig_stats.dirty_sync_time,
+                qemu_clock_get_us(QEMU_CLOCK_REALTIME) - start_time_us);
     trace_migration_bitmap_sync_end(rs->num_dirty_pages_period);
 
     end_time = qemu_clock_get_ms(QEMU_CLOCK_REALTIME);
@@ -1366,6 +1684,14 @@ static int find_dirty_block(RAMState *rs, PageSearchStatus *pss)
     /* Update pss->page for the next dirty bit in ramblock */
     pss_find_next_dirty(pss);
 
+    /* Leave the hot chunks for after the next wrap around RAM */
+    while (rs->defer_hot && ram_page_is_hot(pss->block, pss->page)) {
+        unsigned long chunk = 1UL << ram_dirty_history_shift();
+
+        pss->page = ROUND_UP(pss->page + 1, chunk);
+        pss_find_next_dirty(pss);
+    }
+
     if (pss->complete_round && pss->block == rs->last_seen_block &&
         pss->page >= rs->last_page) {
         /*
@@ -1390,8 +1716,16 @@ static int find_dirty_block(RAMState *rs, PageSearchStatus *pss)
 
             /* Hit the end of the list */
             pss->block = QLIST_FIRST_RCU(&ram_list.blocks);
-            /* Flag that we've looped */
-            pss->complete_round = true;
+            if (rs->defer_hot) {
+                /*
+                 * Everything cold was sent, go around once more for the
+                 * hot chunks before concluding that RAM is clean.
+                 */
+                rs->defer_hot = false;
+            } else {
+                /* Flag that we've looped */
+                pss->complete_round = true;
+            }
             /* After the first round, enable XBZRLE. */
             if (migrate_xbzrle()) {
                 rs->xbzrle_started = true;
@@ -2415,6 +2749,7 @@ static void ram_state_cleanup(RAMState **rsp)
 {
     if (*rsp) {
         migration_page_queue_free(*rsp);
+        g_clear_pointer(&(*rsp)->sync_pool, thread_pool_free);
         qemu_mutex_destroy(&(*rsp)->bitmap_mutex);
         qemu_mutex_destroy(&(*rsp)->src_page_req_mutex);
         g_free(*rsp);
@@ -2447,6 +2782,8 @@ static void ram_bitmaps_destroy(void)
         block->clear_bmap = NULL;
         g_free(block->bmap);
         block->bmap = NULL;
+        g_free(block->dirty_history);
+        block->dirty_history = NULL;
         g_free(block->file_bmap);
         block->file_bmap = NULL;
     }
@@ -2842,6 +3179,10 @@ static void ram_list_init_bitmaps(void)
              */
             block->bmap = bitmap_new(pages);
             bitmap_set(block->bmap, 0, pages);
+            if (migrate_ram_cold_first()) {
+                block->dirty_history =
+                    g_new0(uint8_t, ram_dirty_history_size(block));
+            }
             if (migrate_mapped_ram()) {
                 block->file_bmap = bitmap_new(pages);
             }
@@ -3755,6 +4096,7 @@ static int ram_load_setup(QEMUFile *f, void *opaque, Error **errp)
 {
     xbzrle_load_setup();
     ramblock_recv_map_init();
+    mapped_ram_mmap_runs = 0;
 
     return 0;
 }
@@ -4079,6 +4421,81 @@ static bool handle_zero_mapped_ram(RAMBlock *block, unsigned long from_bit_idx,
     return true;
 }
 
+#ifndef _WIN32
+/* Returns the fd to map @block's pages from, or -1 to read them */
+static int mapped_ram_mmap_fd(QEMUFile *f, RAMBlock *block)
+{
+    QIOChannel *ioc = qemu_file_get_ioc(f);
+
+    if (!migrate_mapped_ram_mmap() ||
+        !object_dynamic_cast(OBJECT(ioc), TYPE_QIO_CHANNEL_FILE)) {
+        return -1;
+    }
+
+    /*
+     * Replacing the mapping behaves like a discard, and only anonymous
+     * private memory can be replaced without the owner noticing.  The new
+     * mapping would not be locked either.
+     */
+    if (ram_block_discard_is_disabled() || should_mlock(mlock_state) ||
+        qemu_ram_is_shared(block) || block->fd >= 0 ||
+        qemu_ram_pagesize(block) != qemu_real_host_page_size()) {
+        return -1;
+    }
+
+    return QIO_CHANNEL_FILE(ioc)->fd;
+}
+
+/*
+ * Map @size bytes of saved pages at @offset copy-on-write from the file.
+ *
+ * Returns: 1 if mapped, 0 if the range has to be read instead, -1 on
+ * error (with @errp set).
+ */
+static int mapped_ram_mmap_pages(int fd, RAMBlock *block, ram_addr_t offset,
+                                 size_t size, Error **errp)
+{
+    size_t hps = qemu_real_host_page_size();
+    off_t file_offset = block->pages_offset + offset;
+    int ret;
+
+    if (size < MAPPED_RAM_MMAP_MIN_SIZE ||
+        mapped_ram_mmap_runs >= MAPPED_RAM_MMAP_MAX_RUNS ||
+        !QEMU_IS_ALIGNED(offset | size | file_offset, hps)) {
+        return 0;
+    }
+
+    if (!host_from_ram_block_offset(block, offset) ||
+        offset + size > block->used_length) {
+        error_setg(errp, "page outside of ramblock %s range", block->idstr);
+        return -1;
+    }
+
+    ret = qemu_ram_map_file_cow(block, offset, size, fd, file_offset);
+    if (ret < 0) {
+        /* The old pages may be gone already, there is no going back */
+        error_setg_errno(errp, -ret, "(%s) failed to map pages "
+                         RAM_ADDR_FMT " from file offset %" PRIx64,
+                         block->idstr, offset, (uint64_t)file_offset);
+        return -1;
+    }
+    mapped_ram_mmap_runs++;
+
+    return 1;
+}
+#else
+static int mapped_ram_mmap_fd(QEMUFile *f, RAMBlock *block)
+{
+    return -1;
+}
+
+static int mapped_ram_mmap_pages(int fd, RAMBlock *block, ram_addr_t offset,
+                                 size_t size, Error **errp)
+{
+    return 0;
+}
+#endif
+
 static bool read_ramblock_mapped_ram(QEMUFile *f, RAMBlock *block,
                                      long num_pages, unsigned long *bitmap,
                                      Error **errp)
@@ -4088,6 +4505,7 @@ static bool read_ramblock_mapped_ram(QEMUFile *f, RAMBlock *block,
     ram_addr_t offset;
     void *host;
     size_t read, unread, size;
+    int fd = mapped_ram_mmap_fd(f, block);
 
     for (set_bit_idx = find_first_bit(bitmap, num_pages);
          set_bit_idx < num_pages;
@@ -4104,6 +4522,16 @@ static bool read_ramblock_mapped_ram(QEMUFile *f, RAMBlock *block,
         unread = TARGET_PAGE_SIZE * (clear_bit_idx - set_bit_idx);
         offset = set_bit_idx << TARGET_PAGE_BITS;
 
+        if (fd >= 0) {
+            int ret = mapped_ram_mmap_pages(fd, block, offset, unread, errp);
+
+            if (ret < 0) {
+                return false;
+            } else if (ret) {
+                continue;
+            }
+        }
+
         while (unread > 0) {
             host = host_from_ram_block_offset(block, offset);
             if (!host) {
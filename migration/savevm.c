@@ -1687,8 +1687,8 @@ int qemu_savevm_state_complete_precopy_iterable(QEMUFile *f, bool in_postcopy)
         }
         end_ts_each = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
 
-        trace_vmstate_downtime_save("iterable", se->idstr, se->instance_id,
-                                    end_ts_each - start_ts_each);
+        migration_downtime_section(false, true, se->idstr, se->instance_id,
+                                   end_ts_each - start_ts_each);
     }
 
     if (multifd_device_state) {
@@ -1702,7 +1702,7 @@ int qemu_savevm_state_complete_precopy_iterable(QEMUFile *f, bool in_postcopy)
         }
     }
 
-    trace_vmstate_downtime_checkpoint("src-iterable-saved");
+    migration_downtime_checkpoint(false, "src-iterable-saved");
 
     return 0;
 
@@ -1760,11 +1760,11 @@ bool qemu_savevm_state_non_iterable(QEMUFile *f, Error **errp)
         }
 
         end_ts_each = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
-        trace_vmstate_downtime_save("non-iterable", se->idstr, se->instance_id,
-                                    end_ts_each - start_ts_each);
+        migration_downtime_section(false, false, se->idstr, se->instance_id,
+                                   end_ts_each - start_ts_each);
     }
 
-    trace_vmstate_downtime_checkpoint("src-non-iterable-saved");
+    migration_downtime_checkpoint(false, "src-non-iterable-saved");
 
     return true;
 }
@@ -1794,6 +1794,7 @@ bool qemu_savevm_state_complete_precopy(MigrationState *s, Error **errp)
         error_prepend(errp, "Failed to flush QEMUFile: ");
         return false;
     }
+    migration_downtime_checkpoint(false, "src-flushed");
 
     return true;
 }
@@ -2207,18 +2208,18 @@ static void loadvm_postcopy_handle_run_bh(void *opaque)
 {
     MigrationIncomingState *mis = opaque;
 
-    trace_vmstate_downtime_checkpoint("dst-postcopy-bh-enter");
+    migration_downtime_checkpoint(true, "dst-postcopy-bh-enter");
 
     /* TODO we should move all of this lot into postcopy_ram.c or a shared code
      * in migration.c
      */
     cpu_synchronize_all_post_init();
 
-    trace_vmstate_downtime_checkpoint("dst-postcopy-bh-cpu-synced");
+    migration_downtime_checkpoint(true, "dst-postcopy-bh-cpu-synced");
 
     qemu_announce_self(&mis->announce_timer, migrate_announce_params());
 
-    trace_vmstate_downtime_checkpoint("dst-postcopy-bh-announced");
+    migration_downtime_checkpoint(true, "dst-postcopy-bh-announced");
 
     dirty_bitmap_mig_before_vm_start();
 
@@ -2229,7 +2230,8 @@ static void loadvm_postcopy_handle_run_bh(void *opaque)
          */
         bool success = migration_block_activate(NULL);
 
-        trace_vmstate_downtime_checkpoint("dst-postcopy-bh-cache-invalidated");
+        migration_downtime_checkpoint(true,
+                                      "dst-postcopy-bh-cache-invalidated");
 
         if (success) {
             vm_start();
@@ -2239,7 +2241,7 @@ static void loadvm_postcopy_handle_run_bh(void *opaque)
         runstate_set(RUN_STATE_PAUSED);
     }
 
-    trace_vmstate_downtime_checkpoint("dst-postcopy-bh-vm-started");
+    migration_downtime_checkpoint(true, "dst-postcopy-bh-vm-started");
 }
 
 /* After all discards we can start running and asking for pages */
@@ -2739,8 +2741,8 @@ qemu_loadvm_section_start_full(QEMUFile *f, uint8_t type, Error **errp)
 
     if (trace_downtime) {
         end_ts = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
-        trace_vmstate_downtime_load("non-iterable", se->idstr,
-                                    se->instance_id, end_ts - start_ts);
+        migration_downtime_section(true, false, se->idstr,
+                                   se->instance_id, end_ts - start_ts);
     }
 
     if (!check_section_footer(f, se)) {
@@ -2791,8 +2793,8 @@ qemu_loadvm_section_part_end(QEMUFile *f, uint8_t type, Error **errp)
 
     if (trace_downtime) {
         end_ts = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
-        trace_vmstate_downtime_load("iterable", se->idstr,
-                                    se->instance_id, end_ts - start_ts);
+        migration_downtime_section(true, true, se->idstr,
+                                   se->instance_id, end_ts - start_ts);
     }
 
     if (!check_section_footer(f, se)) {
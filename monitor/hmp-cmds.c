@@ -144,14 +144,26 @@ void hmp_stop(Monitor *mon, const QDict *qdict)
 void hmp_sync_profile(Monitor *mon, const QDict *qdict)
 {
     const char *op = qdict_get_try_str(qdict, "op");
+    int64_t period = qdict_get_try_int(qdict, "period", 1);
 
     if (op == NULL) {
         bool on = qsp_is_enabled();
 
-        monitor_printf(mon, "sync-profile is %s\n", on ? "on" : "off");
+        monitor_printf(mon, "sync-profile is %s", on ? "on" : "off");
+        if (on && qsp_get_sample_period() > 1) {
+            monitor_printf(mon, ", sampling 1 in %u operations",
+                           qsp_get_sample_period());
+        }
+        monitor_printf(mon, "\n");
         return;
     }
     if (!strcmp(op, "on")) {
+        if (period < 1 || period > UINT_MAX) {
+            monitor_printf(mon, "invalid sampling period %" PRId64 "\n",
+                           period);
+            return;
+        }
+        qsp_set_sample_period(period);
         qsp_enable();
     } else if (!strcmp(op, "off")) {
         qsp_disable();
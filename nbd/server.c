@@ -101,6 +101,11 @@ struct NBDExport {
     bool allocation_depth;
     BdrvDirtyBitmap **export_bitmaps;
     size_t nr_export_bitmaps;
+
+    /* IOThreads that clients are spread across, if multi-threaded */
+    AioContext **multithread_ctxs;
+    size_t multithread_count;
+    size_t next_ctx; /* round-robin index, main loop only */
 };
 
 static QTAILQ_HEAD(, NBDExport) exports = QTAILQ_HEAD_INITIALIZER(exports);
@@ -129,6 +134,7 @@ struct NBDClient {
     QemuMutex lock;
 
     NBDExport *exp;
+    AioContext *ctx; /* where requests run, NULL to follow the export */
     QCryptoTLSCreds *tlscreds;
     char *tlsauthz;
     uint32_t handshake_max_secs;
@@ -159,6 +165,24 @@ struct NBDClient {
 
 static void nbd_client_receive_next_request(NBDClient *client);
 
+static AioContext *nbd_client_aio_context(NBDClient *client)
+{
+    return client->ctx ?: nbd_export_aio_context(client->exp);
+}
+
+/* Add @client to the clients of @client->exp */
+static void nbd_client_attach_export(NBDClient *client)
+{
+    NBDExport *exp = client->exp;
+
+    if (exp->multithread_count) {
+        client->ctx = exp->multithread_ctxs[exp->next_ctx++ %
+                                            exp->multithread_count];
+    }
+    QTAILQ_INSERT_TAIL(&exp->clients, client, next);
+    blk_exp_ref(&exp->common);
+}
+
 /* Basic flow for negotiation
 
    Server         Client
@@ -536,8 +560,7 @@ nbd_negotiate_handle_export_name(NBDClient *client, bool no_zeroes,
         return ret;
     }
 
-    QTAILQ_INSERT_TAIL(&client->exp->clients, client, next);
-    blk_exp_ref(&client->exp->common);
+    nbd_client_attach_export(client);
 
     return 0;
 }
@@ -752,8 +775,7 @@ nbd_negotiate_handle_info(NBDClient *client, Error **errp)
     if (client->opt == NBD_OPT_GO) {
         client->exp = exp;
         client->check_align = check_align;
-        QTAILQ_INSERT_TAIL(&client->exp->clients, client, next);
-        blk_exp_ref(&client->exp->common);
+        nbd_client_attach_export(client);
         rc = 1;
     }
     return rc;
@@ -1729,7 +1751,7 @@ static void nbd_drained_end(void *opaque)
     }
 }
 
-/* Runs in export AioContext */
+/* Runs in the client's AioContext */
 static void nbd_wake_read_bh(void *opaque)
 {
     NBDClient *client = opaque;
@@ -1755,7 +1777,7 @@ static bool nbd_drained_poll(void *opaque)
                  * qio_channel_yield().
                  */
                 if (client->recv_coroutine != NULL && client->read_yielding) {
-                    aio_bh_schedule_oneshot(nbd_export_aio_context(client->exp),
+                    aio_bh_schedule_oneshot(nbd_client_aio_context(client),
                                             nbd_wake_read_bh, client);
                 }
 
@@ -1832,11 +1854,6 @@ static int nbd_export_create(BlockExport *blk_exp, BlockExportOptions *exp_args,
         return -EEXIST;
     }
 
-    if (multithread) {
-        error_setg(errp, "NBD export does not support multi-threading");
-        return -EINVAL;
-    }
-
     size = blk_getlength(blk);
     if (size < 0) {
         error_setg_errno(errp, -size,
@@ -1951,6 +1968,16 @@ static int nbd_export_create(BlockExport *blk_exp, BlockExportOptions *exp_args,
 
     blk_set_dev_ops(blk, &nbd_block_ops, exp);
 
+    /*
+     * Each client connection is handled in one of the given IOThreads,
+     * which lets NBD_FLAG_CAN_MULTI_CONN clients spread over several cores.
+     */
+    if (multithread) {
+        exp->multithread_ctxs = g_memdup2(multithread,
+                                          mt_count * sizeof(AioContext *));
+        exp->multithread_count = mt_count;
+    }
+
     QTAILQ_INSERT_TAIL(&exports, exp, next);
 
     bdrv_graph_rdunlock_main_loop();
@@ -2029,6 +2056,8 @@ static void nbd_export_delete(BlockExport *blk_exp)
     for (i = 0; i < exp->nr_export_bitmaps; i++) {
         bdrv_dirty_bitmap_set_busy(exp->export_bitmaps[i], false);
     }
+
+    g_free(exp->multithread_ctxs);
 }
 
 const BlockExportDriver blk_exp_nbd = {
@@ -3215,7 +3244,7 @@ static void nbd_client_receive_next_request(NBDClient *client)
         nbd_client_get(client);
         req = nbd_request_get(client);
         client->recv_coroutine = qemu_coroutine_create(nbd_trip, req);
-        aio_co_schedule(client->exp->common.ctx, client->recv_coroutine);
+        aio_co_schedule(nbd_client_aio_context(client), client->recv_coroutine);
     }
 }
 
@@ -21,22 +21,36 @@
 
 uint32_t net_checksum_add_cont(int len, uint8_t *buf, int seq)
 {
+    uint64_t sum = 0;
     uint32_t sum1 = 0, sum2 = 0;
-    int i;
+    int i = 0;
 
-    for (i = 0; i < len - 1; i += 2) {
+    /*
+     * Add 8 bytes at a time as two big-endian 32-bit words.  Because
+     * 2^16 == 1 (mod 0xffff), the folded result is the same one's
+     * complement sum as adding 16-bit words.
+     */
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w = ldq_be_p(buf + i);
+
+        sum += (w >> 32) + (uint32_t)w;
+    }
+
+    for (; i < len - 1; i += 2) {
         sum1 += (uint32_t)buf[i];
         sum2 += (uint32_t)buf[i + 1];
     }
     if (i < len) {
         sum1 += (uint32_t)buf[i];
     }
+    sum += sum2 + ((uint64_t)sum1 << 8);
 
-    if (seq & 1) {
-        return sum1 + (sum2 << 8);
-    } else {
-        return sum2 + (sum1 << 8);
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
     }
+
+    /* An odd @seq puts this buffer's bytes in the other half of the words */
+    return (seq & 1) ? bswap16(sum) : sum;
 }
 
 uint16_t net_checksum_finish(uint32_t sum)
@@ -135,6 +135,11 @@ struct CompareState {
 
     QEMUBH *event_bh;
     enum colo_event event;
+    /*
+     * A checkpoint was requested and has not flushed the queues yet.
+     * Only accessed from the compare thread.
+     */
+    bool checkpoint_pending;
 
     QTAILQ_ENTRY(CompareState) next;
 };
@@ -184,6 +189,15 @@ static void notify_remote_frame(CompareState *s)
 
 static void colo_compare_inconsistency_notify(CompareState *s)
 {
+    /*
+     * Every packet still queued is flushed by the checkpoint, so any
+     * further mismatch until then is covered by the pending request.
+     */
+    if (s->checkpoint_pending) {
+        return;
+    }
+    s->checkpoint_pending = true;
+
     if (s->notify_dev) {
         notify_remote_frame(s);
     } else {
@@ -948,6 +962,7 @@ static void colo_compare_handle_event(void *opaque)
     switch (s->event) {
     case COLO_EVENT_CHECKPOINT:
         g_queue_foreach(&s->conn_list, colo_flush_packets, s);
+        s->checkpoint_pending = false;
         break;
     case COLO_EVENT_FAILOVER:
         break;
@@ -1193,6 +1208,7 @@ static void compare_notify_rs_finalize(SocketReadState *notify_rs)
                                   notify_rs->packet_len)) {
         /* colo-compare do checkpoint, flush pri packet and remove sec packet */
         g_queue_foreach(&s->conn_list, colo_flush_packets, s);
+        s->checkpoint_pending = false;
     } else {
         error_report("COLO compare got unsupported instruction");
     }
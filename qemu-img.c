@@ -88,6 +88,7 @@ enum {
     OPTION_SKIP_BROKEN = 277,
     OPTION_LIMITS = 278,
     OPTION_REMOVE_ALL = 279,
+    OPTION_RANDOM = 280,
 };
 
 typedef enum OutputFormat {
@@ -1168,6 +1169,14 @@ static int is_allocated_sectors(const uint8_t *buf, int n, int *pnum,
         return 0;
     }
     is_zero = buffer_is_zero(buf, BDRV_SECTOR_SIZE);
+    if (is_zero && buffer_is_zero(buf, (int64_t)n * BDRV_SECTOR_SIZE)) {
+        /*
+         * Fully zero buffers are common when converting sparse images;
+         * one call lets buffer_is_zero() use its vector loop on all of it.
+         */
+        *pnum = n;
+        return 0;
+    }
     for(i = 1; i < n; i++) {
         buf += BDRV_SECTOR_SIZE;
         if (is_zero != buffer_is_zero(buf, BDRV_SECTOR_SIZE)) {
@@ -4649,6 +4658,7 @@ typedef struct BenchData {
     int n;
     int flush_interval;
     bool drain_on_flush;
+    bool random;
     uint8_t *buf;
     QEMUIOVector *qiov;
 
@@ -4716,10 +4726,15 @@ static void bench_cb(void *opaque, int ret)
          * and b->offset is ready for the next submission.
          */
         b->in_flight++;
-        b->offset += b->step;
         if (b->image_size <= b->bufsize) {
             b->offset = 0;
+        } else if (b->random) {
+            uint64_t slots = (b->image_size - b->bufsize) / b->step + 1;
+            uint64_t r = (uint64_t)g_random_int() << 32 | g_random_int();
+
+            b->offset = r % slots * b->step;
         } else {
+            b->offset += b->step;
             b->offset %= b->image_size - b->bufsize;
         }
         if (b->write) {
@@ -4749,6 +4764,7 @@ static int img_bench(const img_cmd_t *ccmd, int argc, char **argv)
     ssize_t step = 0;
     int flush_interval = 0;
     bool drain_on_flush = true;
+    bool random = false;
     int64_t image_size;
     BlockBackend *blk = NULL;
     BenchData data = {};
@@ -4774,6 +4790,7 @@ static int img_bench(const img_cmd_t *ccmd, int argc, char **argv)
             {"pattern", required_argument, 0, OPTION_PATTERN},
             {"flush-interval", required_argument, 0, OPTION_FLUSH_INTERVAL},
             {"no-drain", no_argument, 0, OPTION_NO_DRAIN},
+            {"random", no_argument, 0, OPTION_RANDOM},
             {"aio", required_argument, 0, 'i'},
             {"native", no_argument, 0, 'n'},
             {"force-share", no_argument, 0, 'U'},
@@ -4791,6 +4808,7 @@ static int img_bench(const img_cmd_t *ccmd, int argc, char **argv)
         case 'h':
             cmd_help(ccmd, "[-f FMT | --image-opts] [-t CACHE]\n"
 "        [-c COUNT] [-d DEPTH] [-o OFFSET] [-s BUFFER_SIZE] [-S STEP_SIZE]\n"
+"        [--random]\n"
 "        [-w [--pattern PATTERN] [--flush-interval INTERVAL [--no-drain]]]\n"
 "        [-i AIO] [-n] [-U] [-q] FILE\n"
 ,
@@ -4813,6 +4831,8 @@ static int img_bench(const img_cmd_t *ccmd, int argc, char **argv)
 "  -S, --step-size STEP_SIZE[bkKMGTPE]\n"
 "     each next request offset increment, with optional multiplier suffix\n"
 "     (powers of 1024, default is the same as BUFFER_SIZE)\n"
+"  --random\n"
+"     pick each request offset at random, aligned to STEP_SIZE\n"
 "  -w, --write\n"
 "     perform write test (default is read)\n"
 "  --pattern PATTERN\n"
@@ -4911,6 +4931,9 @@ static int img_bench(const img_cmd_t *ccmd, int argc, char **argv)
         case OPTION_NO_DRAIN:
             drain_on_flush = false;
             break;
+        case OPTION_RANDOM:
+            random = true;
+            break;
         case 'U':
             force_share = true;
             break;
@@ -4965,11 +4988,19 @@ static int img_bench(const img_cmd_t *ccmd, int argc, char **argv)
         .write          = is_write,
         .flush_interval = flush_interval,
         .drain_on_flush = drain_on_flush,
+        .random         = random,
     };
-    printf("Sending %d %s requests, %d bytes each, %d in parallel "
-           "(starting at offset %" PRId64 ", step size %d)\n",
-           data.n, data.write ? "write" : "read", data.bufsize, data.nrreq,
-           data.offset, data.step);
+    if (data.random) {
+        printf("Sending %d random %s requests, %d bytes each, %d in parallel "
+               "(aligned to %d bytes)\n",
+               data.n, data.write ? "write" : "read", data.bufsize, data.nrreq,
+               data.step);
+    } else {
+        printf("Sending %d %s requests, %d bytes each, %d in parallel "
+               "(starting at offset %" PRId64 ", step size %d)\n",
+               data.n, data.write ? "write" : "read", data.bufsize,
+               data.nrreq, data.offset, data.step);
+    }
     if (flush_interval) {
         printf("Sending flush every %d requests\n", flush_interval);
     }
@@ -240,10 +240,18 @@ DEF("accel", HAS_ARG, QEMU_OPTION_accel,
     "                one-insn-per-tb=on|off (one guest instruction per TCG translation block)\n"
     "                split-wx=on|off (enable TCG split w^x mapping)\n"
     "                tb-size=n (TCG translation block cache size)\n"
+    "                tb-evict=on|off (reclaim the oldest TCG code region when the cache is full)\n"
+    "                tb-numa-local=on|off (place reused TCG code regions on the local NUMA node)\n"
+    "                tlb-victim-size=n (entries in each TCG victim TLB, default 8)\n"
     "                dirty-ring-size=n (KVM dirty ring GFN count, default 0)\n"
     "                eager-split-size=n (KVM Eager Page Split chunk size, default 0, disabled. ARM only)\n"
     "                notify-vmexit=run|internal-error|disable,notify-window=n (enable notify VM exit and set notify window, x86 only)\n"
     "                thread=single|multi (enable multi-threaded TCG)\n"
+    "                vcpu-pin=on|off (pin each TCG vCPU thread to one host CPU)\n"
+    "                profile-hz=n (sample executing TBs n times per second)\n"
+    "                working-set-interval=n (estimate the guest working set every n ms)\n"
+    "                atomic-htm=on|off (use host transactional memory for atomics)\n"
+    "                icount-quantum=n (run MTTCG vCPUs in lockstep quanta with -icount)\n"
     "                device=path (KVM device path, default /dev/kvm)\n", QEMU_ARCH_ALL)
 SRST
 ``-accel name[,prop=value[,...]]``
@@ -283,6 +291,32 @@ SRST
     ``tb-size=n``
         Controls the size (in MiB) of the TCG translation block cache.
 
+    ``tb-evict=on|off``
+        When the TCG translation block cache is full, invalidate only the
+        translation blocks of the least recently allocated region of the
+        cache, instead of flushing all of them. This avoids retranslating
+        hot code after each flush in guests with a large code footprint.
+        It has no effect unless the cache is split into several regions,
+        i.e. with multi-threaded TCG. Defaults to off.
+
+    ``tb-numa-local=on|off``
+        Release the host memory of the TCG translation block cache when
+        it is flushed, or when one of its regions is reclaimed (see
+        ``tb-evict``). The memory is then allocated again by the vCPU
+        thread that next translates code into it, which places it on the
+        NUMA node that thread runs on instead of the node of its previous
+        user. The cache is always backed by transparent huge pages where
+        the host supports them. Defaults to off.
+
+    ``tlb-victim-size=n``
+        Sets the number of entries in the fully associative victim TLB
+        that backs each direct-mapped TCG soft TLB. Entries evicted from
+        the main TLB by a conflicting page are kept here, and checked
+        before the slow path walks the guest page tables again. Raising
+        this helps guests with a large working set whose hot pages
+        alias in the main TLB. Must be a power of 2 between 8 and 256.
+        Defaults to 8.
+
     ``thread=single|multi``
         Controls number of TCG threads. When the TCG is multi-threaded
         there will be one thread per vCPU therefore taking advantage of
@@ -291,6 +325,51 @@ SRST
         incompatible TCG features have been enabled (e.g.
         icount/replay).
 
+    ``vcpu-pin=on|off``
+        With multi-threaded TCG, pin each vCPU thread to a single host
+        CPU, assigned round-robin by vCPU index among the host CPUs that
+        QEMU is allowed to run on. This avoids migrating vCPU threads
+        and their translation caches between host cores. If there are
+        more vCPUs than host CPUs, several vCPUs share each host CPU.
+        Defaults to off.
+
+    ``profile-hz=n``
+        Sample the translation block each running vCPU is executing n
+        times per second (at most 10000) and collect a per-TB histogram,
+        which can be viewed with ``info tb-profile``. The samples are
+        taken by forcing an exit from the current TB, so no code is added
+        to the translated blocks. Not available in record/replay mode.
+        Defaults to 0, which disables profiling.
+
+    ``working-set-interval=n``
+        Estimate which guest RAM pages the vCPUs touch in each window
+        of n milliseconds (at least 100). Pages are recorded when they
+        are added to the softmmu TLB, and all TLBs are flushed at the
+        start of each window. The per-RAMBlock result of the last
+        window can be queried with the ``x-query-working-set`` QMP
+        command. Accesses by DMA are not accounted. Defaults to 0,
+        which disables the estimation.
+
+    ``atomic-htm=on|off``
+        When a guest atomic operation cannot be implemented with host
+        atomic instructions, TCG normally stops all other vCPUs while
+        it emulates that one instruction. With this option, it first
+        tries to execute the instruction inside a host hardware memory
+        transaction (Intel RTM), which is atomic with respect to the
+        other vCPUs without stopping them, and only stops them if the
+        transaction keeps aborting. It has no effect on hosts without
+        transactional memory. Defaults to off.
+
+    ``icount-quantum=n``
+        Allow ``-icount`` together with ``thread=multi``: every vCPU runs
+        in its own thread, and they all execute in lockstep quanta of at
+        most n instructions each. Virtual time, timer interrupts and
+        interrupts between vCPUs only advance at quantum boundaries, so
+        they do not depend on host scheduling. Concurrent guest accesses
+        to shared memory within a quantum are still not deterministic,
+        and record/replay is not supported in this mode. Defaults to 0,
+        which keeps icount single-threaded.
+
     ``dirty-ring-size=n``
         When the KVM accelerator is used, it controls the size of the per-vCPU
         dirty page ring buffer (number of entries for each vCPU). It should
@@ -5744,6 +5823,20 @@ SRST
     Generate a dump file for Linux perf tools that maps basic blocks to symbol
     names, line numbers and JITted code.
 ERST
+
+DEF("jitdump-socket", HAS_ARG, QEMU_OPTION_jitdump_socket,
+    "-jitdump-socket path\n"
+    "                stream jitdump records to a Unix socket\n",
+    QEMU_ARCH_ALL)
+SRST
+``-jitdump-socket path``
+    Like ``-jitdump``, but stream the records to the Unix socket at
+    ``path`` instead of writing a file, so that an external profiler can
+    ingest them continuously. The stream starts with the jitdump header.
+    Records are written by a separate thread; if the reader falls behind,
+    records are dropped rather than slowing down translation. It cannot be
+    combined with ``-jitdump``.
+ERST
 #endif
 
 DEFHEADING()
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+
+#  Measure TCG execution throughput of guest programs under qemu-user.
+#  Syntax:
+#  tcg_bench.py [-h] [-r RUNS] [-j FILE] -p <libinsn.so> -- \
+#           <qemu executable> [<qemu executable options>] \
+#           <target executable> [<target executable options>]
+#
+#  [-h] - Print the script arguments help message.
+#  [-r] - Number of timed runs, the best one is reported (default 5).
+#  [-j] - Also write the results as JSON to FILE.
+#  [-p] - Path to the insn plugin built in tests/tcg/plugins.
+#
+#  The program is run once with the insn plugin to count the executed
+#  guest instructions, then RUNS times without it, once with TB chaining
+#  and once with "-d nochain".  The report shows the guest MIPS of both
+#  and how much chaining saves, which together with the total time of a
+#  short program gives an idea of translation overhead.
+#
+#  Example of usage:
+#  tcg_bench.py -p build/tests/tcg/plugins/libinsn.so -- \
+#           qemu-aarch64 build/tests/tcg/aarch64-linux-user/sha512
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def run(command):
+    start = time.perf_counter()
+    p = subprocess.run(command, stdout=subprocess.DEVNULL,
+                       stderr=subprocess.DEVNULL)
+    elapsed = time.perf_counter() - start
+    if p.returncode:
+        sys.exit(f"'{' '.join(command)}' failed with {p.returncode}")
+    return elapsed
+
+
+def count_insns(qemu, plugin, target):
+    with tempfile.TemporaryDirectory() as tmp:
+        log = os.path.join(tmp, 'insn.log')
+        run([qemu, '-plugin', f'{plugin},inline=on', '-d', 'plugin',
+             '-D', log] + target)
+        with open(log, 'r') as f:
+            m = re.search(r'total insns: (\d+)', f.read())
+    if not m:
+        sys.exit('Could not read the instruction count from the insn plugin')
+    return int(m.group(1))
+
+
+def best_time(command, runs):
+    return min(run(command) for _ in range(runs))
+
+
+# Parse the command line arguments
+parser = argparse.ArgumentParser(
+    usage='tcg_bench.py [-h] [-r RUNS] [-j FILE] -p <libinsn.so> -- '
+          '<qemu executable> [<qemu executable options>] '
+          '<target executable> [<target executable options>]')
+
+parser.add_argument('-r', dest='runs', type=int, default=5,
+                    help='Number of timed runs, the best one is reported.')
+parser.add_argument('-j', dest='json', type=str,
+                    help='Also write the results as JSON to this file.')
+parser.add_argument('-p', dest='plugin', type=str, required=True,
+                    help='Path to the insn plugin.')
+
+parser.add_argument('command', type=str, nargs='+', help=argparse.SUPPRESS)
+
+args = parser.parse_args()
+
+# Extract the needed variables from the args
+qemu = args.command[0]
+target = args.command[1:]
+
+insns = count_insns(qemu, args.plugin, target)
+chained = best_time([qemu] + target, args.runs)
+nochain = best_time([qemu, '-d', 'nochain'] + target, args.runs)
+
+results = {
+    'command': args.command,
+    'insns': insns,
+    'seconds': chained,
+    'mips': insns / chained / 1e6,
+    'nochain-seconds': nochain,
+    'nochain-mips': insns / nochain / 1e6,
+}
+
+print(f"{'Guest instructions:':<24}{insns:>16}")
+print(f"{'Time:':<24}{chained:>15.3f}s")
+print(f"{'MIPS:':<24}{results['mips']:>16.1f}")
+print(f"{'Time without chaining:':<24}{nochain:>15.3f}s")
+print(f"{'MIPS without chaining:':<24}{results['nochain-mips']:>16.1f}")
+print(f"{'Saved by chaining:':<24}"
+      f"{(nochain - chained) / nochain * 100:>15.1f}%")
+
+if args.json:
+    with open(args.json, 'w') as f:
+        json.dump(results, f, indent=4)
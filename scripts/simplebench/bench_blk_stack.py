@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+#
+# Benchmark the block layer I/O path of several qemu-img binaries
+#
+# Each case runs "qemu-img bench" on one block stack: the null-co and
+# null-aio drivers isolate the overhead of QEMU itself, the file cases
+# add the raw and qcow2 formats and the threads, native and io_uring
+# AIO engines.  The first binary is the baseline, the table shows the
+# difference of the others to it.  Results, including CPU time per
+# request, are also written as JSON for later comparison.
+#
+# Random offsets need "qemu-img bench --random"; use --sequential to
+# compare against binaries that predate it.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+
+import argparse
+import json
+import os
+import re
+import resource
+import subprocess
+
+import simplebench
+from results_to_text import results_to_text
+
+
+IMAGE_SIZE = '1G'
+
+
+def children_cpu_time():
+    ru = resource.getrusage(resource.RUSAGE_CHILDREN)
+    return ru.ru_utime + ru.ru_stime
+
+
+def qemu_img_bench(args, count):
+    cpu = children_cpu_time()
+    p = subprocess.run(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                       universal_newlines=True)
+    cpu = children_cpu_time() - cpu
+
+    if p.returncode != 0:
+        return {'error': f'qemu-img failed: {p.returncode}: {p.stdout}'}
+
+    m = re.search(r'Run completed in (\d+\.\d+) seconds\.', p.stdout)
+    if not m:
+        return {'error': f'failed to parse qemu-img output: {p.stdout}'}
+
+    seconds = float(m.group(1))
+    return {'iops': count / seconds, 'seconds': seconds,
+            'cpu-usec-per-io': cpu * 1000000 / count}
+
+
+def create_image(qemu_img, fmt, fname):
+    subprocess.run([qemu_img, 'create', '-f', fmt, '-o',
+                    'preallocation=falloc', fname, IMAGE_SIZE],
+                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                   check=True)
+
+
+def supports_random(qemu_img):
+    p = subprocess.run([qemu_img, 'bench', '--help'], stdout=subprocess.PIPE,
+                       stderr=subprocess.STDOUT, universal_newlines=True)
+    return '--random' in p.stdout
+
+
+def bench_func(env, case):
+    qemu_img = env['qemu-img']
+    args = [qemu_img, 'bench', '-c', str(case['count']), '-d',
+            str(case['depth']), '-s', case['block-size']]
+    if case['random']:
+        if not env['random']:
+            return {'error': f'{qemu_img} has no bench --random, '
+                             'try --sequential'}
+        args.append('--random')
+    if case['write']:
+        args.append('-w')
+
+    if case['driver'] in ('null-co', 'null-aio'):
+        return qemu_img_bench(args + ['--image-opts',
+                                      f"driver={case['driver']},"
+                                      f'size={IMAGE_SIZE}'],
+                              case['count'])
+
+    fname = os.path.join(env['dir'], f"bench-blk-stack.{case['driver']}")
+    try:
+        create_image(qemu_img, case['driver'], fname)
+        args += ['-f', case['driver'], '-t', 'none', '-i', case['aio'],
+                 fname]
+        return qemu_img_bench(args, case['count'])
+    except subprocess.CalledProcessError as e:
+        return {'error': f'qemu-img create failed: {e}'}
+    finally:
+        if os.path.exists(fname):
+            os.remove(fname)
+
+
+def make_cases(count, file_count, random):
+    cases = []
+    stacks = [('null-co', None, count), ('null-aio', None, count)]
+    for aio in ('threads', 'native', 'io_uring'):
+        stacks.append(('raw', aio, file_count))
+    stacks.append(('qcow2', 'threads', file_count))
+
+    for driver, aio, n in stacks:
+        for write in (False, True):
+            name = driver if aio is None else f'{driver}, aio={aio}'
+            op = ('rand' if random else '') + ('write' if write else 'read')
+            cases.append({
+                'id': f'{name}, 4k {op} qd32',
+                'driver': driver,
+                'aio': aio,
+                'block-size': '4k',
+                'depth': 32,
+                'random': random,
+                'write': write,
+                'count': n,
+            })
+    return cases
+
+
+if __name__ == '__main__':
+    p = argparse.ArgumentParser(
+        description='Compare block layer IOPS and CPU cost per request of '
+                    'several qemu-img binaries.  The first binary is the '
+                    'baseline.')
+    p.add_argument('--dir', default='.',
+                   help='directory for the image files, put it on the '
+                        'storage to measure (default: current directory)')
+    p.add_argument('--count', type=int, default=1000000,
+                   help='requests per null driver run (default: %(default)s)')
+    p.add_argument('--file-count', type=int, default=100000,
+                   help='requests per file run (default: %(default)s)')
+    p.add_argument('--runs', type=int, default=3,
+                   help='runs per cell (default: %(default)s)')
+    p.add_argument('--sequential', action='store_true',
+                   help='use sequential instead of random offsets')
+    p.add_argument('--json', default='results.json',
+                   help='file to write results to (default: %(default)s)')
+    p.add_argument('qemu_img', nargs='+', metavar='QEMU_IMG',
+                   help='qemu-img binaries to compare')
+    args = p.parse_args()
+
+    envs = [{'id': path, 'qemu-img': path, 'dir': args.dir,
+             'random': not args.sequential and supports_random(path)}
+            for path in args.qemu_img]
+
+    result = simplebench.bench(bench_func, envs,
+                               make_cases(args.count, args.file_count,
+                                          not args.sequential),
+                               count=args.runs, initial_run=False)
+    print(results_to_text(result))
+    with open(args.json, 'w') as f:
+        json.dump(result, f, indent=4)
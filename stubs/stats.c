@@ -0,0 +1,8 @@
+#include "qemu/osdep.h"
+#include "system/stats.h"
+
+void add_stats_callbacks(StatsProvider provider,
+                         StatRetrieveFunc *stats_fn,
+                         SchemaRetrieveFunc *schemas_fn)
+{
+}
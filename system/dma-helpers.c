@@ -15,6 +15,7 @@
 #include "qemu/main-loop.h"
 #include "exec/icount.h"
 #include "qemu/range.h"
+#include "qemu/rcu.h"
 
 /* #define DEBUG_IOMMU */
 
@@ -89,6 +90,8 @@ static void dma_blk_unmap(DMAAIOCB *dbs)
 {
     int i;
 
+    /* One RCU critical section for the whole list, not one per entry. */
+    RCU_READ_LOCK_GUARD();
     for (i = 0; i < dbs->iov.niov; ++i) {
         dma_memory_unmap(dbs->sg->as, dbs->iov.iov[i].iov_base,
                          dbs->iov.iov[i].iov_len, dbs->dir,
@@ -131,6 +134,11 @@ static void dma_blk_cb(void *opaque, int ret)
     }
     dma_blk_unmap(dbs);
 
+    /*
+     * Map as much of the list as possible within a single RCU critical
+     * section, so that the nested ones in address_space_map() are cheap.
+     */
+    rcu_read_lock();
     while (dbs->sg_cur_index < dbs->sg->nsg) {
         cur_addr = dbs->sg->sg[dbs->sg_cur_index].base + dbs->sg_cur_byte;
         cur_len = dbs->sg->sg[dbs->sg_cur_index].len - dbs->sg_cur_byte;
@@ -165,6 +173,7 @@ static void dma_blk_cb(void *opaque, int ret)
             ++dbs->sg_cur_index;
         }
     }
+    rcu_read_unlock();
 
     if (dbs->iov.size == 0) {
         trace_dma_map_wait(dbs);
@@ -564,20 +564,55 @@ iotlb_fail:
     return (IOMMUTLBEntry) {0};
 }
 
+/*
+ * Per-thread cache of the last MMIO section found by flatview_translate().
+ * Device emulation is dominated by repeated accesses to a few registers
+ * (doorbells, interrupt acknowledge), and this lets each vCPU skip the
+ * radix tree walk without bouncing the shared mru_section of the
+ * dispatch.  An entry is only used with the FlatView it was filled from,
+ * which keeps the MemoryRegion alive; FlatView generations are unique.
+ */
+typedef struct MMIOTranslateCache {
+    uint64_t fv_gen;
+    hwaddr start;
+    hwaddr last;
+    hwaddr offset_within_region;
+    MemoryRegion *mr;
+} MMIOTranslateCache;
+
+static __thread MMIOTranslateCache mmio_translate_cache;
+
 /* Called from RCU critical section */
 MemoryRegion *flatview_translate(FlatView *fv, hwaddr addr, hwaddr *xlat,
                                  hwaddr *plen, bool is_write,
                                  MemTxAttrs attrs)
 {
+    MMIOTranslateCache *c = &mmio_translate_cache;
     MemoryRegion *mr;
     MemoryRegionSection section;
     AddressSpace *as = NULL;
 
+    if (c->fv_gen == fv->gen && addr >= c->start && addr <= c->last) {
+        /* As below, the length of MMIO accesses is not clamped. */
+        *xlat = addr - c->start + c->offset_within_region;
+        return c->mr;
+    }
+
     /* This can be MMIO, so setup MMIO bit. */
     section = flatview_do_translate(fv, addr, xlat, plen, NULL,
                                     is_write, true, &as, attrs);
     mr = section.mr;
 
+    /* Only cache sections of this FlatView that are not RAM. */
+    if (!as && !memory_region_is_ram(mr) && mr != &io_mem_unassigned) {
+        c->fv_gen = fv->gen;
+        c->start = section.offset_within_address_space;
+        c->last = c->start +
+                  int128_get64(int128_sub(section.size, int128_one()));
+        c->offset_within_region = section.offset_within_region;
+        c->mr = mr;
+    }
+
     if (xen_map_cache_enabled() &&
         memory_access_is_direct(mr, is_write, attrs)) {
         /* mapcache: Next page may be unmapped or in a different bucket/VA. */
@@ -883,8 +918,8 @@ void physical_memory_dirty_bits_cleared(ram_addr_t start, ram_addr_t length)
     }
 }
 
-static bool physical_memory_get_dirty(ram_addr_t start, ram_addr_t length,
-                                      unsigned client)
+bool physical_memory_get_dirty(ram_addr_t start, ram_addr_t length,
+                               unsigned client)
 {
     DirtyMemoryBlocks *blocks;
     unsigned long end, page;
@@ -2632,6 +2667,52 @@ static int qemu_ram_remap_mmap(RAMBlock *block, uint64_t start, size_t length)
     return area != host_startaddr ? -errno : 0;
 }
 
+/* Redo the madvise() setup of ram_block_add() for remapped RAM */
+static void qemu_ram_setup_madvise(void *addr, size_t length)
+{
+    memory_try_enable_merging(addr, length);
+    qemu_ram_setup_dump(addr, length);
+    qemu_madvise(addr, length, QEMU_MADV_HUGEPAGE);
+    if (!qtest_enabled()) {
+        qemu_madvise(addr, length, QEMU_MADV_DONTFORK);
+    }
+}
+
+/*
+ * qemu_ram_map_file_cow - map RAM pages copy-on-write from a file
+ *
+ * @block: a private anonymous RAM block without backing file
+ * @offset: offset of the pages in @block
+ * @length: length of the pages
+ * @fd: file to map the pages from
+ * @fd_offset: offset of the pages in @fd
+ *
+ * Replace the pages with a private mapping of @fd, so that they are only
+ * read from the file when touched.  Discarding them later maps anonymous
+ * memory again, as MADV_DONTNEED would bring back the file contents.
+ * The caller has to make sure that no one relies on the old pages: they
+ * must neither be mlock()ed nor pinned.
+ *
+ * Returns 0 on success, -errno on failure, in which case the old pages
+ * may be gone already.
+ */
+int qemu_ram_map_file_cow(RAMBlock *block, ram_addr_t offset, size_t length,
+                          int fd, off_t fd_offset)
+{
+    void *host = ramblock_ptr(block, offset);
+    int prot = PROT_READ;
+
+    assert(block->fd < 0 && !qemu_ram_is_shared(block));
+    prot |= block->flags & RAM_READONLY ? 0 : PROT_WRITE;
+    if (mmap(host, length, prot, MAP_PRIVATE | MAP_FIXED, fd,
+             fd_offset) == MAP_FAILED) {
+        return -errno;
+    }
+    block->file_cow = true;
+    qemu_ram_setup_madvise(host, length);
+    return 0;
+}
+
 /*
  * qemu_ram_remap - remap a single RAM page
  *
@@ -4179,7 +4260,13 @@ int ram_block_discard_shared_range(RAMBlock *rb, uint64_t offset, size_t length)
              * fallocate'd away).
              */
 #if defined(CONFIG_MADVISE)
-            if (qemu_ram_is_shared(rb) && rb->fd < 0) {
+            if (rb->file_cow) {
+                /* MADV_DONTNEED would bring back the file's contents */
+                ret = qemu_ram_remap_mmap(rb, offset, length) ? -1 : 0;
+                if (ret == 0) {
+                    qemu_ram_setup_madvise(host_startaddr, length);
+                }
+            } else if (qemu_ram_is_shared(rb) && rb->fd < 0) {
                 ret = madvise(host_startaddr, length, QEMU_MADV_REMOVE);
             } else {
                 ret = madvise(host_startaddr, length, QEMU_MADV_DONTNEED);
@@ -45,6 +45,7 @@
 #include "hw/core/qdev-properties.h"
 #include "hw/core/clock.h"
 #include "hw/core/boards.h"
+#include "system/startup-timing.h"
 
 /*
  * Aliases were a bad idea from the start.  Let's keep them
@@ -659,6 +660,7 @@ DeviceState *qdev_device_add_from_qdict(const QDict *opts,
     DeviceState *dev;
     BusState *bus = NULL;
     QDict *properties;
+    int64_t t;
 
     driver = qdict_get_try_str(opts, "driver");
     if (!driver) {
@@ -737,9 +739,12 @@ DeviceState *qdev_device_add_from_qdict(const QDict *opts,
         goto err_del_dev;
     }
 
+    t = startup_timing_begin();
     if (!qdev_realize(dev, bus, errp)) {
         goto err_del_dev;
     }
+    startup_timing_end(STARTUP_EVENT_KIND_DEVICE,
+                       dev->id ?: object_get_typename(OBJECT(dev)), t);
     return dev;
 
 err_del_dev:
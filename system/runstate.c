@@ -61,6 +61,7 @@
 #include "system/confidential-guest-support.h"
 #include "system/system.h"
 #include "system/tpm.h"
+#include "tcg/perf.h"
 #include "ui/console.h"
 
 #include "trace.h"
@@ -1025,6 +1026,7 @@ void qemu_cleanup(int status)
     /* No more vcpu or device emulation activity beyond this point */
     vm_shutdown();
     replay_finish();
+    perf_exit();
 
     /*
      * We must cancel all block jobs while the block layer is drained,
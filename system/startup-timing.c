@@ -0,0 +1,151 @@
+/*
+ * QEMU startup timing recorder
+ *
+ * Records how long the phases of qemu_init(), the realization of
+ * -device devices, memory backend preallocation and ROM loading take,
+ * until the machine is ready.  All of these run in the main thread
+ * under the BQL, and there are only a few dozen of them, so events are
+ * simply appended to an array.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/timer.h"
+#include "qapi/error.h"
+#include "qapi/qapi-commands-machine.h"
+#include "system/startup-timing.h"
+
+typedef struct StartupTimingEvent {
+    StartupEventKind kind;
+    char *name;
+    int64_t start;
+    int64_t duration;
+} StartupTimingEvent;
+
+static int64_t startup_timing_epoch;
+static int64_t startup_timing_total;
+static bool startup_timing_done;
+static GArray *startup_timing_events;
+static GArray *startup_timing_deferred;
+
+void startup_timing_init(void)
+{
+    startup_timing_epoch = get_clock();
+    startup_timing_events = g_array_new(false, false,
+                                        sizeof(StartupTimingEvent));
+    startup_timing_deferred = g_array_new(false, false,
+                                          sizeof(StartupTimingEvent));
+}
+
+int64_t startup_timing_begin(void)
+{
+    if (!startup_timing_events || startup_timing_done) {
+        return 0;
+    }
+    return get_clock();
+}
+
+void startup_timing_end(StartupEventKind kind, const char *name,
+                        int64_t begin)
+{
+    StartupTimingEvent ev;
+
+    if (!begin || startup_timing_done) {
+        return;
+    }
+
+    ev.kind = kind;
+    ev.name = g_strdup(name);
+    ev.start = begin - startup_timing_epoch;
+    ev.duration = get_clock() - begin;
+    g_array_append_val(startup_timing_events, ev);
+}
+
+void startup_timing_defer(StartupEventKind kind, const char *name,
+                          int64_t begin)
+{
+    StartupTimingEvent ev;
+
+    if (!begin || startup_timing_done) {
+        return;
+    }
+
+    ev.kind = kind;
+    ev.name = g_strdup(name);
+    ev.start = begin - startup_timing_epoch;
+    ev.duration = 0;
+    g_array_append_val(startup_timing_deferred, ev);
+}
+
+void startup_timing_end_deferred(void)
+{
+    int64_t now;
+    guint i;
+
+    if (!startup_timing_deferred || !startup_timing_deferred->len) {
+        return;
+    }
+
+    now = get_clock() - startup_timing_epoch;
+    for (i = 0; i < startup_timing_deferred->len; i++) {
+        StartupTimingEvent *ev =
+            &g_array_index(startup_timing_deferred, StartupTimingEvent, i);
+
+        ev->duration = now - ev->start;
+        g_array_append_val(startup_timing_events, *ev);
+    }
+    g_array_set_size(startup_timing_deferred, 0);
+}
+
+void startup_timing_finish(void)
+{
+    if (!startup_timing_events || startup_timing_done) {
+        return;
+    }
+    startup_timing_total = get_clock() - startup_timing_epoch;
+    startup_timing_done = true;
+}
+
+static gint startup_timing_cmp(gconstpointer a, gconstpointer b)
+{
+    const StartupTimingEvent *ea = a;
+    const StartupTimingEvent *eb = b;
+
+    /* Enclosing phases first */
+    if (ea->start != eb->start) {
+        return ea->start < eb->start ? -1 : 1;
+    }
+    return ea->duration > eb->duration ? -1 : ea->duration < eb->duration;
+}
+
+StartupTimingInfo *qmp_x_query_startup_timing(Error **errp)
+{
+    StartupTimingInfo *info = g_new0(StartupTimingInfo, 1);
+    StartupEventList **tail = &info->events;
+    g_autoptr(GArray) sorted = NULL;
+    guint i;
+
+    if (!startup_timing_events) {
+        return info;
+    }
+
+    sorted = g_array_copy(startup_timing_events);
+    g_array_sort(sorted, startup_timing_cmp);
+    for (i = 0; i < sorted->len; i++) {
+        StartupTimingEvent *ev = &g_array_index(sorted, StartupTimingEvent, i);
+        StartupEvent *e = g_new0(StartupEvent, 1);
+
+        e->kind = ev->kind;
+        e->name = g_strdup(ev->name);
+        e->start = ev->start;
+        e->duration = ev->duration;
+        QAPI_LIST_APPEND(tail, e);
+    }
+
+    if (startup_timing_done) {
+        info->has_total = true;
+        info->total = startup_timing_total;
+    }
+    return info;
+}
@@ -91,6 +91,7 @@
 #include "qemu/audio.h"
 #include "system/cpus.h"
 #include "system/cpu-timers.h"
+#include "system/startup-timing.h"
 #include "exec/icount.h"
 #include "migration/colo.h"
 #include "migration/postcopy-ram.h"
@@ -2100,6 +2101,8 @@ static bool object_create_late(const char *type)
 
 static void qemu_create_late_backends(void)
 {
+    int64_t t;
+
     if (qtest_chrdev) {
         qtest_server_init(qtest_chrdev, qtest_log, &error_fatal);
     }
@@ -2112,9 +2115,12 @@ static void qemu_create_late_backends(void)
      * Wait for any outstanding memory prealloc from created memory
      * backends to complete.
      */
+    t = startup_timing_begin();
     if (!qemu_finish_async_prealloc_mem(&error_fatal)) {
         exit(1);
     }
+    startup_timing_end_deferred();
+    startup_timing_end(STARTUP_EVENT_KIND_PHASE, "prealloc-wait", t);
 
     if (tpm_init() < 0) {
         exit(1);
@@ -2813,16 +2819,26 @@ static bool qemu_machine_creation_done(Error **errp)
 
 void qmp_x_exit_preconfig(Error **errp)
 {
+    int64_t t;
+
     if (phase_check(PHASE_MACHINE_INITIALIZED)) {
         error_setg(errp, "The command is permitted only before machine initialization");
         return;
     }
 
+    t = startup_timing_begin();
     qemu_init_board();
+    startup_timing_end(STARTUP_EVENT_KIND_PHASE, "board", t);
+
+    t = startup_timing_begin();
     qemu_create_cli_devices();
+    startup_timing_end(STARTUP_EVENT_KIND_PHASE, "devices", t);
+
+    t = startup_timing_begin();
     if (!qemu_machine_creation_done(errp)) {
         return;
     }
+    startup_timing_end(STARTUP_EVENT_KIND_PHASE, "machine-done", t);
 
     if (loadvm) {
         RunState state = autostart ? RUN_STATE_RUNNING : runstate_get();
@@ -2849,6 +2865,11 @@ void qmp_x_exit_preconfig(Error **errp)
     } else if (autostart) {
         qmp_cont(NULL);
     }
+
+    /* Otherwise qemu_init() still has displays to set up */
+    if (preconfig_requested) {
+        startup_timing_finish();
+    }
 }
 
 void qemu_init(int argc, char **argv)
@@ -2860,6 +2881,10 @@ void qemu_init(int argc, char **argv)
     MachineClass *machine_class;
     bool userconfig = true;
     FILE *vmstate_dump_file = NULL;
+    int64_t t;
+
+    startup_timing_init();
+    t = startup_timing_begin();
 
     qemu_add_opts(&qemu_drive_opts);
     qemu_add_drive_opts(&qemu_legacy_drive_opts);
@@ -3151,6 +3176,9 @@ void qemu_init(int argc, char **argv)
             case QEMU_OPTION_jitdump:
                 perf_enable_jitdump();
                 break;
+            case QEMU_OPTION_jitdump_socket:
+                perf_enable_jitdump_socket(optarg);
+                break;
 #endif
             case QEMU_OPTION_seed:
                 qemu_guest_random_seed_main(optarg, &error_fatal);
@@ -3744,6 +3772,7 @@ void qemu_init(int argc, char **argv)
 
     qemu_validate_options(machine_opts_dict);
     qemu_process_sugar_options();
+    startup_timing_end(STARTUP_EVENT_KIND_PHASE, "options", t);
 
     /*
      * These options affect everything else and should be processed
@@ -3791,7 +3820,9 @@ void qemu_init(int argc, char **argv)
     qemu_disable_default_devices();
     qemu_setup_display();
     qemu_create_default_devices();
+    t = startup_timing_begin();
     qemu_create_early_backends();
+    startup_timing_end(STARTUP_EVENT_KIND_PHASE, "early-backends", t);
 
     qemu_apply_legacy_machine_options(machine_opts_dict);
     qemu_apply_machine_options(machine_opts_dict);
@@ -3802,7 +3833,9 @@ void qemu_init(int argc, char **argv)
      * Note: uses machine properties such as kernel-irqchip, must run
      * after qemu_apply_machine_options.
      */
+    t = startup_timing_begin();
     configure_accelerators(argv[0]);
+    startup_timing_end(STARTUP_EVENT_KIND_PHASE, "accel", t);
     phase_advance(PHASE_ACCEL_CREATED);
 
     /*
@@ -3832,7 +3865,9 @@ void qemu_init(int argc, char **argv)
      * check against compatibilities on the backend memories (e.g. postcopy
      * over memory-backend-file objects).
      */
+    t = startup_timing_begin();
     qemu_create_late_backends();
+    startup_timing_end(STARTUP_EVENT_KIND_PHASE, "late-backends", t);
     phase_advance(PHASE_LATE_BACKENDS_CREATED);
 
     /*
@@ -3861,10 +3896,15 @@ void qemu_init(int argc, char **argv)
     if (!preconfig_requested) {
         qmp_x_exit_preconfig(&error_fatal);
     }
+    t = startup_timing_begin();
     qemu_init_displays();
+    startup_timing_end(STARTUP_EVENT_KIND_PHASE, "displays", t);
     accel_setup_post(current_machine);
     if (migrate_mode() != MIG_MODE_CPR_EXEC) {
         os_setup_post();
     }
     resume_mux_open();
+    if (phase_check(PHASE_MACHINE_READY)) {
+        startup_timing_finish();
+    }
 }
@@ -2323,35 +2323,21 @@ static void gen_urhadd_i32(TCGv_i32 d, TCGv_i32 a, TCGv_i32 b)
     tcg_gen_add_i32(d, d, t);
 }
 
-static void gen_urhadd_vec(unsigned vece, TCGv_vec d, TCGv_vec a, TCGv_vec b)
-{
-    TCGv_vec t = tcg_temp_new_vec_matching(d);
-
-    tcg_gen_or_vec(vece, t, a, b);
-    tcg_gen_shri_vec(vece, a, a, 1);
-    tcg_gen_shri_vec(vece, b, b, 1);
-    tcg_gen_and_vec(vece, t, t, tcg_constant_vec_matching(d, vece, 1));
-    tcg_gen_add_vec(vece, d, a, b);
-    tcg_gen_add_vec(vece, d, d, t);
-}
-
 void gen_gvec_urhadd(unsigned vece, uint32_t rd_ofs, uint32_t rn_ofs,
                      uint32_t rm_ofs, uint32_t opr_sz, uint32_t max_sz)
 {
-    static const TCGOpcode vecop_list[] = {
-        INDEX_op_shri_vec, INDEX_op_add_vec, 0
-    };
+    static const TCGOpcode vecop_list[] = { INDEX_op_uavg_vec, 0 };
     static const GVecGen3 g[] = {
         { .fni8 = gen_urhadd8_i64,
-          .fniv = gen_urhadd_vec,
+          .fniv = tcg_gen_uavg_vec,
           .opt_opc = vecop_list,
           .vece = MO_8 },
         { .fni8 = gen_urhadd16_i64,
-          .fniv = gen_urhadd_vec,
+          .fniv = tcg_gen_uavg_vec,
           .opt_opc = vecop_list,
           .vece = MO_16 },
         { .fni4 = gen_urhadd_i32,
-          .fniv = gen_urhadd_vec,
+          .fniv = tcg_gen_uavg_vec,
           .opt_opc = vecop_list,
           .vece = MO_32 },
     };
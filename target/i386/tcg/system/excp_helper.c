@@ -40,6 +40,8 @@ typedef struct TranslateResult {
     hwaddr paddr;
     int prot;
     int page_size;
+    /* Size of the region around paddr that is mapped contiguously. */
+    int contig_size;
 } TranslateResult;
 
 typedef enum TranslateFaultStage2 {
@@ -438,6 +440,7 @@ do_check_protect_pse36:
     /* merge offset within page */
     paddr = (pte & PG_ADDRESS_MASK & ~(page_size - 1)) | (addr & (page_size - 1));
  stage2:
+    out->contig_size = page_size;
 
     /*
      * Note that NPT is walked (for both paging structures and final guest
@@ -471,6 +474,9 @@ do_check_protect_pse36:
         paddr = (full->phys_addr & ~(nested_page_size - 1))
               | (paddr & (nested_page_size - 1));
 
+        /* Only the overlap of both pages is contiguous. */
+        out->contig_size = MIN(page_size, nested_page_size);
+
         /*
          * Use the larger of stage1 & stage2 page sizes, so that
          * invalidation works.
@@ -483,6 +489,10 @@ do_check_protect_pse36:
     out->paddr = paddr & x86_get_a20_mask(env);
     out->prot = prot;
     out->page_size = page_size;
+    if (x86_get_a20_mask(env) != -1) {
+        /* The A20 mask may alias the two halves of a large page. */
+        out->contig_size = TARGET_PAGE_SIZE;
+    }
     return true;
 
  do_fault_rsvd:
@@ -607,6 +617,7 @@ static bool get_physical_address(CPUX86State *env, vaddr addr,
     out->paddr = addr & x86_get_a20_mask(env);
     out->prot = PAGE_READ | PAGE_WRITE | PAGE_EXEC;
     out->page_size = TARGET_PAGE_SIZE;
+    out->contig_size = TARGET_PAGE_SIZE;
     return true;
 }
 
@@ -620,15 +631,21 @@ bool x86_cpu_tlb_fill(CPUState *cs, vaddr addr, int size,
 
     if (get_physical_address(env, addr, access_type, mmu_idx, &out, &err,
                              retaddr)) {
+        CPUTLBEntryFull full = {
+            .phys_addr = out.paddr & TARGET_PAGE_MASK,
+            .attrs = cpu_get_mem_attrs(env),
+            .prot = out.prot,
+            .lg_page_size = ctz32(out.page_size),
+            .lg_contig_size = ctz32(out.contig_size),
+        };
+
         /*
          * Even if 4MB pages, we map only one 4KB page in the cache to
-         * avoid filling it too fast.
+         * avoid filling it too fast; the other pages of a large page
+         * are filled from this entry by cputlb without another walk.
          */
         assert(out.prot & (1 << access_type));
-        tlb_set_page_with_attrs(cs, addr & TARGET_PAGE_MASK,
-                                out.paddr & TARGET_PAGE_MASK,
-                                cpu_get_mem_attrs(env),
-                                out.prot, mmu_idx, out.page_size);
+        tlb_set_page_full(cs, mmu_idx, addr & TARGET_PAGE_MASK, &full);
         return true;
     }
 
@@ -42,11 +42,32 @@ typedef struct TempOptInfo {
     TCGTemp *prev_copy;
     TCGTemp *next_copy;
     QSIMPLEQ_HEAD(, MemCopyInfo) mem_copy;
+    unsigned def;     /* changes each time the temp is (re)defined */
     uint64_t z_mask;  /* mask bit is 0 if and only if value bit is 0 */
     uint64_t o_mask;  /* mask bit is 1 if and only if value bit is 1 */
     uint64_t s_mask;  /* mask bit is 1 if value bit matches msb */
 } TempOptInfo;
 
+/*
+ * An available expression for common subexpression elimination:
+ * OUT holds the result of OPC applied to ARGS, for as long as neither
+ * OUT nor the temps among ARGS have been redefined.
+ */
+#define CSE_MAX_ARGS    5
+#define CSE_TABLE_SIZE  64
+
+typedef struct CSEInfo {
+    TCGTemp *out;
+    unsigned out_def;
+    TCGOpcode opc;
+    uint8_t type;
+    uint8_t flags;
+    uint8_t nb_iargs;
+    uint8_t nb_args;
+    TCGArg args[CSE_MAX_ARGS];
+    unsigned in_def[CSE_MAX_ARGS];
+} CSEInfo;
+
 typedef struct OptContext {
     TCGContext *tcg;
     TCGOp *prev_mb;
@@ -55,6 +76,9 @@ typedef struct OptContext {
     IntervalTreeRoot mem_copy;
     QSIMPLEQ_HEAD(, MemCopyInfo) mem_free;
 
+    CSEInfo *cse;
+    unsigned def_count;
+
     /* In flight values from optimization. */
     TCGType type;
     int carry_state;  /* -1 = non-constant, {0,1} = constant carry-in */
@@ -142,6 +166,7 @@ static void init_ts_info(OptContext *ctx, TCGTemp *ts)
     ti->next_copy = ts;
     ti->prev_copy = ts;
     QSIMPLEQ_INIT(&ti->mem_copy);
+    ti->def = ++ctx->def_count;
     if (ts->kind == TEMP_CONST) {
         ti->z_mask = ts->val;
         ti->o_mask = ts->val;
@@ -234,6 +259,7 @@ static void reset_ts(OptContext *ctx, TCGTemp *ts)
     pi->next_copy = ti->next_copy;
     ti->next_copy = ts;
     ti->prev_copy = ts;
+    ti->def = ++ctx->def_count;
     ti->z_mask = -1;
     ti->o_mask = 0;
     ti->s_mask = 0;
@@ -847,6 +873,158 @@ static void copy_propagate(OptContext *ctx, TCGOp *op,
     }
 }
 
+/*
+ * Common subexpression elimination within an extended basic block.
+ * Only pure, single output integer operations are considered; loads
+ * from env are handled by the mem_copy tracking above, and guest memory
+ * accesses may have side effects.
+ */
+static bool cse_opcode(TCGOpcode opc)
+{
+    switch (opc) {
+    case INDEX_op_add:
+    case INDEX_op_and:
+    case INDEX_op_andc:
+    case INDEX_op_bswap16:
+    case INDEX_op_bswap32:
+    case INDEX_op_bswap64:
+    case INDEX_op_clz:
+    case INDEX_op_ctpop:
+    case INDEX_op_ctz:
+    case INDEX_op_deposit:
+    case INDEX_op_eqv:
+    case INDEX_op_extract:
+    case INDEX_op_extract2:
+    case INDEX_op_ext_i32_i64:
+    case INDEX_op_extu_i32_i64:
+    case INDEX_op_extrl_i64_i32:
+    case INDEX_op_extrh_i64_i32:
+    case INDEX_op_movcond:
+    case INDEX_op_mul:
+    case INDEX_op_mulsh:
+    case INDEX_op_muluh:
+    case INDEX_op_nand:
+    case INDEX_op_neg:
+    case INDEX_op_negsetcond:
+    case INDEX_op_nor:
+    case INDEX_op_not:
+    case INDEX_op_or:
+    case INDEX_op_orc:
+    case INDEX_op_rotl:
+    case INDEX_op_rotr:
+    case INDEX_op_sar:
+    case INDEX_op_setcond:
+    case INDEX_op_sextract:
+    case INDEX_op_shl:
+    case INDEX_op_shr:
+    case INDEX_op_sub:
+    case INDEX_op_xor:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool cse_commutative(TCGOpcode opc)
+{
+    switch (opc) {
+    case INDEX_op_add:
+    case INDEX_op_and:
+    case INDEX_op_eqv:
+    case INDEX_op_mul:
+    case INDEX_op_mulsh:
+    case INDEX_op_muluh:
+    case INDEX_op_nand:
+    case INDEX_op_nor:
+    case INDEX_op_or:
+    case INDEX_op_xor:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static CSEInfo *cse_slot(OptContext *ctx, const CSEInfo *key)
+{
+    uint32_t h = key->opc * 0x9e3779b9u + key->type;
+
+    for (int i = 0; i < key->nb_args; i++) {
+        h = (h ^ (uint32_t)(key->args[i] >> 4)) * 0x01000193u;
+    }
+    return &ctx->cse[(h >> 16) % CSE_TABLE_SIZE];
+}
+
+/*
+ * Build the CSE key for @op into @key, before the outputs of @op are
+ * reset.  If an equivalent expression is still available, replace @op
+ * with a copy of it and return true.
+ */
+static bool fold_cse(OptContext *ctx, TCGOp *op, CSEInfo *key)
+{
+    const TCGOpDef *def = &tcg_op_defs[op->opc];
+    int nb_iargs = def->nb_iargs;
+    int nb_args = nb_iargs + def->nb_cargs;
+    CSEInfo *ce;
+    int i;
+
+    key->out = NULL;
+    key->nb_args = 0;
+    if (!cse_opcode(op->opc) ||
+        def->nb_oargs != 1 || nb_args > CSE_MAX_ARGS) {
+        return false;
+    }
+
+    key->opc = op->opc;
+    key->type = TCGOP_TYPE(op);
+    key->flags = TCGOP_FLAGS(op);
+    key->nb_iargs = nb_iargs;
+    key->nb_args = nb_args;
+    for (i = 0; i < nb_args; i++) {
+        key->args[i] = op->args[1 + i];
+        key->in_def[i] = i < nb_iargs ? arg_info(key->args[i])->def : 0;
+    }
+    if (cse_commutative(op->opc) && key->args[0] > key->args[1]) {
+        TCGArg ta = key->args[0];
+        unsigned td = key->in_def[0];
+
+        key->args[0] = key->args[1];
+        key->in_def[0] = key->in_def[1];
+        key->args[1] = ta;
+        key->in_def[1] = td;
+    }
+
+    ce = cse_slot(ctx, key);
+    if (!ce->out
+        || ce->opc != key->opc
+        || ce->type != key->type
+        || ce->flags != key->flags
+        || !test_bit(temp_idx(ce->out), ctx->temps_used.l)
+        || ts_info(ce->out)->def != ce->out_def
+        || memcmp(ce->args, key->args, nb_args * sizeof(TCGArg))
+        || memcmp(ce->in_def, key->in_def, nb_args * sizeof(unsigned))) {
+        return false;
+    }
+    return tcg_opt_gen_mov(ctx, op, op->args[0], temp_arg(ce->out));
+}
+
+/* Make the result of @op, described by @key, available to fold_cse. */
+static void record_cse(OptContext *ctx, TCGOp *op, CSEInfo *key)
+{
+    TCGTemp *out = arg_temp(op->args[0]);
+
+    if (!key->out && key->nb_args) {
+        /* The output must not also be an input: it was just redefined. */
+        for (int i = 0; i < key->nb_iargs; i++) {
+            if (arg_temp(key->args[i]) == out) {
+                return;
+            }
+        }
+        key->out = out;
+        key->out_def = ts_info(out)->def;
+        *cse_slot(ctx, key) = *key;
+    }
+}
+
 static void finish_bb(OptContext *ctx)
 {
     /* We only optimize memory barriers across basic blocks. */
@@ -864,13 +1042,20 @@ static void finish_ebb(OptContext *ctx)
 static bool finish_folding(OptContext *ctx, TCGOp *op)
 {
     const TCGOpDef *def = &tcg_op_defs[op->opc];
+    CSEInfo cse;
     int i, nb_oargs;
 
+    if (fold_cse(ctx, op, &cse)) {
+        return true;
+    }
+
     nb_oargs = def->nb_oargs;
     for (i = 0; i < nb_oargs; i++) {
         TCGTemp *ts = arg_temp(op->args[i]);
         reset_ts(ctx, ts);
     }
+
+    record_cse(ctx, op, &cse);
     return true;
 }
 
@@ -931,6 +1116,7 @@ static bool fold_masks_zosa_int(OptContext *ctx, TCGOp *op,
                                 int64_t s_mask, uint64_t a_mask)
 {
     const TCGOpDef *def = &tcg_op_defs[op->opc];
+    CSEInfo cse;
     TCGTemp *ts;
     TempOptInfo *ti;
     int rep;
@@ -965,6 +1151,10 @@ static bool fold_masks_zosa_int(OptContext *ctx, TCGOp *op,
         return tcg_opt_gen_mov(ctx, op, op->args[0], op->args[1]);
     }
 
+    if (fold_cse(ctx, op, &cse)) {
+        return true;
+    }
+
     ts = arg_temp(op->args[0]);
     reset_ts(ctx, ts);
 
@@ -979,6 +1169,7 @@ static bool fold_masks_zosa_int(OptContext *ctx, TCGOp *op,
     rep = MAX(rep - 1, 0);
     ti->s_mask = INT64_MIN >> rep;
 
+    record_cse(ctx, op, &cse);
     return false;
 }
 
@@ -3032,6 +3223,8 @@ void tcg_optimize(TCGContext *s)
     OptContext ctx = { .tcg = s };
 
     QSIMPLEQ_INIT(&ctx.mem_free);
+    ctx.cse = tcg_malloc(sizeof(CSEInfo) * CSE_TABLE_SIZE);
+    memset(ctx.cse, 0, sizeof(CSEInfo) * CSE_TABLE_SIZE);
 
     /* Array VALS has an element for each temp.
        If this temp holds a constant then its value is kept in VALS' element.
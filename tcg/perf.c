@@ -12,22 +12,31 @@
 #include "elf.h"
 #include "exec/target_page.h"
 #include "exec/translation-block.h"
+#include "qemu/sockets.h"
+#include "qemu/thread.h"
 #include "qemu/timer.h"
+#include "qemu/units.h"
+#include "qapi/error.h"
 #include "tcg/debuginfo.h"
 #include "tcg/perf.h"
 #include "tcg/tcg.h"
 
+static int safe_open_w(const char *path)
+{
+    /* Delete the old file, if any. */
+    unlink(path);
+
+    /* Avoid symlink attacks by using O_CREAT | O_EXCL. */
+    return open(path, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+}
+
 static FILE *safe_fopen_w(const char *path)
 {
     int saved_errno;
     FILE *f;
     int fd;
 
-    /* Delete the old file, if any. */
-    unlink(path);
-
-    /* Avoid symlink attacks by using O_CREAT | O_EXCL. */
-    fd = open(path, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    fd = safe_open_w(path);
     if (fd == -1) {
         return NULL;
     }
@@ -110,7 +119,35 @@ static void write_perfmap_entry(const void *start, size_t insn,
             host_pc, host_size, pretty_symbol(q, NULL));
 }
 
-static FILE *jitdump;
+/*
+ * jitdump records are not written from the translating thread.  They are
+ * appended to a ring buffer and a separate thread streams them to the
+ * jitdump file or socket, so that translation never waits for I/O.  If
+ * the writer falls behind, whole records are dropped rather than
+ * blocking translation.
+ *
+ * The file or socket is opened while parsing the command line, but the
+ * thread is only started with the first record, so that it is created
+ * in the process that remains after -daemonize.
+ */
+#define JITDUMP_RING_SIZE (4 * MiB)
+
+static struct {
+    QemuMutex lock;
+    QemuCond cond;
+    QemuThread thread;
+    uint8_t *buf;
+    /* Free-running byte counters; buf index is counter % JITDUMP_RING_SIZE */
+    size_t head;
+    size_t tail;
+    uint64_t dropped;
+    bool started;
+    bool exiting;
+    int fd;
+    bool is_socket;
+} jitdump_ring;
+
+static bool jitdump;
 static size_t perf_marker_size;
 static void *perf_marker = MAP_FAILED;
 
@@ -188,19 +225,162 @@ static uint32_t get_e_machine(void)
     return elf_header.e_machine;
 }
 
-void perf_enable_jitdump(void)
+static void jitdump_push_locked(const void *data, size_t len)
+{
+    size_t off, n;
+
+    if (JITDUMP_RING_SIZE - (jitdump_ring.head - jitdump_ring.tail) < len) {
+        jitdump_ring.dropped++;
+        return;
+    }
+
+    off = jitdump_ring.head % JITDUMP_RING_SIZE;
+    n = MIN(len, JITDUMP_RING_SIZE - off);
+    memcpy(jitdump_ring.buf + off, data, n);
+    memcpy(jitdump_ring.buf, (const uint8_t *)data + n, len - n);
+    jitdump_ring.head += len;
+}
+
+static bool jitdump_write(const uint8_t *buf, size_t len)
+{
+    while (len) {
+        ssize_t n;
+
+        if (jitdump_ring.is_socket) {
+            n = send(jitdump_ring.fd, buf, len, MSG_NOSIGNAL);
+        } else {
+            n = write(jitdump_ring.fd, buf, len);
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static void *jitdump_thread(void *arg)
+{
+    bool ok = true;
+
+    qemu_mutex_lock(&jitdump_ring.lock);
+    for (;;) {
+        size_t off, n;
+
+        while (jitdump_ring.head == jitdump_ring.tail &&
+               !jitdump_ring.exiting) {
+            qemu_cond_wait(&jitdump_ring.cond, &jitdump_ring.lock);
+        }
+        if (jitdump_ring.head == jitdump_ring.tail) {
+            break;
+        }
+
+        /*
+         * Producers never overwrite bytes between tail and head, so the
+         * chunk can be written out without holding the lock.
+         */
+        off = jitdump_ring.tail % JITDUMP_RING_SIZE;
+        n = MIN(jitdump_ring.head - jitdump_ring.tail,
+                JITDUMP_RING_SIZE - off);
+        qemu_mutex_unlock(&jitdump_ring.lock);
+
+        if (ok && !jitdump_write(jitdump_ring.buf + off, n)) {
+            warn_report("jitdump: write failed: %s, "
+                        "discarding further records", strerror(errno));
+            ok = false;
+        }
+
+        qemu_mutex_lock(&jitdump_ring.lock);
+        jitdump_ring.tail += n;
+    }
+    qemu_mutex_unlock(&jitdump_ring.lock);
+
+    return NULL;
+}
+
+/* Queue the header and start the writer thread, see the comment above */
+static void jitdump_start_thread_locked(void)
 {
     struct jitheader header;
+
+    header.magic = JITHEADER_MAGIC;
+    header.version = JITHEADER_VERSION;
+    header.total_size = sizeof(header);
+    header.elf_mach = get_e_machine();
+    header.pad1 = 0;
+    header.pid = getpid();
+    header.timestamp = get_clock();
+    header.flags = 0;
+    jitdump_push_locked(&header, sizeof(header));
+
+    qemu_thread_create(&jitdump_ring.thread, "jitdump", jitdump_thread,
+                       NULL, QEMU_THREAD_JOINABLE);
+    jitdump_ring.started = true;
+}
+
+static void jitdump_push(const void *data, size_t len)
+{
+    qemu_mutex_lock(&jitdump_ring.lock);
+    if (jitdump_ring.exiting) {
+        qemu_mutex_unlock(&jitdump_ring.lock);
+        return;
+    }
+    if (!jitdump_ring.started) {
+        jitdump_start_thread_locked();
+    }
+    jitdump_push_locked(data, len);
+
+    qemu_cond_signal(&jitdump_ring.cond);
+    qemu_mutex_unlock(&jitdump_ring.lock);
+}
+
+static void jitdump_start(int fd, bool is_socket)
+{
+    qemu_mutex_init(&jitdump_ring.lock);
+    qemu_cond_init(&jitdump_ring.cond);
+    jitdump_ring.buf = g_malloc(JITDUMP_RING_SIZE);
+    jitdump_ring.fd = fd;
+    jitdump_ring.is_socket = is_socket;
+    jitdump = true;
+}
+
+/*
+ * There is a single ring and writer thread, so only one of -jitdump and
+ * -jitdump-socket may be given, and only once.
+ */
+static bool jitdump_claim(void)
+{
+    static bool claimed;
+
+    if (claimed) {
+        warn_report("-jitdump and -jitdump-socket are mutually exclusive "
+                    "and may only be given once, ignoring the extra one");
+        return false;
+    }
+    claimed = true;
+    return true;
+}
+
+void perf_enable_jitdump(void)
+{
     char jitdump_file[32];
+    int fd;
 
+    if (!jitdump_claim()) {
+        return;
+    }
     if (!use_rt_clock) {
         warn_report("CLOCK_MONOTONIC is not available, proceeding without jitdump");
         return;
     }
 
     snprintf(jitdump_file, sizeof(jitdump_file), "jit-%d.dump", getpid());
-    jitdump = safe_fopen_w(jitdump_file);
-    if (jitdump == NULL) {
+    fd = safe_open_w(jitdump_file);
+    if (fd == -1) {
         warn_report("Could not open %s: %s, proceeding without jitdump",
                     jitdump_file, strerror(errno));
         return;
@@ -213,24 +393,38 @@ void perf_enable_jitdump(void)
      */
     perf_marker_size = qemu_real_host_page_size();
     perf_marker = mmap(NULL, perf_marker_size, PROT_READ | PROT_EXEC,
-                       MAP_PRIVATE, fileno(jitdump), 0);
+                       MAP_PRIVATE, fd, 0);
     if (perf_marker == MAP_FAILED) {
         warn_report("Could not map %s: %s, proceeding without jitdump",
                     jitdump_file, strerror(errno));
-        fclose(jitdump);
-        jitdump = NULL;
+        close(fd);
         return;
     }
 
-    header.magic = JITHEADER_MAGIC;
-    header.version = JITHEADER_VERSION;
-    header.total_size = sizeof(header);
-    header.elf_mach = get_e_machine();
-    header.pad1 = 0;
-    header.pid = getpid();
-    header.timestamp = get_clock();
-    header.flags = 0;
-    fwrite(&header, sizeof(header), 1, jitdump);
+    jitdump_start(fd, false);
+}
+
+void perf_enable_jitdump_socket(const char *path)
+{
+    Error *local_err = NULL;
+    int fd;
+
+    if (!jitdump_claim()) {
+        return;
+    }
+    if (!use_rt_clock) {
+        warn_report("CLOCK_MONOTONIC is not available, proceeding without jitdump");
+        return;
+    }
+
+    fd = unix_connect(path, &local_err);
+    if (fd < 0) {
+        warn_report_err(local_err);
+        warn_report("proceeding without jitdump");
+        return;
+    }
+
+    jitdump_start(fd, true);
 }
 
 void perf_report_prologue(const void *start, size_t size)
@@ -241,8 +435,8 @@ void perf_report_prologue(const void *start, size_t size)
     }
 }
 
-/* Write a JIT_CODE_DEBUG_INFO jitdump entry. */
-static void write_jr_code_debug_info(const void *start,
+/* Append a JIT_CODE_DEBUG_INFO jitdump entry to @out. */
+static void write_jr_code_debug_info(GByteArray *out, const void *start,
                                      const struct debuginfo_query *q,
                                      size_t icount)
 {
@@ -263,7 +457,7 @@ static void write_jr_code_debug_info(const void *start,
             rec.nr_entry++;
         }
     }
-    fwrite(&rec, sizeof(rec), 1, jitdump);
+    g_byte_array_append(out, (const guint8 *)&rec, sizeof(rec));
 
     /* Write the main debug entries. */
     for (insn = 0; insn < icount; insn++) {
@@ -272,8 +466,9 @@ static void write_jr_code_debug_info(const void *start,
             ent.addr = host_pc;
             ent.lineno = q[insn].line;
             ent.discrim = 0;
-            fwrite(&ent, sizeof(ent), 1, jitdump);
-            fwrite(q[insn].file, strlen(q[insn].file) + 1, 1, jitdump);
+            g_byte_array_append(out, (const guint8 *)&ent, sizeof(ent));
+            g_byte_array_append(out, (const guint8 *)q[insn].file,
+                                strlen(q[insn].file) + 1);
         }
     }
 
@@ -281,15 +476,16 @@ static void write_jr_code_debug_info(const void *start,
     ent.addr = (uintptr_t)start + tcg_ctx->gen_insn_end_off[icount - 1];
     ent.lineno = 0;
     ent.discrim = 0;
-    fwrite(&ent, sizeof(ent), 1, jitdump);
-    fwrite("", 1, 1, jitdump);
+    g_byte_array_append(out, (const guint8 *)&ent, sizeof(ent));
+    g_byte_array_append(out, (const guint8 *)"", 1);
 }
 
-/* Write a JIT_CODE_LOAD jitdump entry. */
-static void write_jr_code_load(const void *start, uint16_t host_size,
+/* Append a JIT_CODE_LOAD jitdump entry to @out. */
+static void write_jr_code_load(GByteArray *out, const void *start,
+                               uint16_t host_size,
                                const struct debuginfo_query *q)
 {
-    static uint64_t code_index;
+    static size_t code_index;
     struct jr_code_load rec;
     const char *symbol;
     size_t symbol_size;
@@ -303,10 +499,10 @@ static void write_jr_code_load(const void *start, uint16_t host_size,
     rec.vma = (uintptr_t)start;
     rec.code_addr = (uintptr_t)start;
     rec.code_size = host_size;
-    rec.code_index = code_index++;
-    fwrite(&rec, sizeof(rec), 1, jitdump);
-    fwrite(symbol, symbol_size, 1, jitdump);
-    fwrite(start, host_size, 1, jitdump);
+    rec.code_index = qatomic_fetch_inc(&code_index);
+    g_byte_array_append(out, (const guint8 *)&rec, sizeof(rec));
+    g_byte_array_append(out, (const guint8 *)symbol, symbol_size);
+    g_byte_array_append(out, start, host_size);
 }
 
 void perf_report_code(uint64_t guest_pc, TranslationBlock *tb,
@@ -349,13 +545,14 @@ void perf_report_code(uint64_t guest_pc, TranslationBlock *tb,
         funlockfile(perfmap);
     }
 
-    /* Emit jitdump entries if needed. */
+    /* Queue jitdump entries if needed. */
     if (jitdump) {
-        flockfile(jitdump);
-        write_jr_code_debug_info(start, q, tb->icount);
-        write_jr_code_load(start, tcg_ctx->gen_insn_end_off[tb->icount - 1],
-                           q);
-        funlockfile(jitdump);
+        g_autoptr(GByteArray) out = g_byte_array_new();
+
+        write_jr_code_debug_info(out, start, q, tb->icount);
+        write_jr_code_load(out, start,
+                           tcg_ctx->gen_insn_end_off[tb->icount - 1], q);
+        jitdump_push(out->data, out->len);
     }
 
     debuginfo_unlock();
@@ -375,7 +572,23 @@ void perf_exit(void)
     }
 
     if (jitdump) {
-        fclose(jitdump);
-        jitdump = NULL;
+        jitdump = false;
+
+        qemu_mutex_lock(&jitdump_ring.lock);
+        jitdump_ring.exiting = true;
+        qemu_cond_signal(&jitdump_ring.cond);
+        qemu_mutex_unlock(&jitdump_ring.lock);
+        if (jitdump_ring.started) {
+            qemu_thread_join(&jitdump_ring.thread);
+        }
+
+        if (jitdump_ring.dropped) {
+            warn_report("jitdump: dropped %" PRIu64 " records, "
+                        "the writer could not keep up",
+                        jitdump_ring.dropped);
+        }
+        close(jitdump_ring.fd);
+        g_free(jitdump_ring.buf);
+        jitdump_ring.buf = NULL;
     }
 }
@@ -68,10 +68,14 @@ struct tcg_region_state {
     size_t size; /* size of one region */
     size_t stride; /* .size + guard size */
     size_t total_size; /* size of entire buffer, >= n * stride */
+    bool numa_local; /* discard the pages of regions when they are reset */
 
     /* fields protected by the lock */
     size_t current; /* current region index */
     size_t agg_size_full; /* aggregate size of full regions */
+    uint64_t alloc_gen; /* incremented at each region allocation */
+    uint64_t *gen; /* per region: alloc_gen at allocation, 0 when free */
+    bool *active; /* per region: assigned to a context */
 };
 
 static struct tcg_region_state region;
@@ -191,6 +195,20 @@ static void tcg_region_trees_init(void)
     }
 }
 
+static size_t tcg_region_index(const void *p)
+{
+    if (p < region.start_aligned) {
+        return 0;
+    } else {
+        ptrdiff_t offset = p - region.start_aligned;
+
+        if (offset > region.stride * (region.n - 1)) {
+            return region.n - 1;
+        }
+        return offset / region.stride;
+    }
+}
+
 static struct tcg_region_tree *tc_ptr_to_region_tree(const void *p)
 {
     size_t region_idx;
@@ -206,17 +224,7 @@ static struct tcg_region_tree *tc_ptr_to_region_tree(const void *p)
         }
     }
 
-    if (p < region.start_aligned) {
-        region_idx = 0;
-    } else {
-        ptrdiff_t offset = p - region.start_aligned;
-
-        if (offset > region.stride * (region.n - 1)) {
-            region_idx = region.n - 1;
-        } else {
-            region_idx = offset / region.stride;
-        }
-    }
+    region_idx = tcg_region_index(p);
     return region_trees + region_idx * tree_size;
 }
 
@@ -345,12 +353,42 @@ static void tcg_region_bounds(size_t curr_region, void **pstart, void **pend)
     *pend = end;
 }
 
+/*
+ * Give the host pages of a region back to the kernel, so that they are
+ * faulted in again on first write by the thread that translates into it
+ * next.  The default host memory policy then places them on that
+ * thread's NUMA node, rather than wherever the previous owner ran.
+ */
+static void tcg_region_discard(size_t curr_region)
+{
+    const size_t page_size = qemu_real_host_page_size();
+    void *start, *end;
+
+    if (!region.numa_local) {
+        return;
+    }
+
+    tcg_region_bounds(curr_region, &start, &end);
+    /* Do not discard the tail of the prologue in the first region. */
+    start = QEMU_ALIGN_PTR_UP(start, page_size);
+    if (start >= end) {
+        return;
+    }
+    /* With split-wx, the buffer is shared memory and must be punched. */
+    (void)qemu_madvise(start, end - start,
+                       tcg_splitwx_diff ? QEMU_MADV_REMOVE
+                                        : QEMU_MADV_DONTNEED);
+}
+
 static void tcg_region_assign(TCGContext *s, size_t curr_region)
 {
     void *start, *end;
 
     tcg_region_bounds(curr_region, &start, &end);
 
+    region.gen[curr_region] = ++region.alloc_gen;
+    region.active[curr_region] = true;
+
     s->code_gen_buffer = start;
     s->code_gen_ptr = start;
     s->code_gen_buffer_size = end - start;
@@ -360,6 +398,13 @@ static void tcg_region_assign(TCGContext *s, size_t curr_region)
 static bool tcg_region_alloc__locked(TCGContext *s)
 {
     if (region.current == region.n) {
+        /* Fall back to regions released by tcg_region_reclaim. */
+        for (size_t i = 0; i < region.n; i++) {
+            if (region.gen[i] == 0) {
+                tcg_region_assign(s, i);
+                return false;
+            }
+        }
         return true;
     }
     tcg_region_assign(s, region.current);
@@ -376,10 +421,13 @@ bool tcg_region_alloc(TCGContext *s)
     bool err;
     /* read the region size now; alloc__locked will overwrite it on success */
     size_t size_full = s->code_gen_buffer_size;
+    /* the full region stays assigned to @s until we find a new one */
+    size_t prev = tcg_region_index(s->code_gen_buffer);
 
     qemu_mutex_lock(&region.lock);
     err = tcg_region_alloc__locked(s);
     if (!err) {
+        region.active[prev] = false;
         region.agg_size_full += size_full - TCG_HIGHWATER;
     }
     qemu_mutex_unlock(&region.lock);
@@ -412,6 +460,8 @@ void tcg_region_reset_all(void)
     qemu_mutex_lock(&region.lock);
     region.current = 0;
     region.agg_size_full = 0;
+    memset(region.gen, 0, region.n * sizeof(*region.gen));
+    memset(region.active, 0, region.n * sizeof(*region.active));
 
     for (i = 0; i < n_ctxs; i++) {
         TCGContext *s = qatomic_read(&tcg_ctxs[i]);
@@ -420,6 +470,56 @@ void tcg_region_reset_all(void)
     qemu_mutex_unlock(&region.lock);
 
     tcg_region_tree_reset_all();
+
+    /* After the trees, whose destructors read the TBs. */
+    for (i = 0; i < region.n; i++) {
+        tcg_region_discard(i);
+    }
+}
+
+/*
+ * Call from a safe-work context.  Pick the least recently allocated
+ * region that is full, i.e. not in use by any context, call @func for
+ * each of its TBs and make it available to tcg_region_alloc again.
+ * @func must unlink the TB from anything that may still reach it,
+ * but the caller has to flush the CPUs' jump caches afterwards; the TB
+ * structures themselves are freed along with the region.
+ */
+bool tcg_region_reclaim(GTraverseFunc func, gpointer user_data)
+{
+    struct tcg_region_tree *rt;
+    size_t i, victim = region.n;
+    void *start, *end;
+
+    qemu_mutex_lock(&region.lock);
+    for (i = 0; i < region.n; i++) {
+        if (region.gen[i] && !region.active[i] &&
+            (victim == region.n || region.gen[i] < region.gen[victim])) {
+            victim = i;
+        }
+    }
+    if (victim == region.n) {
+        qemu_mutex_unlock(&region.lock);
+        return false;
+    }
+    tcg_region_bounds(victim, &start, &end);
+    region.agg_size_full -= (end - start) - TCG_HIGHWATER;
+    qemu_mutex_unlock(&region.lock);
+
+    rt = region_trees + victim * tree_size;
+    qemu_mutex_lock(&rt->lock);
+    q_tree_foreach(rt->tree, func, user_data);
+    /* Increment the refcount first so that destroy acts as a reset */
+    q_tree_ref(rt->tree);
+    q_tree_destroy(rt->tree);
+    qemu_mutex_unlock(&rt->lock);
+
+    tcg_region_discard(victim);
+
+    qemu_mutex_lock(&region.lock);
+    region.gen[victim] = 0;
+    qemu_mutex_unlock(&region.lock);
+    return true;
 }
 
 static size_t tcg_n_regions(size_t tb_size, unsigned max_threads)
@@ -734,7 +834,8 @@ static int alloc_code_gen_buffer(size_t size, int splitwx, Error **errp)
  * in practice. Multi-threaded guests share most if not all of their translated
  * code, which makes parallel code generation less appealing than in system-mode
  */
-void tcg_region_init(size_t tb_size, int splitwx, unsigned max_threads)
+void tcg_region_init(size_t tb_size, int splitwx, unsigned max_threads,
+                     bool numa_local)
 {
     const size_t page_size = qemu_real_host_page_size();
     size_t region_size;
@@ -793,6 +894,9 @@ void tcg_region_init(size_t tb_size, int splitwx, unsigned max_threads)
 
     /* init the region struct */
     qemu_mutex_init(&region.lock);
+    region.numa_local = numa_local;
+    region.gen = g_new0(uint64_t, region.n);
+    region.active = g_new0(bool, region.n);
 
     /*
      * Set guard pages in the rw buffer, as that's the one into which
@@ -40,7 +40,8 @@ extern unsigned int tcg_max_ctxs;
 #define tcg_use_softmmu true
 #endif
 
-void tcg_region_init(size_t tb_size, int splitwx, unsigned max_threads);
+void tcg_region_init(size_t tb_size, int splitwx, unsigned max_threads,
+                     bool numa_local);
 bool tcg_region_alloc(TCGContext *s);
 void tcg_region_initial_alloc(TCGContext *s);
 void tcg_region_prologue_set(TCGContext *s);
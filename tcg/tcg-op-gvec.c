@@ -2553,6 +2553,56 @@ void tcg_gen_gvec_umax(unsigned vece, uint32_t dofs, uint32_t aofs,
     tcg_gen_gvec_3(dofs, aofs, bofs, oprsz, maxsz, &g[vece]);
 }
 
+static void gen_uavg_i32(TCGv_i32 d, TCGv_i32 a, TCGv_i32 b)
+{
+    TCGv_i32 t = tcg_temp_new_i32();
+
+    tcg_gen_xor_i32(t, a, b);
+    tcg_gen_shri_i32(t, t, 1);
+    tcg_gen_or_i32(d, a, b);
+    tcg_gen_sub_i32(d, d, t);
+    tcg_temp_free_i32(t);
+}
+
+static void gen_uavg_i64(TCGv_i64 d, TCGv_i64 a, TCGv_i64 b)
+{
+    TCGv_i64 t = tcg_temp_new_i64();
+
+    tcg_gen_xor_i64(t, a, b);
+    tcg_gen_shri_i64(t, t, 1);
+    tcg_gen_or_i64(d, a, b);
+    tcg_gen_sub_i64(d, d, t);
+    tcg_temp_free_i64(t);
+}
+
+void tcg_gen_gvec_uavg(unsigned vece, uint32_t dofs, uint32_t aofs,
+                       uint32_t bofs, uint32_t oprsz, uint32_t maxsz)
+{
+    static const TCGOpcode vecop_list[] = { INDEX_op_uavg_vec, 0 };
+    static const GVecGen3 g[4] = {
+        { .fniv = tcg_gen_uavg_vec,
+          .fno = gen_helper_gvec_uavg8,
+          .opt_opc = vecop_list,
+          .vece = MO_8 },
+        { .fniv = tcg_gen_uavg_vec,
+          .fno = gen_helper_gvec_uavg16,
+          .opt_opc = vecop_list,
+          .vece = MO_16 },
+        { .fni4 = gen_uavg_i32,
+          .fniv = tcg_gen_uavg_vec,
+          .fno = gen_helper_gvec_uavg32,
+          .opt_opc = vecop_list,
+          .vece = MO_32 },
+        { .fni8 = gen_uavg_i64,
+          .fniv = tcg_gen_uavg_vec,
+          .fno = gen_helper_gvec_uavg64,
+          .opt_opc = vecop_list,
+          .vece = MO_64 }
+    };
+    tcg_debug_assert(vece <= MO_64);
+    tcg_gen_gvec_3(dofs, aofs, bofs, oprsz, maxsz, &g[vece]);
+}
+
 /* Perform a vector negation using normal negation and a mask.
    Compare gen_subv_mask above.  */
 static void gen_negv_mask(TCGv_i64 d, TCGv_i64 b, TCGv_i64 m)
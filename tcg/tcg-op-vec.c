@@ -123,6 +123,11 @@ bool tcg_can_emit_vecop_list(const TCGOpcode *list,
                 continue;
             }
             break;
+        case INDEX_op_uavg_vec:
+            if (tcg_can_emit_vec_op(INDEX_op_shri_vec, type, vece)) {
+                continue;
+            }
+            break;
         case INDEX_op_cmpsel_vec:
         case INDEX_op_smin_vec:
         case INDEX_op_smax_vec:
@@ -658,6 +663,23 @@ void tcg_gen_umax_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
     do_minmax(vece, r, a, b, INDEX_op_umax_vec, TCG_COND_GTU);
 }
 
+void tcg_gen_uavg_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
+{
+    if (!do_op3(vece, r, a, b, INDEX_op_uavg_vec)) {
+        const TCGOpcode *hold_list = tcg_swap_vecop_list(NULL);
+        TCGv_vec t = tcg_temp_new_vec_matching(r);
+
+        /* uavg(a, b) = (a | b) - ((a ^ b) >> 1) */
+        tcg_gen_xor_vec(vece, t, a, b);
+        tcg_gen_shri_vec(vece, t, t, 1);
+        tcg_gen_or_vec(vece, r, a, b);
+        tcg_gen_sub_vec(vece, r, r, t);
+
+        tcg_temp_free_vec(t);
+        tcg_swap_vecop_list(hold_list);
+    }
+}
+
 void tcg_gen_shlv_vec(unsigned vece, TCGv_vec r, TCGv_vec a, TCGv_vec b)
 {
     do_op3_nofail(vece, r, a, b, INDEX_op_shlv_vec);
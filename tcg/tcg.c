@@ -1814,10 +1814,11 @@ static void tcg_context_init(unsigned max_threads)
     tcg_env = temp_tcgv_ptr(ts);
 }
 
-void tcg_init(size_t tb_size, int splitwx, unsigned max_threads)
+void tcg_init(size_t tb_size, int splitwx, unsigned max_threads,
+              bool numa_local)
 {
     tcg_context_init(max_threads);
-    tcg_region_init(tb_size, splitwx, max_threads);
+    tcg_region_init(tb_size, splitwx, max_threads, numa_local);
 }
 
 /*
@@ -2447,6 +2448,8 @@ bool tcg_op_supported(TCGOpcode op, TCGType type, unsigned flags)
     case INDEX_op_smax_vec:
     case INDEX_op_umax_vec:
         return has_type && TCG_TARGET_HAS_minmax_vec;
+    case INDEX_op_uavg_vec:
+        return has_type && TCG_TARGET_HAS_uavg_vec;
     case INDEX_op_bitsel_vec:
         return has_type && TCG_TARGET_HAS_bitsel_vec;
     case INDEX_op_cmpsel_vec:
@@ -171,4 +171,29 @@ def __init__(self, name, scenarios):
         Scenario("compr-multifd-compression-uadk",
                  multifd=True, multifd_channels=2, multifd_compression="uadk"),
     ]),
+
+
+    # Looking at effect of the guest dirty rate on multifd
+    Comparison("multifd-dirty-rate", scenarios = [
+        Scenario("multifd-dirty-rate-100mbs",
+                 multifd=True, multifd_channels=4, dirty_rate=100),
+        Scenario("multifd-dirty-rate-500mbs",
+                 multifd=True, multifd_channels=4, dirty_rate=500),
+        Scenario("multifd-dirty-rate-1gbs",
+                 multifd=True, multifd_channels=4, dirty_rate=1024),
+        Scenario("multifd-dirty-rate-unlimited",
+                 multifd=True, multifd_channels=4),
+    ]),
+
+
+    # Looking at effect of zero page detection with varying
+    # proportions of zero guest RAM
+    Comparison("multifd-zero-pages", scenarios = [
+        Scenario("multifd-zero-pages-0",
+                 multifd=True, multifd_channels=4, zero_pct=0),
+        Scenario("multifd-zero-pages-50",
+                 multifd=True, multifd_channels=4, zero_pct=50),
+        Scenario("multifd-zero-pages-90",
+                 multifd=True, multifd_channels=4, zero_pct=90),
+    ]),
 ]
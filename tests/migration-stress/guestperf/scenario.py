@@ -32,7 +32,8 @@ def __init__(self, name,
                  compression_xbzrle=False, compression_xbzrle_cache=10,
                  multifd=False, multifd_channels=2, multifd_compression="",
                  dirty_limit=False, x_vcpu_dirty_limit_period=500,
-                 vcpu_dirty_limit=1):
+                 vcpu_dirty_limit=1,
+                 dirty_rate=0, zero_pct=0):
 
         self._name = name
 
@@ -67,6 +68,10 @@ def __init__(self, name,
         self._x_vcpu_dirty_limit_period = x_vcpu_dirty_limit_period
         self._vcpu_dirty_limit = vcpu_dirty_limit
 
+        # Guest workload
+        self._dirty_rate = dirty_rate # MiB per second, 0 for unlimited
+        self._zero_pct = zero_pct # percentage of guest RAM left zero
+
     def serialize(self):
         return {
             "name": self._name,
@@ -90,6 +95,8 @@ def serialize(self):
             "dirty_limit": self._dirty_limit,
             "x_vcpu_dirty_limit_period": self._x_vcpu_dirty_limit_period,
             "vcpu_dirty_limit": self._vcpu_dirty_limit,
+            "dirty_rate": self._dirty_rate,
+            "zero_pct": self._zero_pct,
         }
 
     @classmethod
@@ -112,4 +119,6 @@ def deserialize(cls, data):
             data["compression_xbzrle_cache"],
             data["multifd"],
             data["multifd_channels"],
-            data["multifd_compression"])
+            data["multifd_compression"],
+            dirty_rate=data.get("dirty_rate", 0),
+            zero_pct=data.get("zero_pct", 0))
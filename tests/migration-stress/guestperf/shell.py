@@ -145,6 +145,11 @@ def __init__(self):
                             dest="vcpu_dirty_limit",
                             default=1, type=int)
 
+        parser.add_argument("--dirty-rate", dest="dirty_rate",
+                            default=0, type=int)
+        parser.add_argument("--zero-percent", dest="zero_pct",
+                            default=0, type=int)
+
     def get_scenario(self, args):
         return Scenario(name="perfreport",
                         downtime=args.downtime,
@@ -174,7 +179,10 @@ def get_scenario(self, args):
                         dirty_limit=args.dirty_limit,
                         x_vcpu_dirty_limit_period=\
                             args.x_vcpu_dirty_limit_period,
-                        vcpu_dirty_limit=args.vcpu_dirty_limit)
+                        vcpu_dirty_limit=args.vcpu_dirty_limit,
+
+                        dirty_rate=args.dirty_rate,
+                        zero_pct=args.zero_pct)
 
     def run(self, argv):
         args = self._parser.parse_args(argv)
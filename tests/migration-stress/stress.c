@@ -29,6 +29,11 @@ const char *argv0;
 
 #define RAM_PAGE_SIZE 4096
 
+/* Total rate at which RAM is dirtied in MiB/s, 0 for as fast as possible */
+static unsigned long long dirtyrateMB;
+/* Percentage of each MiB that is left zero and never dirtied */
+static unsigned long long zeropct;
+
 #ifndef CONFIG_GETTID
 static int gettid(void)
 {
@@ -156,9 +161,10 @@ static unsigned long long now(void)
     return (tv.tv_sec * 1000ull) + (tv.tv_usec / 1000ull);
 }
 
-static void stressone(unsigned long long ramsizeMB)
+static void stressone(unsigned long long ramsizeMB, unsigned long long rateMB)
 {
     size_t pagesPerMB = 1024 * 1024 / RAM_PAGE_SIZE;
+    size_t zeroPages = pagesPerMB * zeropct / 100;
     g_autofree char *ram = g_malloc(ramsizeMB * 1024 * 1024);
     char *ramptr;
     size_t i, j, k;
@@ -166,6 +172,7 @@ static void stressone(unsigned long long ramsizeMB)
     char *dataptr;
     size_t nMB = 0;
     unsigned long long before, after;
+    unsigned long long ratestart, dirtied = 0;
 
     /* We don't care about initial state, but we do want
      * to fault it all into RAM, otherwise the first iter
@@ -174,22 +181,39 @@ static void stressone(unsigned long long ramsizeMB)
      * calloc instead :-) */
     memset(ram, 0xfe, ramsizeMB * 1024 * 1024);
 
+    /* The zero pages are at the start of each MiB */
+    for (i = 0; i < ramsizeMB; i++) {
+        memset(ram + i * 1024 * 1024, 0, zeroPages * RAM_PAGE_SIZE);
+    }
+
     if (random_bytes(data, RAM_PAGE_SIZE) < 0) {
         return;
     }
 
-    before = now();
+    before = ratestart = now();
 
     while (1) {
 
         ramptr = ram;
         for (i = 0; i < ramsizeMB; i++, nMB++) {
-            for (j = 0; j < pagesPerMB; j++) {
+            ramptr += zeroPages * RAM_PAGE_SIZE;
+            for (j = zeroPages; j < pagesPerMB; j++) {
                 dataptr = data;
                 for (k = 0; k < RAM_PAGE_SIZE; k += sizeof(long long)) {
+                    *(unsigned long long *)ramptr ^= *(unsigned long long *)dataptr;
                     ramptr += sizeof(long long);
                     dataptr += sizeof(long long);
-                    *(unsigned long long *)ramptr ^= *(unsigned long long *)dataptr;
+                }
+            }
+
+            if (rateMB) {
+                unsigned long long due, elapsed;
+
+                dirtied += (pagesPerMB - zeroPages) * RAM_PAGE_SIZE;
+                due = dirtied * 1000 / (rateMB * 1024 * 1024);
+                elapsed = now() - ratestart;
+                if (due > elapsed) {
+                    usleep((due - elapsed) * 1000);
                 }
             }
 
@@ -205,11 +229,13 @@ static void stressone(unsigned long long ramsizeMB)
 }
 
 
+static unsigned long long thread_rateMB;
+
 static void *stressthread(void *arg)
 {
     unsigned long long ramsizeMB = *(unsigned long long *)arg;
 
-    stressone(ramsizeMB);
+    stressone(ramsizeMB, thread_rateMB);
 
     return NULL;
 }
@@ -218,6 +244,10 @@ static void stress(unsigned long long ramsizeGB, int ncpus)
 {
     size_t i;
     unsigned long long ramsizeMB = ramsizeGB * 1024 / ncpus;
+
+    if (dirtyrateMB) {
+        thread_rateMB = MAX(dirtyrateMB / ncpus, 1);
+    }
     ncpus--;
 
     for (i = 0; i < ncpus; i++) {
@@ -226,7 +256,7 @@ static void stress(unsigned long long ramsizeGB, int ncpus)
                        stressthread,   &ramsizeMB);
     }
 
-    stressone(ramsizeMB);
+    stressone(ramsizeMB, thread_rateMB);
 }
 
 
@@ -266,11 +296,13 @@ int main(int argc, char **argv)
     char *end;
     int ch;
     int opt_ind = 0;
-    const char *sopt = "hr:c:";
+    const char *sopt = "hr:c:d:z:";
     struct option lopt[] = {
         { "help", no_argument, NULL, 'h' },
         { "ramsize", required_argument, NULL, 'r' },
         { "cpus", required_argument, NULL, 'c' },
+        { "dirty-rate", required_argument, NULL, 'd' },
+        { "zero-percent", required_argument, NULL, 'z' },
         { NULL, 0, NULL, 0 }
     };
     int ret;
@@ -300,9 +332,30 @@ int main(int argc, char **argv)
             }
             break;
 
+        case 'd':
+            errno = 0;
+            dirtyrateMB = strtoll(optarg, &end, 10);
+            if (errno != 0 || *end) {
+                fprintf(stderr, "%s (%05d): ERROR: Cannot parse dirty rate %s\n",
+                        argv0, gettid(), optarg);
+                exit_failure();
+            }
+            break;
+
+        case 'z':
+            errno = 0;
+            zeropct = strtoll(optarg, &end, 10);
+            if (errno != 0 || *end) {
+                fprintf(stderr, "%s (%05d): ERROR: Cannot parse zero percentage %s\n",
+                        argv0, gettid(), optarg);
+                exit_failure();
+            }
+            break;
+
         case '?':
         case 'h':
-            fprintf(stderr, "%s: [--help][--ramsize GB][--cpus N]\n", argv0);
+            fprintf(stderr, "%s: [--help][--ramsize GB][--cpus N]"
+                    "[--dirty-rate MB/s][--zero-percent N]\n", argv0);
             exit_failure();
         }
     }
@@ -314,13 +367,24 @@ int main(int argc, char **argv)
         ret = get_command_arg_ull("ramsize", &ramsizeGB);
         if (ret < 0)
             exit_failure();
+
+        if (get_command_arg_ull("dirtyrate", &dirtyrateMB) < 0 ||
+            get_command_arg_ull("zeropct", &zeropct) < 0)
+            exit_failure();
+    }
+
+    if (zeropct > 100) {
+        fprintf(stderr, "%s (%05d): ERROR: zero percentage %llu over 100\n",
+                argv0, gettid(), zeropct);
+        exit_failure();
     }
 
     if (ncpus == 0)
         ncpus = sysconf(_SC_NPROCESSORS_ONLN);
 
-    fprintf(stdout, "%s (%05d): INFO: RAM %llu GiB across %d CPUs\n",
-            argv0, gettid(), ramsizeGB, ncpus);
+    fprintf(stdout, "%s (%05d): INFO: RAM %llu GiB across %d CPUs, "
+            "dirty rate %llu MiB/s, %llu%% zero\n",
+            argv0, gettid(), ramsizeGB, ncpus, dirtyrateMB, zeropct);
 
     stress(ramsizeGB, ncpus);
 
@@ -166,6 +166,24 @@ static void test_multifd_tcp_zlib(char *name, MigrateCommon *args)
     test_precopy_common(args);
 }
 
+static void *
+migrate_hook_start_precopy_tcp_multifd_xbzrle(QTestState *from,
+                                              QTestState *to)
+{
+    set_multifd_compression(from, to, "xbzrle");
+
+    return NULL;
+}
+
+static void test_multifd_tcp_xbzrle(char *name, MigrateCommon *args)
+{
+    args->start_hook = migrate_hook_start_precopy_tcp_multifd_xbzrle;
+
+    args->start.caps[MIGRATION_CAPABILITY_MULTIFD] = true;
+
+    test_precopy_common(args);
+}
+
 static void migration_test_add_compression_smoke(MigrationTestEnv *env)
 {
     migration_test_add("/migration/multifd/tcp/plain/zlib",
@@ -182,6 +200,9 @@ void migration_test_add_compression(MigrationTestEnv *env)
         return;
     }
 
+    migration_test_add("/migration/multifd/tcp/plain/xbzrle",
+                       test_multifd_tcp_xbzrle);
+
 #ifdef CONFIG_ZSTD
     migration_test_add("/migration/multifd/tcp/plain/zstd",
                        test_multifd_tcp_zstd);
@@ -533,6 +533,13 @@ static bool run_poll_handlers(AioContext *ctx, AioHandlerList *ready_list,
         progress = true;
     }
 
+    qatomic_set(&ctx->poll_time_ns, ctx->poll_time_ns + elapsed_time);
+    if (progress) {
+        qatomic_set(&ctx->poll_hits, ctx->poll_hits + 1);
+    } else {
+        qatomic_set(&ctx->poll_misses, ctx->poll_misses + 1);
+    }
+
     /* If time has passed with no successful polling, adjust *timeout to
      * keep the same ending time.
      */
@@ -736,6 +743,7 @@ bool aio_poll(AioContext *ctx, bool blocking)
     if (ctx->poll_max_ns) {
         dispatch_ns = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
         block_ns = dispatch_ns - start;
+        qatomic_set(&ctx->idle_time_ns, ctx->idle_time_ns + block_ns);
     }
 
     if (ctx->fdmon_ops->dispatch) {
@@ -755,6 +763,11 @@ bool aio_poll(AioContext *ctx, bool blocking)
 
     progress |= timerlistgroup_run_timers(&ctx->tlg);
 
+    if (dispatch_ns) {
+        qatomic_set(&ctx->dispatch_time_ns, ctx->dispatch_time_ns +
+                    qemu_clock_get_ns(QEMU_CLOCK_REALTIME) - dispatch_ns);
+    }
+
     return progress;
 }
 
@@ -463,6 +463,17 @@ void timer_mod_ns(QEMUTimer *ts, int64_t expire_time)
     bool rearm;
 
     qemu_mutex_lock(&timer_list->active_timers_lock);
+    if (timer_pending(ts) && ts->expire_time == expire_time &&
+        (!ts->next || ts->next->expire_time != expire_time) &&
+        replay_mode == REPLAY_MODE_NONE) {
+        /*
+         * Already armed for this deadline and last among the timers that
+         * share it, which is where it would be inserted again: skip the
+         * two list walks.
+         */
+        qemu_mutex_unlock(&timer_list->active_timers_lock);
+        return;
+    }
     timer_del_locked(timer_list, ts);
     rearm = timer_mod_ns_locked(timer_list, ts, expire_time);
     qemu_mutex_unlock(&timer_list->active_timers_lock);
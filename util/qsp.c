@@ -31,6 +31,11 @@
  * of the same type can be coalesced, which can be particularly useful when
  * profiling dynamically-allocated objects.
  *
+ * To keep the overhead low enough for long-running profiling, only one in
+ * every N operations of each thread can be timed (see qsp_set_sample_period).
+ * Sampled operations are weighted by N, so that reported wait times and
+ * acquisition counts remain estimates of the totals.
+ *
  * Alternative designs considered:
  *
  * - Use an off-the-shelf profiler such as mutrace. This is not a viable option
@@ -107,6 +112,10 @@ static size_t qsp_qemu_path_len;
 /* the address of qsp_thread gives us a unique 'thread ID' */
 static __thread int qsp_thread;
 
+/* time one in every qsp_sample_period operations of each thread */
+static unsigned int qsp_sample_period = 1;
+static __thread unsigned int qsp_sample_countdown;
+
 /*
  * Call sites are the same for all threads, so we track them in a separate hash
  * table to save memory.
@@ -340,21 +349,37 @@ static QSPEntry *qsp_entry_get(const void *obj, const char *file, int line,
     return qsp_entry_find(&qsp_ht, &orig, hash);
 }
 
+/*
+ * Returns 0 if this operation should not be timed, otherwise the weight
+ * to give to the sample.
+ */
+static inline unsigned int qsp_sample(void)
+{
+    if (qsp_sample_countdown > 1) {
+        qsp_sample_countdown--;
+        return 0;
+    }
+    qsp_sample_countdown = qatomic_read(&qsp_sample_period);
+    return qsp_sample_countdown;
+}
+
 /*
  * @e is in the global hash table; it is only written to by the current thread,
  * so we write to it atomically (as in "write once") to prevent torn reads.
  */
-static inline void do_qsp_entry_record(QSPEntry *e, int64_t delta, bool acq)
+static inline void do_qsp_entry_record(QSPEntry *e, int64_t delta, bool acq,
+                                       unsigned int weight)
 {
-    qatomic_set(&e->ns, e->ns + delta);
+    qatomic_set(&e->ns, e->ns + delta * weight);
     if (acq) {
-        qatomic_set(&e->n_acqs, e->n_acqs + 1);
+        qatomic_set(&e->n_acqs, e->n_acqs + weight);
     }
 }
 
-static inline void qsp_entry_record(QSPEntry *e, int64_t delta)
+static inline void qsp_entry_record(QSPEntry *e, int64_t delta,
+                                    unsigned int weight)
 {
-    do_qsp_entry_record(e, delta, true);
+    do_qsp_entry_record(e, delta, true, weight);
 }
 
 #define QSP_GEN_VOID(type_, qsp_t_, func_, impl_)                       \
@@ -362,13 +387,19 @@ static inline void qsp_entry_record(QSPEntry *e, int64_t delta)
     {                                                                   \
         QSPEntry *e;                                                    \
         int64_t t0, t1;                                                 \
+        unsigned int weight = qsp_sample();                             \
+                                                                        \
+        if (!weight) {                                                  \
+            impl_(obj, file, line);                                     \
+            return;                                                     \
+        }                                                               \
                                                                         \
         t0 = get_clock();                                               \
         impl_(obj, file, line);                                         \
         t1 = get_clock();                                               \
                                                                         \
         e = qsp_entry_get(obj, file, line, qsp_t_);                     \
-        qsp_entry_record(e, t1 - t0);                                   \
+        qsp_entry_record(e, t1 - t0, weight);                           \
     }
 
 #define QSP_GEN_RET1(type_, qsp_t_, func_, impl_)                       \
@@ -377,13 +408,18 @@ static inline void qsp_entry_record(QSPEntry *e, int64_t delta)
         QSPEntry *e;                                                    \
         int64_t t0, t1;                                                 \
         int err;                                                        \
+        unsigned int weight = qsp_sample();                             \
+                                                                        \
+        if (!weight) {                                                  \
+            return impl_(obj, file, line);                              \
+        }                                                               \
                                                                         \
         t0 = get_clock();                                               \
         err = impl_(obj, file, line);                                   \
         t1 = get_clock();                                               \
                                                                         \
         e = qsp_entry_get(obj, file, line, qsp_t_);                     \
-        do_qsp_entry_record(e, t1 - t0, !err);                          \
+        do_qsp_entry_record(e, t1 - t0, !err, weight);                  \
         return err;                                                     \
     }
 
@@ -404,13 +440,19 @@ qsp_cond_wait(QemuCond *cond, QemuMutex *mutex, const char *file, int line)
 {
     QSPEntry *e;
     int64_t t0, t1;
+    unsigned int weight = qsp_sample();
+
+    if (!weight) {
+        qemu_cond_wait_impl(cond, mutex, file, line);
+        return;
+    }
 
     t0 = get_clock();
     qemu_cond_wait_impl(cond, mutex, file, line);
     t1 = get_clock();
 
     e = qsp_entry_get(cond, file, line, QSP_CONDVAR);
-    qsp_entry_record(e, t1 - t0);
+    qsp_entry_record(e, t1 - t0, weight);
 }
 
 static bool
@@ -420,13 +462,18 @@ qsp_cond_timedwait(QemuCond *cond, QemuMutex *mutex, int ms,
     QSPEntry *e;
     int64_t t0, t1;
     bool ret;
+    unsigned int weight = qsp_sample();
+
+    if (!weight) {
+        return qemu_cond_timedwait_impl(cond, mutex, ms, file, line);
+    }
 
     t0 = get_clock();
     ret = qemu_cond_timedwait_impl(cond, mutex, ms, file, line);
     t1 = get_clock();
 
     e = qsp_entry_get(cond, file, line, QSP_CONDVAR);
-    qsp_entry_record(e, t1 - t0);
+    qsp_entry_record(e, t1 - t0, weight);
     return ret;
 }
 
@@ -446,6 +493,16 @@ void qsp_enable(void)
     qatomic_set(&qemu_cond_timedwait_func, qsp_cond_timedwait);
 }
 
+void qsp_set_sample_period(unsigned int period)
+{
+    qatomic_set(&qsp_sample_period, MAX(period, 1));
+}
+
+unsigned int qsp_get_sample_period(void)
+{
+    return qatomic_read(&qsp_sample_period);
+}
+
 void qsp_disable(void)
 {
     qatomic_set(&qemu_mutex_lock_func, qemu_mutex_lock_impl);